@@ -0,0 +1,190 @@
+#include <ez/Bvh.h>
+#include <ez/Octree.h>
+#include <ez/Triangle.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+// Bvh vs Octree, build time and closest hit queries, on scenes with uneven primitive density (a dense cluster in a
+// large empty scene, a ground plane with a few detailed objects) and, for reference, on a uniform one.
+// Times are the best of a few runs, and the Bvh hits are checked against the Octree ones (distances within rounding,
+// as the SoA leaves of EZ_MATH_BVH_SOA_LEAVES may round differently).
+
+using namespace ez;
+
+namespace
+{
+constexpr std::size_t NumRuns = 3;
+constexpr float DistanceRelativeTolerance = 1e-5f;
+
+template <typename TFunction>
+double GetBestMilliseconds(const TFunction& inFunction)
+{
+  auto best_milliseconds = std::numeric_limits<double>::max();
+  for (std::size_t run = 0; run < NumRuns; ++run)
+  {
+    const auto begin = std::chrono::steady_clock::now();
+    inFunction();
+    const auto end = std::chrono::steady_clock::now();
+    best_milliseconds = std::min(best_milliseconds, std::chrono::duration<double, std::milli>(end - begin).count());
+  }
+  return best_milliseconds;
+}
+
+bool AreSameDistances(const float inLHS, const float inRHS)
+{
+  return std::abs(inLHS - inRHS) <= DistanceRelativeTolerance * std::max(std::abs(inLHS), std::abs(inRHS));
+}
+
+Vec3f GetRandomVec(std::uniform_real_distribution<float>& ioDistribution, std::mt19937& ioRandomEngine)
+{
+  return Vec3f { ioDistribution(ioRandomEngine), ioDistribution(ioRandomEngine), ioDistribution(ioRandomEngine) };
+}
+
+// inNumTriangles small triangles around random points of the ball of center inCenter and radius inRadius
+void AddTrianglesCluster(std::vector<Triangle3f>& ioTriangles,
+    const std::size_t inNumTriangles,
+    const Vec3f& inCenter,
+    const float inRadius,
+    const float inTriangleSize,
+    std::mt19937& ioRandomEngine)
+{
+  std::uniform_real_distribution<float> random_unit(-1.0f, 1.0f);
+  std::uniform_real_distribution<float> random_offset(-inTriangleSize, inTriangleSize);
+  for (std::size_t i = 0; i < inNumTriangles; ++i)
+  {
+    auto point = GetRandomVec(random_unit, ioRandomEngine);
+    while (SqLength(point) > 1.0f)
+      point = GetRandomVec(random_unit, ioRandomEngine);
+
+    const auto center = inCenter + point * inRadius;
+    ioTriangles.emplace_back(center + GetRandomVec(random_offset, ioRandomEngine),
+        center + GetRandomVec(random_offset, ioRandomEngine),
+        center + GetRandomVec(random_offset, ioRandomEngine));
+  }
+}
+
+// Rays from random points of a sphere of radius inRadius around the origin, towards random points of the ball of
+// center inTarget and radius inTargetRadius
+std::vector<Ray3f> MakeRaysTowards(const std::size_t inNumRays,
+    const float inRadius,
+    const Vec3f& inTarget,
+    const float inTargetRadius,
+    std::mt19937& ioRandomEngine)
+{
+  std::uniform_real_distribution<float> random_unit(-1.0f, 1.0f);
+  std::vector<Ray3f> rays;
+  rays.reserve(inNumRays);
+  for (std::size_t i = 0; i < inNumRays; ++i)
+  {
+    const auto origin = Normalized(GetRandomVec(random_unit, ioRandomEngine)) * inRadius;
+    const auto target = inTarget + GetRandomVec(random_unit, ioRandomEngine) * inTargetRadius;
+    rays.emplace_back(origin, Normalized(target - origin));
+  }
+  return rays;
+}
+
+void Benchmark(const std::string& inName, const std::vector<Triangle3f>& inTriangles, const std::vector<Ray3f>& inRays)
+{
+  using Intersection = Octree<Triangle3f>::Intersection;
+
+  std::optional<Octree<Triangle3f>> octree;
+  const auto octree_build_milliseconds
+      = GetBestMilliseconds([&]() { octree = OctreeBuilder<Triangle3f>::Build(MakeSpan(inTriangles)); });
+
+  std::optional<Bvh<Triangle3f>> bvh;
+  const auto bvh_build_milliseconds
+      = GetBestMilliseconds([&]() { bvh = BvhBuilder<Triangle3f>::Build(MakeSpan(inTriangles)); });
+
+  std::vector<std::optional<Intersection>> octree_intersections(inRays.size());
+  const auto octree_milliseconds = GetBestMilliseconds([&]() {
+    for (std::size_t i = 0; i < inRays.size(); ++i)
+      octree_intersections[i] = Intersect<EIntersectMode::ONLY_CLOSEST>(*octree, inRays[i]);
+  });
+
+  std::vector<std::optional<Intersection>> bvh_intersections(inRays.size());
+  const auto bvh_milliseconds = GetBestMilliseconds([&]() {
+    for (std::size_t i = 0; i < inRays.size(); ++i)
+      bvh_intersections[i] = Intersect<EIntersectMode::ONLY_CLOSEST>(*bvh, inRays[i]);
+  });
+
+  std::size_t num_hits = 0;
+  std::size_t num_mismatches = 0;
+  for (std::size_t i = 0; i < inRays.size(); ++i)
+  {
+    const auto& octree_intersection = octree_intersections[i];
+    const auto& bvh_intersection = bvh_intersections[i];
+    num_hits += octree_intersection.has_value();
+    if (octree_intersection.has_value() != bvh_intersection.has_value()
+        || (octree_intersection && !AreSameDistances(octree_intersection->mDistance, bvh_intersection->mDistance)))
+      ++num_mismatches;
+  }
+
+  std::cout << std::left << std::setw(36) << inName << " | triangles " << inTriangles.size() << ", rays "
+            << inRays.size() << ", hits " << num_hits << ", mismatches " << num_mismatches << std::endl
+            << std::fixed << std::setprecision(0) << "  build:   octree " << octree_build_milliseconds << " ms, bvh "
+            << bvh_build_milliseconds << " ms" << std::endl
+            << "  queries: octree " << octree_milliseconds << " ms, bvh " << bvh_milliseconds << " ms (x"
+            << std::setprecision(2) << (octree_milliseconds / bvh_milliseconds) << ")" << std::endl;
+}
+}
+
+int main()
+{
+  std::mt19937 random_engine { 14 };
+
+  // Dense cluster in a large empty scene: 200k small triangles in a ball of radius 1, and a few large triangles
+  // 1000 units away that make the scene bounds huge. The octree reaches its maximum depth with most of the cluster
+  // in a single leaf, hence the few rays.
+  {
+    std::vector<Triangle3f> triangles;
+    AddTrianglesCluster(triangles, 200000, Vec3f { 0.0f, 0.0f, 0.0f }, 1.0f, 0.02f, random_engine);
+    AddTrianglesCluster(triangles, 8, Vec3f { 0.0f, 0.0f, 0.0f }, 1000.0f, 5.0f, random_engine);
+    const auto rays = MakeRaysTowards(2000, 20.0f, Vec3f { 0.0f, 0.0f, 0.0f }, 1.0f, random_engine);
+    Benchmark("Dense cluster in a large scene", triangles, rays);
+  }
+
+  // Ground plane of 2 large triangles with 5 detailed objects of 40k small triangles each
+  {
+    std::vector<Triangle3f> triangles;
+    triangles.emplace_back(Vec3f { -500.0f, 0.0f, -500.0f },
+        Vec3f { 500.0f, 0.0f, -500.0f },
+        Vec3f { -500.0f, 0.0f, 500.0f });
+    triangles.emplace_back(Vec3f { 500.0f, 0.0f, -500.0f },
+        Vec3f { 500.0f, 0.0f, 500.0f },
+        Vec3f { -500.0f, 0.0f, 500.0f });
+    for (std::size_t i = 0; i < 5; ++i)
+    {
+      const auto center = Vec3f { static_cast<float>(i) * 40.0f - 80.0f, 2.0f, 0.0f };
+      AddTrianglesCluster(triangles, 40000, center, 2.0f, 0.05f, random_engine);
+    }
+    const auto rays = MakeRaysTowards(100000, 150.0f, Vec3f { 0.0f, 2.0f, 0.0f }, 90.0f, random_engine);
+    Benchmark("Ground plane with detailed objects", triangles, rays);
+  }
+
+  // Uniform reference: 200k small triangles in a 20 x 20 x 20 cube
+  {
+    std::vector<Triangle3f> triangles;
+    std::uniform_real_distribution<float> random_position(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> random_offset(-0.2f, 0.2f);
+    for (std::size_t i = 0; i < 200000; ++i)
+    {
+      const auto center = GetRandomVec(random_position, random_engine);
+      triangles.emplace_back(center + GetRandomVec(random_offset, random_engine),
+          center + GetRandomVec(random_offset, random_engine),
+          center + GetRandomVec(random_offset, random_engine));
+    }
+    const auto rays = MakeRaysTowards(100000, 30.0f, Vec3f { 0.0f, 0.0f, 0.0f }, 10.0f, random_engine);
+    Benchmark("Uniform (reference)", triangles, rays);
+  }
+
+  return 0;
+}
@@ -0,0 +1,111 @@
+#include <ez/FlatOctree.h>
+#include <ez/Octree.h>
+#include <ez/Triangle.h>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <random>
+#include <vector>
+
+// FlatOctree vs Octree on 1M triangles: build time (the FlatOctree is flattened from the built Octree) and closest hit
+// queries. Times are the best of a few runs, and the FlatOctree hits are checked against the Octree ones.
+
+using namespace ez;
+
+namespace
+{
+constexpr std::size_t NumRuns = 3;
+constexpr std::size_t NumTriangles = 1000000;
+constexpr std::size_t NumRays = 100000;
+
+template <typename TFunction>
+double GetBestMilliseconds(const TFunction& inFunction)
+{
+  auto best_milliseconds = std::numeric_limits<double>::max();
+  for (std::size_t run = 0; run < NumRuns; ++run)
+  {
+    const auto begin = std::chrono::steady_clock::now();
+    inFunction();
+    const auto end = std::chrono::steady_clock::now();
+    best_milliseconds = std::min(best_milliseconds, std::chrono::duration<double, std::milli>(end - begin).count());
+  }
+  return best_milliseconds;
+}
+
+Vec3f GetRandomVec(std::uniform_real_distribution<float>& ioDistribution, std::mt19937& ioRandomEngine)
+{
+  return Vec3f { ioDistribution(ioRandomEngine), ioDistribution(ioRandomEngine), ioDistribution(ioRandomEngine) };
+}
+}
+
+int main()
+{
+  using Intersection = Octree<Triangle3f>::Intersection;
+
+  // 1M small triangles in a 100 x 100 x 100 cube
+  std::mt19937 random_engine { 1 };
+  std::uniform_real_distribution<float> random_position(-50.0f, 50.0f);
+  std::uniform_real_distribution<float> random_offset(-0.5f, 0.5f);
+  std::vector<Triangle3f> triangles;
+  triangles.reserve(NumTriangles);
+  for (std::size_t i = 0; i < NumTriangles; ++i)
+  {
+    const auto center = GetRandomVec(random_position, random_engine);
+    triangles.emplace_back(center + GetRandomVec(random_offset, random_engine),
+        center + GetRandomVec(random_offset, random_engine),
+        center + GetRandomVec(random_offset, random_engine));
+  }
+
+  // Rays from random points of the cube towards random directions
+  std::uniform_real_distribution<float> random_unit(-1.0f, 1.0f);
+  std::vector<Ray3f> rays;
+  rays.reserve(NumRays);
+  for (std::size_t i = 0; i < NumRays; ++i)
+    rays.emplace_back(GetRandomVec(random_position, random_engine),
+        Normalized(GetRandomVec(random_unit, random_engine)));
+
+  std::optional<Octree<Triangle3f>> octree;
+  const auto octree_build_milliseconds
+      = GetBestMilliseconds([&]() { octree = OctreeBuilder<Triangle3f>::Build(MakeSpan(triangles)); });
+
+  std::optional<FlatOctree<Triangle3f>> flat_octree;
+  const auto flat_octree_build_milliseconds
+      = GetBestMilliseconds([&]() { flat_octree = FlatOctreeBuilder<Triangle3f>::Build(*octree); });
+
+  std::vector<std::optional<Intersection>> octree_intersections(rays.size());
+  const auto octree_milliseconds = GetBestMilliseconds([&]() {
+    for (std::size_t i = 0; i < rays.size(); ++i)
+      octree_intersections[i] = Intersect<EIntersectMode::ONLY_CLOSEST>(*octree, rays[i]);
+  });
+
+  std::vector<std::optional<Intersection>> flat_octree_intersections(rays.size());
+  const auto flat_octree_milliseconds = GetBestMilliseconds([&]() {
+    for (std::size_t i = 0; i < rays.size(); ++i)
+      flat_octree_intersections[i] = Intersect<EIntersectMode::ONLY_CLOSEST>(*flat_octree, rays[i]);
+  });
+
+  std::size_t num_hits = 0;
+  std::size_t num_mismatches = 0;
+  for (std::size_t i = 0; i < rays.size(); ++i)
+  {
+    const auto& octree_intersection = octree_intersections[i];
+    const auto& flat_octree_intersection = flat_octree_intersections[i];
+    num_hits += octree_intersection.has_value();
+    if (octree_intersection.has_value() != flat_octree_intersection.has_value()
+        || (octree_intersection && octree_intersection->mDistance != flat_octree_intersection->mDistance))
+      ++num_mismatches;
+  }
+
+  std::cout << "triangles " << triangles.size() << ", rays " << rays.size() << ", hits " << num_hits
+            << ", mismatches " << num_mismatches << std::endl
+            << std::fixed << std::setprecision(0) << "build:   octree " << octree_build_milliseconds
+            << " ms, flattening " << flat_octree_build_milliseconds << " ms" << std::endl
+            << "queries: octree " << octree_milliseconds << " ms, flat octree " << flat_octree_milliseconds
+            << " ms (x" << std::setprecision(2) << (octree_milliseconds / flat_octree_milliseconds) << ")"
+            << std::endl;
+  return 0;
+}
@@ -0,0 +1,112 @@
+#include <ez/Octree.h>
+#include <ez/Triangle.h>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <random>
+#include <vector>
+
+// Octree::AddPrimitive of primitives outside the root box, which grow it. Times the adds, checks that the octree
+// stays within its maximum depth, and checks closest hit queries against an octree built from scratch over the same
+// primitives. Exits with a failure status if the depth bound or the query results do not hold.
+
+using namespace ez;
+
+namespace
+{
+constexpr std::size_t NumRuns = 3;
+constexpr std::size_t NumTriangles = 100000;
+constexpr std::size_t NumFarTriangles = 400;
+constexpr std::size_t NumRays = 20000;
+constexpr std::size_t LeafNodesMaxCapacity = 8;
+constexpr std::size_t MaxDepth = 8;
+
+Vec3f GetRandomVec(std::uniform_real_distribution<float>& ioDistribution, std::mt19937& ioRandomEngine)
+{
+  return Vec3f { ioDistribution(ioRandomEngine), ioDistribution(ioRandomEngine), ioDistribution(ioRandomEngine) };
+}
+
+Triangle3f MakeRandomTriangle(const Vec3f& inCenter,
+    std::uniform_real_distribution<float>& ioRandomOffset,
+    std::mt19937& ioRandomEngine)
+{
+  return Triangle3f { inCenter + GetRandomVec(ioRandomOffset, ioRandomEngine),
+    inCenter + GetRandomVec(ioRandomOffset, ioRandomEngine),
+    inCenter + GetRandomVec(ioRandomOffset, ioRandomEngine) };
+}
+
+std::size_t GetDepth(const Octree<Triangle3f>& inOctree)
+{
+  return ComputeStats(inOctree).mNumNodesPerDepth.size() - 1;
+}
+}
+
+int main()
+{
+  // 100k small triangles in a 20 x 20 x 20 cube, then 400 triangles further and further away (up to 200 units)
+  std::mt19937 random_engine { 7 };
+  std::uniform_real_distribution<float> random_position(-10.0f, 10.0f);
+  std::uniform_real_distribution<float> random_offset(-0.2f, 0.2f);
+  std::uniform_real_distribution<float> random_unit(-1.0f, 1.0f);
+  std::vector<Triangle3f> triangles;
+  for (std::size_t i = 0; i < NumTriangles; ++i)
+    triangles.push_back(MakeRandomTriangle(GetRandomVec(random_position, random_engine), random_offset, random_engine));
+
+  std::vector<Triangle3f> far_triangles;
+  for (std::size_t i = 0; i < NumFarTriangles; ++i)
+  {
+    const auto distance = 20.0f + 180.0f * static_cast<float>(i + 1) / static_cast<float>(NumFarTriangles);
+    const auto center = Normalized(GetRandomVec(random_unit, random_engine)) * distance;
+    far_triangles.push_back(MakeRandomTriangle(center, random_offset, random_engine));
+  }
+
+  // Short rays through the cube, far from the precision issues of the large grown root box
+  std::vector<Ray3f> rays;
+  for (std::size_t i = 0; i < NumRays; ++i)
+  {
+    const auto origin = GetRandomVec(random_position, random_engine);
+    rays.emplace_back(origin, Normalized(GetRandomVec(random_unit, random_engine)));
+  }
+
+  std::optional<Octree<Triangle3f>> octree;
+  std::size_t depth_before_adds = 0;
+  auto best_adds_milliseconds = std::numeric_limits<double>::max();
+  for (std::size_t run = 0; run < NumRuns; ++run)
+  {
+    octree = OctreeBuilder<Triangle3f>::Build(MakeSpan(triangles), LeafNodesMaxCapacity, MaxDepth);
+    depth_before_adds = GetDepth(*octree);
+
+    const auto begin = std::chrono::steady_clock::now();
+    for (const auto& far_triangle : far_triangles) octree->AddPrimitive(far_triangle, LeafNodesMaxCapacity, MaxDepth);
+    const auto end = std::chrono::steady_clock::now();
+    best_adds_milliseconds
+        = std::min(best_adds_milliseconds, std::chrono::duration<double, std::milli>(end - begin).count());
+  }
+  const auto depth_after_adds = GetDepth(*octree);
+
+  const auto rebuilt_octree
+      = OctreeBuilder<Triangle3f>::Build(MakeSpan(octree->GetPrimitivesPool()), LeafNodesMaxCapacity, MaxDepth);
+
+  std::size_t num_hits = 0;
+  std::size_t num_mismatches = 0;
+  for (const auto& ray : rays)
+  {
+    const auto intersection = Intersect<EIntersectMode::ONLY_CLOSEST>(*octree, ray);
+    const auto rebuilt_intersection = Intersect<EIntersectMode::ONLY_CLOSEST>(rebuilt_octree, ray);
+    num_hits += intersection.has_value();
+    if (intersection.has_value() != rebuilt_intersection.has_value()
+        || (intersection && intersection->mDistance != rebuilt_intersection->mDistance))
+      ++num_mismatches;
+  }
+
+  std::cout << "triangles " << triangles.size() << " + " << far_triangles.size() << " far, max depth " << MaxDepth
+            << ", depth before " << depth_before_adds << ", after " << depth_after_adds << std::endl
+            << std::fixed << std::setprecision(1) << "adds:    " << best_adds_milliseconds << " ms" << std::endl
+            << "queries: rays " << rays.size() << ", hits " << num_hits << ", mismatches vs rebuilt "
+            << num_mismatches << std::endl;
+  return (depth_after_adds <= MaxDepth && num_mismatches == 0) ? 0 : 1;
+}
@@ -0,0 +1,193 @@
+#include <ez/HyperSphere.h>
+#include <ez/Octree.h>
+#include <ez/Triangle.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+// Octree closest hit queries, one ray at a time (Intersect(octree, ray)) vs packets (Intersect(octree, RayPacket)).
+// Every packet holds a tile of neighbour camera rays (coherent), or random rays (incoherent). Times are the best of
+// a few runs, and the packet results are checked against the scalar ones.
+
+using namespace ez;
+
+namespace
+{
+constexpr std::size_t NumRuns = 3;
+
+// Camera rays of a inResolution x inResolution image, in tiles of 4 x (TWidth / 4) pixels, one tile per packet
+template <std::size_t TWidth>
+std::vector<Ray3f> MakeCameraRays(const Vec3f& inEye,
+    const Vec3f& inCenterDirection,
+    const float inFieldOfViewSlope,
+    const std::size_t inResolution)
+{
+  static_assert(TWidth % 4 == 0);
+  constexpr std::size_t TileWidth = 4;
+  constexpr std::size_t TileHeight = TWidth / TileWidth;
+
+  std::vector<Ray3f> rays;
+  rays.reserve(inResolution * inResolution);
+  for (std::size_t tile_y = 0; tile_y < inResolution; tile_y += TileHeight)
+  {
+    for (std::size_t tile_x = 0; tile_x < inResolution; tile_x += TileWidth)
+    {
+      for (std::size_t y = tile_y; y < tile_y + TileHeight; ++y)
+      {
+        for (std::size_t x = tile_x; x < tile_x + TileWidth; ++x)
+        {
+          const auto u = ((static_cast<float>(x) + 0.5f) / static_cast<float>(inResolution)) * 2.0f - 1.0f;
+          const auto v = ((static_cast<float>(y) + 0.5f) / static_cast<float>(inResolution)) * 2.0f - 1.0f;
+          const auto direction = inCenterDirection + Vec3f { u, v, 0.0f } * inFieldOfViewSlope;
+          rays.emplace_back(inEye, Normalized(direction));
+        }
+      }
+    }
+  }
+  return rays;
+}
+
+std::vector<Ray3f> MakeRandomRays(const std::size_t inNumRays, const float inExtent, std::mt19937& ioRandomEngine)
+{
+  std::uniform_real_distribution<float> random(-1.0f, 1.0f);
+  std::vector<Ray3f> rays;
+  rays.reserve(inNumRays);
+  for (std::size_t i = 0; i < inNumRays; ++i)
+  {
+    const auto origin = Vec3f { random(ioRandomEngine), random(ioRandomEngine), random(ioRandomEngine) } * inExtent;
+    const auto direction = Vec3f { random(ioRandomEngine), random(ioRandomEngine), random(ioRandomEngine) };
+    rays.emplace_back(origin, Normalized(direction));
+  }
+  return rays;
+}
+
+template <typename TFunction>
+double GetBestMilliseconds(const TFunction& inFunction)
+{
+  auto best_milliseconds = std::numeric_limits<double>::max();
+  for (std::size_t run = 0; run < NumRuns; ++run)
+  {
+    const auto begin = std::chrono::steady_clock::now();
+    inFunction();
+    const auto end = std::chrono::steady_clock::now();
+    best_milliseconds = std::min(best_milliseconds, std::chrono::duration<double, std::milli>(end - begin).count());
+  }
+  return best_milliseconds;
+}
+
+template <std::size_t TWidth, typename TPrimitive>
+void Benchmark(const std::string& inName, const Octree<TPrimitive>& inOctree, const std::vector<Ray3f>& inRays)
+{
+  using Intersection = typename Octree<TPrimitive>::Intersection;
+
+  std::vector<std::optional<Intersection>> scalar_intersections(inRays.size());
+  const auto scalar_milliseconds = GetBestMilliseconds([&]() {
+    for (std::size_t i = 0; i < inRays.size(); ++i)
+      scalar_intersections[i] = Intersect<EIntersectMode::ONLY_CLOSEST>(inOctree, inRays[i]);
+  });
+
+  std::vector<std::optional<Intersection>> packet_intersections(inRays.size());
+  const auto packet_milliseconds = GetBestMilliseconds([&]() {
+    for (std::size_t i = 0; i < inRays.size(); i += TWidth)
+    {
+      const auto num_rays = std::min(TWidth, inRays.size() - i);
+      const auto ray_packet = RayPacket<float, TWidth> { Span<Ray3f> { inRays.data() + i, num_rays } };
+      const auto intersections = Intersect<EIntersectMode::ONLY_CLOSEST>(inOctree, ray_packet);
+      std::copy_n(intersections.cbegin(), num_rays, packet_intersections.begin() + i);
+    }
+  });
+
+  std::size_t num_hits = 0;
+  std::size_t num_mismatches = 0;
+  for (std::size_t i = 0; i < inRays.size(); ++i)
+  {
+    const auto& scalar_intersection = scalar_intersections[i];
+    const auto& packet_intersection = packet_intersections[i];
+    num_hits += scalar_intersection.has_value();
+    if (scalar_intersection.has_value() != packet_intersection.has_value()
+        || (scalar_intersection && scalar_intersection->mDistance != packet_intersection->mDistance))
+      ++num_mismatches;
+  }
+
+  std::cout << std::left << std::setw(40) << inName << " width " << std::setw(2) << TWidth << " | rays "
+            << inRays.size() << ", hits " << num_hits << ", mismatches " << num_mismatches << " | scalar "
+            << std::fixed << std::setprecision(0) << scalar_milliseconds << " ms, packet " << packet_milliseconds
+            << " ms (x" << std::setprecision(2) << (scalar_milliseconds / packet_milliseconds) << ")" << std::endl;
+}
+}
+
+int main()
+{
+  std::mt19937 random_engine { 4 };
+
+  // Heightfield of 2 x 300 x 300 triangles, seen from above at an angle
+  {
+    constexpr std::size_t GridSize = 300;
+    const auto get_point = [](const std::size_t inX, const std::size_t inY) {
+      const auto x = static_cast<float>(inX);
+      const auto y = static_cast<float>(inY);
+      const auto height = 2.0f * std::sin(x * 0.07f) * std::cos(y * 0.05f) + 0.5f * std::sin(x * 0.31f + y * 0.17f);
+      return Vec3f { x * 0.1f - 15.0f, height, y * 0.1f - 15.0f };
+    };
+
+    std::vector<Triangle3f> triangles;
+    for (std::size_t y = 0; y < GridSize; ++y)
+    {
+      for (std::size_t x = 0; x < GridSize; ++x)
+      {
+        triangles.emplace_back(get_point(x, y), get_point(x + 1, y), get_point(x, y + 1));
+        triangles.emplace_back(get_point(x + 1, y), get_point(x + 1, y + 1), get_point(x, y + 1));
+      }
+    }
+
+    const auto octree = OctreeBuilder<Triangle3f>::Build(MakeSpan(triangles));
+    const auto eye = Vec3f { 0.0f, 12.0f, -25.0f };
+    const auto center_direction = Vec3f { 0.0f, -0.45f, 1.0f };
+    Benchmark<4>("Heightfield triangles, camera", octree, MakeCameraRays<4>(eye, center_direction, 0.6f, 1024));
+    Benchmark<8>("Heightfield triangles, camera", octree, MakeCameraRays<8>(eye, center_direction, 0.6f, 1024));
+    Benchmark<16>("Heightfield triangles, camera", octree, MakeCameraRays<16>(eye, center_direction, 0.6f, 1024));
+  }
+
+  // 200k random small spheres and triangles in a 20 x 20 x 20 cube
+  {
+    constexpr std::size_t NumPrimitives = 200000;
+    std::uniform_real_distribution<float> random_position(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> random_radius(0.05f, 0.3f);
+    std::uniform_real_distribution<float> random_offset(-0.4f, 0.4f);
+    const auto get_random_vec = [&](auto& ioDistribution) {
+      return Vec3f { ioDistribution(random_engine), ioDistribution(random_engine), ioDistribution(random_engine) };
+    };
+
+    std::vector<Spheref> spheres;
+    std::vector<Triangle3f> triangles;
+    for (std::size_t i = 0; i < NumPrimitives; ++i)
+    {
+      const auto center = get_random_vec(random_position);
+      spheres.emplace_back(center, random_radius(random_engine));
+      triangles.emplace_back(center + get_random_vec(random_offset),
+          center + get_random_vec(random_offset),
+          center + get_random_vec(random_offset));
+    }
+
+    const auto spheres_octree = OctreeBuilder<Spheref>::Build(MakeSpan(spheres));
+    const auto triangles_octree = OctreeBuilder<Triangle3f>::Build(MakeSpan(triangles));
+    const auto eye = Vec3f { 0.0f, 0.0f, -30.0f };
+    const auto center_direction = Vec3f { 0.0f, 0.0f, 1.0f };
+    const auto camera_rays = MakeCameraRays<8>(eye, center_direction, 0.5f, 512);
+    const auto random_rays = MakeRandomRays(camera_rays.size(), 12.0f, random_engine);
+    Benchmark<8>("Random spheres, camera", spheres_octree, camera_rays);
+    Benchmark<8>("Random triangles, camera", triangles_octree, camera_rays);
+    Benchmark<8>("Random spheres, random rays", spheres_octree, random_rays);
+    Benchmark<8>("Random triangles, random rays", triangles_octree, random_rays);
+  }
+
+  return 0;
+}
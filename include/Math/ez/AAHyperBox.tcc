@@ -462,7 +462,7 @@ constexpr auto BoundingAAHyperBox(const T& inThingToBound)
     }
     else
     {
-      for (const auto subthing_to_bound : inThingToBound)
+      for (const auto& subthing_to_bound : inThingToBound)
       { bounding_aa_hyper_box.Wrap(BoundingAAHyperBox(subthing_to_bound)); }
     }
     return bounding_aa_hyper_box;
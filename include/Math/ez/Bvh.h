@@ -0,0 +1,136 @@
+#pragma once
+
+#include <ez/AAHyperBox.h>
+#include <ez/HierarchyCommon.h>
+#include <ez/IntersectMode.h>
+#include <ez/MathTypeTraits.h>
+#include <ez/ParallelPolicy.h>
+#include <ez/PrimitivesSoA.h>
+#include <ez/Span.h>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// Opt-in (EZ_MATH_BVH_SOA_LEAVES=1, or the EZMATH_BVH_SOA_LEAVES CMake option) SoA leaves, see Bvh::PrimitivesBlock
+#ifndef EZ_MATH_BVH_SOA_LEAVES
+#define EZ_MATH_BVH_SOA_LEAVES 0
+#endif
+
+namespace ez
+{
+
+template <typename TPrimitive>
+class BvhBuilder;
+
+// Bounding volume hierarchy, an alternative to Octree for scenes with very uneven primitive density.
+// Nodes are binary and their boxes tightly bound their primitives, so empty space costs nothing. All nodes live in a
+// single array in depth-first order: the first child of an internal node is the next node in the array.
+// It has the same Intersection type and Intersect interface as Octree, so both can be used interchangeably.
+template <typename TPrimitive>
+class Bvh final
+{
+public:
+  using ValueType = ValueType_t<TPrimitive>;
+  using AABoxType = AABox<ValueType>;
+  using PrimitiveIndex = HierarchyPrimitiveIndex;
+  using Intersection = HierarchyIntersection<ValueType>;
+  using NodeIndex = uint32_t;
+
+  // With EZ_MATH_BVH_SOA_LEAVES, primitives with a SoA type (see PrimitivesSoA) are also stored in blocks, in the
+  // order of the primitives indices: lane j of block b holds the primitive of
+  // mPrimitivesIndices[b * PrimitivesBlockWidth + j]. Closest and check queries then test a whole leaf range against
+  // them at once, with the scalar leaves results within rounding. Off by default, as it was not measurably faster.
+  static constexpr std::size_t PrimitivesBlockWidth = 4;
+  using PrimitivesBlock = PrimitivesSoA_t<TPrimitive, PrimitivesBlockWidth>;
+  static constexpr bool UsesPrimitivesBlocks = (EZ_MATH_BVH_SOA_LEAVES && HasPrimitivesSoA_v<TPrimitive>);
+
+  struct Node final
+  {
+    AABoxType mAABox;
+    NodeIndex mIndex = 0;         // Leaf: first of its primitives indices. Internal: index of the second child.
+    NodeIndex mNumPrimitives = 0; // 0 for internal nodes
+
+    bool IsLeaf() const { return mNumPrimitives != 0; }
+  };
+
+  Bvh() = default;
+  Bvh(const Span<TPrimitive>& inPrimitives, const std::size_t inLeafNodesMaxCapacity = 4);
+  Bvh(const Bvh&) = delete;
+  Bvh& operator=(const Bvh&) = delete;
+  Bvh(Bvh&&) = default;
+  Bvh& operator=(Bvh&&) = default;
+
+  // Replaces the primitives keeping the hierarchy topology, and refits the node boxes bottom-up, in O(n). Meant for
+  // deforming primitives (same count and order as the ones the Bvh was built from). The more they move, the more the
+  // hierarchy quality degrades, see ComputeSAHCost and Optimize.
+  void Refit(const Span<TPrimitive>& inPrimitives);
+  void Refit(const Span<TPrimitive>& inPrimitives, const ParallelPolicy& inParallelPolicy);
+
+  // Improves the hierarchy with tree rotations (Kensler), that swap a child with a grandchild when it reduces the
+  // children surface area. One bottom-up pass per call, in O(n).
+  void Optimize();
+
+  // Expected cost of a random ray query (Surface Area Heuristic), relative to the root surface area
+  ValueType ComputeSAHCost() const;
+
+  const AABoxType& GetAABox() const;
+  const std::vector<TPrimitive>& GetPrimitivesPool() const { return mPrimitivesPool; }
+  const std::vector<PrimitiveIndex>& GetPrimitivesIndices() const { return mPrimitivesIndices; }
+  const std::vector<Node>& GetNodes() const { return mNodes; }
+  const std::vector<PrimitivesBlock>& GetPrimitivesBlocks() const { return mPrimitivesBlocks; }
+  bool IsEmpty() const { return mNodes.empty(); }
+
+private:
+  std::vector<Node> mNodes;                         // Root is at index 0
+  std::vector<PrimitiveIndex> mPrimitivesIndices;   // Reordered so that every leaf has a contiguous range
+  std::vector<TPrimitive> mPrimitivesPool;
+  std::vector<PrimitivesBlock> mPrimitivesBlocks;   // Only filled if UsesPrimitivesBlocks
+
+  void RefitNodes(const ParallelPolicy& inParallelPolicy);
+  void UpdatePrimitivesBlocks();
+
+  friend class BvhBuilder<TPrimitive>;
+};
+
+template <typename TPrimitive>
+class BvhBuilder final
+{
+public:
+  BvhBuilder() = delete;
+
+  // Top-down build with the binned Surface Area Heuristic: every node is split where the expected cost of a random ray
+  // (children traversal + primitive tests, weighted by their surface area) is the lowest, among inNumBins candidate
+  // planes per axis. Nodes with at most inLeafNodesMaxCapacity primitives become leaves if splitting does not pay off.
+  static Bvh<TPrimitive> Build(const Span<TPrimitive>& inPrimitives,
+      const std::size_t inLeafNodesMaxCapacity = 4,
+      const std::size_t inNumBins = 16);
+
+private:
+  using ValueType = ValueType_t<TPrimitive>;
+  using AABoxType = AABox<ValueType>;
+  using NodeIndex = typename Bvh<TPrimitive>::NodeIndex;
+
+  static void BuildRecursive(Bvh<TPrimitive>& ioBvh,
+      const NodeIndex inNodeIndex,
+      const std::size_t inPrimitivesIndicesBegin,
+      const std::size_t inPrimitivesIndicesEnd,
+      const std::vector<AABoxType>& inPrimitivesAABoxes,
+      const std::vector<Vec3<ValueType>>& inPrimitivesCenters,
+      const std::size_t inLeafNodesMaxCapacity,
+      const std::size_t inNumBins);
+};
+
+// Intersection functions
+template <EIntersectMode TIntersectMode, typename TPrimitive>
+auto Intersect(const Bvh<TPrimitive>& inBvh,
+    const Ray3<ValueType_t<TPrimitive>>& inRay,
+    const ValueType_t<TPrimitive> inMaxDistance = Infinity<ValueType_t<TPrimitive>>());
+
+template <EIntersectMode TIntersectMode, typename TPrimitive>
+auto Intersect(const Ray3<ValueType_t<TPrimitive>>& inRay,
+    const Bvh<TPrimitive>& inBvh,
+    const ValueType_t<TPrimitive> inMaxDistance = Infinity<ValueType_t<TPrimitive>>());
+}
+
+#include "ez/Bvh.tcc"
\ No newline at end of file
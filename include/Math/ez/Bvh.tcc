@@ -0,0 +1,498 @@
+#include <ez/Bvh.h>
+#include <ez/HierarchyCommon.h>
+#include <ez/Macros.h>
+#include <ez/PrecomputedRay.h>
+#include <ez/Ray.h>
+#include <ez/RayQueryHelper.h>
+#include <algorithm>
+#include <array>
+#include <numeric>
+
+namespace ez
+{
+
+namespace bvh_detail
+{
+  // Relative costs of traversing a node and of testing a primitive, for the Surface Area Heuristic
+  template <typename T>
+  constexpr auto TraversalCost = static_cast<T>(1);
+  template <typename T>
+  constexpr auto IntersectionCost = static_cast<T>(1);
+
+  // Lanes of the block starting at inBlockBegin that are in the leaf range [inLeafBegin, inLeafEnd)
+  template <std::size_t TBlockWidth>
+  SoALaneMask
+  GetLeafLanesMask(const std::size_t inBlockBegin, const std::size_t inLeafBegin, const std::size_t inLeafEnd)
+  {
+    const auto first_lane = (Max(inLeafBegin, inBlockBegin) - inBlockBegin);
+    const auto end_lane = (Min(inLeafEnd, inBlockBegin + TBlockWidth) - inBlockBegin);
+    const auto lanes_below_end = (static_cast<SoALaneMask>((static_cast<uint64_t>(1) << end_lane) - 1));
+    const auto lanes_below_first = (static_cast<SoALaneMask>((static_cast<uint64_t>(1) << first_lane) - 1));
+    return (lanes_below_end & ~lanes_below_first);
+  }
+}
+
+template <typename TPrimitive>
+Bvh<TPrimitive>::Bvh(const Span<TPrimitive>& inPrimitives, const std::size_t inLeafNodesMaxCapacity)
+{
+  *this = BvhBuilder<TPrimitive>::Build(inPrimitives, inLeafNodesMaxCapacity);
+}
+
+template <typename TPrimitive>
+const typename Bvh<TPrimitive>::AABoxType& Bvh<TPrimitive>::GetAABox() const
+{
+  EXPECTS(!IsEmpty());
+  return mNodes.front().mAABox;
+}
+
+template <typename TPrimitive>
+void Bvh<TPrimitive>::Refit(const Span<TPrimitive>& inPrimitives)
+{
+  Refit(inPrimitives, ParallelPolicy { 1 });
+}
+
+template <typename TPrimitive>
+void Bvh<TPrimitive>::Refit(const Span<TPrimitive>& inPrimitives, const ParallelPolicy& inParallelPolicy)
+{
+  EXPECTS(inPrimitives.GetNumberOfElements() == mPrimitivesPool.size());
+  std::copy(inPrimitives.cbegin(), inPrimitives.cend(), mPrimitivesPool.begin());
+  RefitNodes(inParallelPolicy);
+  UpdatePrimitivesBlocks();
+}
+
+template <typename TPrimitive>
+void Bvh<TPrimitive>::UpdatePrimitivesBlocks()
+{
+  if constexpr (UsesPrimitivesBlocks)
+  {
+    mPrimitivesBlocks.assign((mPrimitivesIndices.size() + PrimitivesBlockWidth - 1) / PrimitivesBlockWidth, {});
+    for (std::size_t i = 0; i < mPrimitivesIndices.size(); ++i)
+    {
+      mPrimitivesBlocks[i / PrimitivesBlockWidth].SetPrimitive(i % PrimitivesBlockWidth,
+          mPrimitivesPool[mPrimitivesIndices[i]]);
+    }
+  }
+}
+
+template <typename TPrimitive>
+void Bvh<TPrimitive>::RefitNodes(const ParallelPolicy& inParallelPolicy)
+{
+  // Leaves are independent, and bounding their primitives is most of the work, so do them in parallel
+  ParallelFor(
+      inParallelPolicy,
+      mNodes.size(),
+      [&](const std::size_t inNodeIndex, const std::size_t) {
+        auto& node = mNodes[inNodeIndex];
+        if (!node.IsLeaf())
+          return;
+
+        auto leaf_aabox = hierarchy_detail::MakeEmptyAABox<ValueType>();
+        for (auto i = node.mIndex; i < node.mIndex + node.mNumPrimitives; ++i)
+        {
+          const auto& primitive = mPrimitivesPool[mPrimitivesIndices[i]];
+          leaf_aabox = hierarchy_detail::MakeUnion(leaf_aabox, BoundingAAHyperBox(primitive));
+        }
+        node.mAABox = leaf_aabox;
+      },
+      64);
+
+  // Children always come after their parent in the nodes array, so going backwards refits them before their parent
+  for (auto node_index = mNodes.size(); node_index-- > 0;)
+  {
+    auto& node = mNodes[node_index];
+    if (!node.IsLeaf())
+      node.mAABox = hierarchy_detail::MakeUnion(mNodes[node_index + 1].mAABox, mNodes[node.mIndex].mAABox);
+  }
+}
+
+template <typename TPrimitive>
+void Bvh<TPrimitive>::Optimize()
+{
+  using hierarchy_detail::HalfSurfaceArea;
+  using hierarchy_detail::MakeUnion;
+
+  if (IsEmpty())
+    return;
+
+  // Rotations move subtrees around, so work with explicit children indices and lay the nodes out again afterwards
+  std::vector<std::array<NodeIndex, 2>> nodes_children(mNodes.size());
+  for (std::size_t node_index = 0; node_index < mNodes.size(); ++node_index)
+  {
+    if (!mNodes[node_index].IsLeaf())
+      nodes_children[node_index] = { static_cast<NodeIndex>(node_index + 1), mNodes[node_index].mIndex };
+  }
+
+  // Bottom-up (children come after their parent), so that the grandchildren are already optimized
+  for (auto node_index = mNodes.size(); node_index-- > 0;)
+  {
+    if (mNodes[node_index].IsLeaf())
+      continue;
+
+    // Rotation swapping the child mChildSide with the grandchild mGrandChildSide, below the other child
+    struct Rotation final
+    {
+      std::size_t mChildSide = 0;
+      std::size_t mGrandChildSide = 0;
+      ValueType mHalfSurfaceAreaReduction = static_cast<ValueType>(0);
+    };
+
+    auto& children = nodes_children[node_index];
+    std::optional<Rotation> best_rotation;
+    for (std::size_t child_side = 0; child_side < 2; ++child_side)
+    {
+      const auto other_child_index = children[1 - child_side];
+      const auto& other_child = mNodes[other_child_index];
+      if (other_child.IsLeaf())
+        continue;
+
+      // The node box does not change, only the box of the other child, which gets this child instead of a grandchild
+      const auto& grandchildren = nodes_children[other_child_index];
+      const auto other_child_half_surface_area = HalfSurfaceArea(other_child.mAABox);
+      for (std::size_t grandchild_side = 0; grandchild_side < 2; ++grandchild_side)
+      {
+        const auto rotated_other_child_aabox
+            = MakeUnion(mNodes[children[child_side]].mAABox, mNodes[grandchildren[1 - grandchild_side]].mAABox);
+        const auto reduction = (other_child_half_surface_area - HalfSurfaceArea(rotated_other_child_aabox));
+        if (reduction > (best_rotation ? best_rotation->mHalfSurfaceAreaReduction : static_cast<ValueType>(0)))
+          best_rotation = Rotation { child_side, grandchild_side, reduction };
+      }
+    }
+
+    if (!best_rotation)
+      continue;
+
+    const auto other_child_index = children[1 - best_rotation->mChildSide];
+    auto& grandchildren = nodes_children[other_child_index];
+    std::swap(children[best_rotation->mChildSide], grandchildren[best_rotation->mGrandChildSide]);
+    mNodes[other_child_index].mAABox = MakeUnion(mNodes[grandchildren[0]].mAABox, mNodes[grandchildren[1]].mAABox);
+  }
+
+  // Lay the nodes out depth-first again, so that the first child of every internal node is the next node
+  std::vector<Node> laid_out_nodes;
+  laid_out_nodes.reserve(mNodes.size());
+  std::vector<std::pair<NodeIndex, std::optional<NodeIndex>>> nodes_to_lay_out; // With their parent, if second child
+  nodes_to_lay_out.emplace_back(0, std::nullopt);
+  while (!nodes_to_lay_out.empty())
+  {
+    const auto [node_index, parent_laid_out_index] = nodes_to_lay_out.back();
+    nodes_to_lay_out.pop_back();
+
+    const auto laid_out_index = static_cast<NodeIndex>(laid_out_nodes.size());
+    laid_out_nodes.push_back(mNodes[node_index]);
+    if (parent_laid_out_index)
+      laid_out_nodes[*parent_laid_out_index].mIndex = laid_out_index;
+
+    if (!mNodes[node_index].IsLeaf())
+    {
+      nodes_to_lay_out.emplace_back(nodes_children[node_index][1], laid_out_index);
+      nodes_to_lay_out.emplace_back(nodes_children[node_index][0], std::nullopt);
+    }
+  }
+  mNodes = std::move(laid_out_nodes);
+}
+
+template <typename TPrimitive>
+typename Bvh<TPrimitive>::ValueType Bvh<TPrimitive>::ComputeSAHCost() const
+{
+  using hierarchy_detail::HalfSurfaceArea;
+
+  if (IsEmpty())
+    return static_cast<ValueType>(0);
+
+  auto sah_cost = static_cast<ValueType>(0);
+  for (const auto& node : mNodes)
+  {
+    const auto node_half_surface_area = HalfSurfaceArea(node.mAABox);
+    sah_cost += node.IsLeaf() ? (node_half_surface_area * bvh_detail::IntersectionCost<ValueType>
+                                    * static_cast<ValueType>(node.mNumPrimitives))
+                              : (node_half_surface_area * bvh_detail::TraversalCost<ValueType>);
+  }
+
+  const auto root_half_surface_area = HalfSurfaceArea(GetAABox());
+  return (root_half_surface_area > static_cast<ValueType>(0)) ? (sah_cost / root_half_surface_area) : sah_cost;
+}
+
+template <typename TPrimitive>
+Bvh<TPrimitive> BvhBuilder<TPrimitive>::Build(const Span<TPrimitive>& inPrimitives,
+    const std::size_t inLeafNodesMaxCapacity,
+    const std::size_t inNumBins)
+{
+  EXPECTS(inLeafNodesMaxCapacity >= 1);
+  EXPECTS(inNumBins >= 2);
+
+  Bvh<TPrimitive> bvh;
+  bvh.mPrimitivesPool.assign(inPrimitives.cbegin(), inPrimitives.cend());
+  if (bvh.mPrimitivesPool.empty())
+    return bvh;
+
+  EXPECTS(bvh.mPrimitivesPool.size() <= Max<NodeIndex>());
+
+  std::vector<AABoxType> primitives_aaboxes;
+  std::vector<Vec3<ValueType>> primitives_centers;
+  primitives_aaboxes.reserve(bvh.mPrimitivesPool.size());
+  primitives_centers.reserve(bvh.mPrimitivesPool.size());
+  for (const auto& primitive : bvh.mPrimitivesPool)
+  {
+    primitives_aaboxes.push_back(BoundingAAHyperBox(primitive));
+    primitives_centers.push_back(primitives_aaboxes.back().GetCenter());
+  }
+
+  bvh.mPrimitivesIndices.resize(bvh.mPrimitivesPool.size());
+  std::iota(bvh.mPrimitivesIndices.begin(), bvh.mPrimitivesIndices.end(), 0);
+
+  bvh.mNodes.reserve(2 * bvh.mPrimitivesPool.size() - 1); // Upper bound for a binary tree
+  bvh.mNodes.emplace_back();
+  BuildRecursive(bvh,
+      0,
+      0,
+      bvh.mPrimitivesIndices.size(),
+      primitives_aaboxes,
+      primitives_centers,
+      inLeafNodesMaxCapacity,
+      inNumBins);
+  bvh.mNodes.shrink_to_fit();
+  bvh.UpdatePrimitivesBlocks();
+  return bvh;
+}
+
+template <typename TPrimitive>
+void BvhBuilder<TPrimitive>::BuildRecursive(Bvh<TPrimitive>& ioBvh,
+    const NodeIndex inNodeIndex,
+    const std::size_t inPrimitivesIndicesBegin,
+    const std::size_t inPrimitivesIndicesEnd,
+    const std::vector<AABoxType>& inPrimitivesAABoxes,
+    const std::vector<Vec3<ValueType>>& inPrimitivesCenters,
+    const std::size_t inLeafNodesMaxCapacity,
+    const std::size_t inNumBins)
+{
+  using hierarchy_detail::HalfSurfaceArea;
+  using hierarchy_detail::MakeEmptyAABox;
+  using hierarchy_detail::MakeUnion;
+  constexpr auto TraversalCost = bvh_detail::TraversalCost<ValueType>;
+  constexpr auto IntersectionCost = bvh_detail::IntersectionCost<ValueType>;
+
+  const auto primitives_indices_begin = ioBvh.mPrimitivesIndices.begin() + inPrimitivesIndicesBegin;
+  const auto primitives_indices_end = ioBvh.mPrimitivesIndices.begin() + inPrimitivesIndicesEnd;
+  const auto num_primitives = (inPrimitivesIndicesEnd - inPrimitivesIndicesBegin);
+
+  auto aabox = MakeEmptyAABox<ValueType>();
+  auto centers_aabox = MakeEmptyAABox<ValueType>();
+  for (auto it = primitives_indices_begin; it != primitives_indices_end; ++it)
+  {
+    aabox = MakeUnion(aabox, inPrimitivesAABoxes[*it]);
+    centers_aabox = MakeUnion(centers_aabox, AABoxType(inPrimitivesCenters[*it], inPrimitivesCenters[*it]));
+  }
+  ioBvh.mNodes[inNodeIndex].mAABox = aabox;
+
+  const auto make_leaf = [&]() {
+    auto& leaf_node = ioBvh.mNodes[inNodeIndex];
+    leaf_node.mIndex = static_cast<NodeIndex>(inPrimitivesIndicesBegin);
+    leaf_node.mNumPrimitives = static_cast<NodeIndex>(num_primitives);
+  };
+
+  if (num_primitives <= 1)
+  {
+    make_leaf();
+    return;
+  }
+
+  // Bin the primitives by their center along each axis, and evaluate the SAH cost of splitting between every two bins
+  struct Bin final
+  {
+    AABoxType mAABox = hierarchy_detail::MakeEmptyAABox<ValueType>();
+    std::size_t mNumPrimitives = 0;
+  };
+
+  const auto centers_aabox_size = centers_aabox.GetSize();
+  const auto get_bin_index = [&](const Vec3<ValueType>& inCenter, const std::size_t inAxis) {
+    const auto relative_position = (inCenter[inAxis] - centers_aabox.GetMin()[inAxis]) / centers_aabox_size[inAxis];
+    const auto bin_index = static_cast<std::size_t>(relative_position * static_cast<ValueType>(inNumBins));
+    return std::min(bin_index, inNumBins - 1);
+  };
+
+  auto best_split_cost = Infinity<ValueType>();
+  std::size_t best_split_axis = 0;
+  std::size_t best_split_bin_index = 0; // Bins [0, best_split_bin_index] go to the first child
+  std::vector<Bin> bins(inNumBins);
+  std::vector<ValueType> first_child_costs(inNumBins);
+  for (std::size_t axis = 0; axis < 3; ++axis)
+  {
+    if (centers_aabox_size[axis] <= static_cast<ValueType>(0))
+      continue;
+
+    std::fill(bins.begin(), bins.end(), Bin {});
+    for (auto it = primitives_indices_begin; it != primitives_indices_end; ++it)
+    {
+      auto& bin = bins[get_bin_index(inPrimitivesCenters[*it], axis)];
+      bin.mAABox = MakeUnion(bin.mAABox, inPrimitivesAABoxes[*it]);
+      ++bin.mNumPrimitives;
+    }
+
+    auto first_child_aabox = MakeEmptyAABox<ValueType>();
+    std::size_t first_child_num_primitives = 0;
+    for (std::size_t i = 0; i + 1 < inNumBins; ++i)
+    {
+      first_child_aabox = MakeUnion(first_child_aabox, bins[i].mAABox);
+      first_child_num_primitives += bins[i].mNumPrimitives;
+      first_child_costs[i] = (first_child_num_primitives == 0)
+          ? static_cast<ValueType>(0)
+          : HalfSurfaceArea(first_child_aabox) * static_cast<ValueType>(first_child_num_primitives);
+    }
+
+    auto second_child_aabox = MakeEmptyAABox<ValueType>();
+    std::size_t second_child_num_primitives = 0;
+    for (std::size_t i = inNumBins - 1; i > 0; --i)
+    {
+      second_child_aabox = MakeUnion(second_child_aabox, bins[i].mAABox);
+      second_child_num_primitives += bins[i].mNumPrimitives;
+      if (second_child_num_primitives == 0 || second_child_num_primitives == num_primitives)
+        continue; // One of the children would be empty
+
+      const auto split_cost = first_child_costs[i - 1]
+          + HalfSurfaceArea(second_child_aabox) * static_cast<ValueType>(second_child_num_primitives);
+      if (split_cost < best_split_cost)
+      {
+        best_split_cost = split_cost;
+        best_split_axis = axis;
+        best_split_bin_index = i - 1;
+      }
+    }
+  }
+
+  auto primitives_indices_middle = primitives_indices_begin;
+  if (best_split_cost == Infinity<ValueType>())
+  {
+    // All the centers are in the same bin (e.g. coincident primitives), no spatial split helps
+    if (num_primitives <= inLeafNodesMaxCapacity)
+    {
+      make_leaf();
+      return;
+    }
+    primitives_indices_middle = primitives_indices_begin + static_cast<std::ptrdiff_t>(num_primitives / 2);
+  }
+  else
+  {
+    const auto leaf_cost = IntersectionCost * static_cast<ValueType>(num_primitives);
+    const auto aabox_half_surface_area = HalfSurfaceArea(aabox);
+    const auto node_split_cost = TraversalCost
+        + IntersectionCost * best_split_cost
+            / (aabox_half_surface_area > static_cast<ValueType>(0) ? aabox_half_surface_area
+                                                                   : static_cast<ValueType>(1));
+    if (num_primitives <= inLeafNodesMaxCapacity && leaf_cost <= node_split_cost)
+    {
+      make_leaf();
+      return;
+    }
+
+    primitives_indices_middle = std::partition(primitives_indices_begin,
+        primitives_indices_end,
+        [&](const auto& inPrimitiveIndex) {
+          return get_bin_index(inPrimitivesCenters[inPrimitiveIndex], best_split_axis) <= best_split_bin_index;
+        });
+  }
+
+  // First child goes right after its parent, the second one after the whole first child subtree
+  const auto primitives_indices_middle_index
+      = inPrimitivesIndicesBegin + static_cast<std::size_t>(primitives_indices_middle - primitives_indices_begin);
+  const auto first_child_index = static_cast<NodeIndex>(ioBvh.mNodes.size());
+  ioBvh.mNodes.emplace_back();
+  BuildRecursive(ioBvh,
+      first_child_index,
+      inPrimitivesIndicesBegin,
+      primitives_indices_middle_index,
+      inPrimitivesAABoxes,
+      inPrimitivesCenters,
+      inLeafNodesMaxCapacity,
+      inNumBins);
+
+  const auto second_child_index = static_cast<NodeIndex>(ioBvh.mNodes.size());
+  ioBvh.mNodes.emplace_back();
+  ioBvh.mNodes[inNodeIndex].mIndex = second_child_index;
+  BuildRecursive(ioBvh,
+      second_child_index,
+      primitives_indices_middle_index,
+      inPrimitivesIndicesEnd,
+      inPrimitivesAABoxes,
+      inPrimitivesCenters,
+      inLeafNodesMaxCapacity,
+      inNumBins);
+}
+
+template <EIntersectMode TIntersectMode, typename TPrimitive>
+auto Intersect(const Bvh<TPrimitive>& inBvh,
+    const Ray3<ValueType_t<TPrimitive>>& inRay,
+    const ValueType_t<TPrimitive> inMaxDistance)
+{
+  using BvhType = Bvh<TPrimitive>;
+  using NodeIndex = typename BvhType::NodeIndex;
+
+  ray_query_detail::RayQueryHelper<TPrimitive> ray_query { inRay, inMaxDistance };
+  if (inBvh.IsEmpty())
+    return ray_query.template GetResult<TIntersectMode>();
+
+  const auto& primitives_indices = inBvh.GetPrimitivesIndices();
+  const auto& primitives_pool = inBvh.GetPrimitivesPool();
+
+  // The first child of an internal node is the next node in the array
+  const auto get_children_indices = [](const NodeIndex inNodeIndex, const auto& inNode) {
+    return std::array<NodeIndex, 2> { static_cast<NodeIndex>(inNodeIndex + 1), inNode.mIndex };
+  };
+
+  const auto intersect_leaf = [&](const NodeIndex, const auto& inNode) {
+    if constexpr (BvhType::UsesPrimitivesBlocks && TIntersectMode != EIntersectMode::ALL_INTERSECTIONS)
+    {
+      // Test the blocks overlapping the leaf range of primitives indices, a whole block at once
+      constexpr auto BlockWidth = BvhType::PrimitivesBlockWidth;
+      const auto& primitives_blocks = inBvh.GetPrimitivesBlocks();
+      const auto leaf_begin = static_cast<std::size_t>(inNode.mIndex);
+      const auto leaf_end = leaf_begin + inNode.mNumPrimitives;
+      for (auto block_begin = leaf_begin - leaf_begin % BlockWidth; block_begin < leaf_end; block_begin += BlockWidth)
+      {
+        const auto block_intersection = IntersectClosest(ray_query.mRay,
+            primitives_blocks[block_begin / BlockWidth],
+            ray_query.template GetCullDistance<TIntersectMode>(),
+            bvh_detail::GetLeafLanesMask<BlockWidth>(block_begin, leaf_begin, leaf_end));
+        if (block_intersection.mHitLanesMask == 0)
+          continue;
+
+        if constexpr (TIntersectMode == EIntersectMode::ONLY_CHECK)
+        {
+          return true;
+        }
+        else
+        {
+          ray_query.template TreatIntersectionResult<TIntersectMode>(
+              primitives_indices[block_begin + block_intersection.mLane],
+              std::make_optional(block_intersection.mDistance));
+        }
+      }
+      return false;
+    }
+    else
+    {
+      // Linear search through the leaf range of primitives indices
+      for (auto i = inNode.mIndex; i < inNode.mIndex + inNode.mNumPrimitives; ++i)
+      {
+        const auto primitive_index = primitives_indices[i];
+        if (ray_query.template IntersectPrimitive<TIntersectMode>(primitive_index, primitives_pool[primitive_index]))
+          return true;
+      }
+      return false;
+    }
+  };
+
+  return ray_query.template IntersectBinaryHierarchy<TIntersectMode>(inBvh.GetNodes(),
+      NodeIndex { 0 },
+      get_children_indices,
+      intersect_leaf);
+}
+
+template <EIntersectMode TIntersectMode, typename TPrimitive>
+auto Intersect(const Ray3<ValueType_t<TPrimitive>>& inRay,
+    const Bvh<TPrimitive>& inBvh,
+    const ValueType_t<TPrimitive> inMaxDistance)
+{
+  return Intersect<TIntersectMode, TPrimitive>(inBvh, inRay, inMaxDistance);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <ez/AAHyperBox.h>
+#include <ez/HierarchyCommon.h>
+#include <ez/IntersectMode.h>
+#include <ez/MathInitializers.h>
+#include <ez/MathTypeTraits.h>
+#include <ez/Span.h>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace ez
+{
+
+// Dynamic bounding volume hierarchy for primitives that are added, moved and removed all the time (Box2D and Bullet
+// style). Every primitive is a leaf, referred to by a proxy id that stays valid until the primitive is removed.
+// Leaves have a fat box (the primitive bounding box grown by a margin and by the predicted displacement), so that small
+// moves only update the primitive. Insertion descends to the sibling that increases the surface area the least, and
+// the ancestors are then refit and rotated to reduce their surface area. Nodes live in a single array with a free-list,
+// so adding and removing does not allocate (other than to grow the array).
+// It has the same Intersection type and Intersect/QueryOverlap interface as Octree.
+template <typename TPrimitive>
+class DynamicAABBTree final
+{
+public:
+  using ValueType = ValueType_t<TPrimitive>;
+  using AABoxType = AABox<ValueType>;
+  using ProxyId = HierarchyPrimitiveIndex;
+  using Intersection = HierarchyIntersection<ValueType>;
+  using NodeIndex = uint32_t;
+
+  static constexpr auto InvalidNodeIndex = Max<NodeIndex>();
+
+  struct Node final
+  {
+    AABoxType mAABox;                          // Fat box for leaves, union of the children boxes otherwise
+    NodeIndex mParentIndex = InvalidNodeIndex; // Next free node, for free nodes
+    std::array<NodeIndex, 2> mChildrenIndices { InvalidNodeIndex, InvalidNodeIndex };
+    int32_t mHeight = -1; // 0 for leaves, -1 for free nodes
+
+    bool IsLeaf() const { return mChildrenIndices[0] == InvalidNodeIndex; }
+  };
+
+  // inFatMargin is added around every leaf box. The box is also extended by inDisplacementMultiplier times the
+  // displacement given to MoveProxy, in the direction of the motion.
+  explicit DynamicAABBTree(const ValueType inFatMargin = static_cast<ValueType>(0.1),
+      const ValueType inDisplacementMultiplier = static_cast<ValueType>(2));
+
+  ProxyId AddProxy(const TPrimitive& inPrimitive);
+  bool RemoveProxy(const ProxyId inProxyId);
+
+  // Updates the primitive of the proxy. Its leaf is only reinserted when the new bounding box leaves the fat box, in
+  // which case it returns true (e.g. to look for new pairs).
+  bool MoveProxy(const ProxyId inProxyId,
+      const TPrimitive& inPrimitive,
+      const Vec3<ValueType>& inDisplacement = All<Vec3<ValueType>>(static_cast<ValueType>(0)));
+
+  bool HasProxy(const ProxyId inProxyId) const;
+  const TPrimitive& GetPrimitive(const ProxyId inProxyId) const;
+  const AABoxType& GetFatAABox(const ProxyId inProxyId) const;
+  std::size_t GetNumberOfProxies() const { return mNumProxies; }
+  bool IsEmpty() const { return mRootIndex == InvalidNodeIndex; }
+
+  const AABoxType& GetAABox() const;
+  int32_t GetHeight() const { return IsEmpty() ? 0 : mNodes[mRootIndex].mHeight; }
+  const std::vector<Node>& GetNodes() const { return mNodes; } // Free nodes included
+  NodeIndex GetRootIndex() const { return mRootIndex; }
+
+private:
+  ValueType mFatMargin = static_cast<ValueType>(0);
+  ValueType mDisplacementMultiplier = static_cast<ValueType>(0);
+  std::vector<Node> mNodes;
+  std::vector<TPrimitive> mPrimitivesPool; // Same size as mNodes, only meaningful for leaves
+  NodeIndex mRootIndex = InvalidNodeIndex;
+  NodeIndex mFirstFreeNodeIndex = InvalidNodeIndex;
+  std::size_t mNumProxies = 0;
+
+  NodeIndex AllocateNode();
+  void FreeNode(const NodeIndex inNodeIndex);
+  void InsertLeaf(const NodeIndex inLeafIndex);
+  void RemoveLeaf(const NodeIndex inLeafIndex);
+  void RefitAncestors(const NodeIndex inNodeIndex);
+  void Rotate(const NodeIndex inNodeIndex);
+};
+
+// Intersection functions
+template <EIntersectMode TIntersectMode, typename TPrimitive>
+auto Intersect(const DynamicAABBTree<TPrimitive>& inDynamicAABBTree,
+    const Ray3<ValueType_t<TPrimitive>>& inRay,
+    const ValueType_t<TPrimitive> inMaxDistance = Infinity<ValueType_t<TPrimitive>>());
+
+template <EIntersectMode TIntersectMode, typename TPrimitive>
+auto Intersect(const Ray3<ValueType_t<TPrimitive>>& inRay,
+    const DynamicAABBTree<TPrimitive>& inDynamicAABBTree,
+    const ValueType_t<TPrimitive> inMaxDistance = Infinity<ValueType_t<TPrimitive>>());
+
+// Overlap queries, for any query primitive for which IntersectCheck(query, primitive) is defined.
+
+// Calls inCallback(inProxyId) for every primitive overlapping inQueryPrimitive, during the traversal (no particular
+// order)
+template <typename TPrimitive, typename TQueryPrimitive, typename TCallback>
+void QueryOverlap(const DynamicAABBTree<TPrimitive>& inDynamicAABBTree,
+    const TQueryPrimitive& inQueryPrimitive,
+    const TCallback& inCallback);
+
+// Writes the proxy ids of the primitives overlapping inQueryPrimitive, by increasing proxy id (the output is cleared
+// first, so its capacity is reused across queries). Returns their number.
+template <typename TPrimitive, typename TQueryPrimitive>
+std::size_t QueryOverlap(const DynamicAABBTree<TPrimitive>& inDynamicAABBTree,
+    const TQueryPrimitive& inQueryPrimitive,
+    std::vector<typename DynamicAABBTree<TPrimitive>::ProxyId>& outProxyIds);
+
+// Broadphase pair query: calls inCallback(inProxyId0, inProxyId1), with inProxyId0 < inProxyId1, once for every pair
+// of proxies whose fat boxes overlap
+template <typename TPrimitive, typename TCallback>
+void QueryOverlappingPairs(const DynamicAABBTree<TPrimitive>& inDynamicAABBTree, const TCallback& inCallback);
+}
+
+#include "ez/DynamicAABBTree.tcc"
\ No newline at end of file
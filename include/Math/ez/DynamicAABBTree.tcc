@@ -0,0 +1,441 @@
+#include <ez/DynamicAABBTree.h>
+#include <ez/HierarchyCommon.h>
+#include <ez/Macros.h>
+#include <ez/MathCommon.h>
+#include <ez/MathIntersection.h>
+#include <ez/MathMultiComponent.h>
+#include <ez/RayQueryHelper.h>
+#include <algorithm>
+#include <optional>
+#include <utility>
+
+namespace ez
+{
+
+template <typename TPrimitive>
+DynamicAABBTree<TPrimitive>::DynamicAABBTree(const ValueType inFatMargin, const ValueType inDisplacementMultiplier)
+    : mFatMargin { inFatMargin }, mDisplacementMultiplier { inDisplacementMultiplier }
+{
+  EXPECTS(inFatMargin >= static_cast<ValueType>(0));
+  EXPECTS(inDisplacementMultiplier >= static_cast<ValueType>(0));
+}
+
+template <typename TPrimitive>
+typename DynamicAABBTree<TPrimitive>::ProxyId DynamicAABBTree<TPrimitive>::AddProxy(const TPrimitive& inPrimitive)
+{
+  const auto leaf_index = AllocateNode();
+  auto& leaf = mNodes[leaf_index];
+  const auto primitive_aabox = BoundingAAHyperBox(inPrimitive);
+  leaf.mAABox = AABoxType(primitive_aabox.GetMin() - mFatMargin, primitive_aabox.GetMax() + mFatMargin);
+  leaf.mHeight = 0;
+  mPrimitivesPool[leaf_index] = inPrimitive;
+
+  InsertLeaf(leaf_index);
+  ++mNumProxies;
+  return static_cast<ProxyId>(leaf_index);
+}
+
+template <typename TPrimitive>
+bool DynamicAABBTree<TPrimitive>::RemoveProxy(const ProxyId inProxyId)
+{
+  if (!HasProxy(inProxyId))
+    return false;
+
+  const auto leaf_index = static_cast<NodeIndex>(inProxyId);
+  RemoveLeaf(leaf_index);
+  FreeNode(leaf_index);
+  --mNumProxies;
+  return true;
+}
+
+template <typename TPrimitive>
+bool DynamicAABBTree<TPrimitive>::MoveProxy(const ProxyId inProxyId,
+    const TPrimitive& inPrimitive,
+    const Vec3<ValueType>& inDisplacement)
+{
+  EXPECTS(HasProxy(inProxyId));
+
+  const auto leaf_index = static_cast<NodeIndex>(inProxyId);
+  mPrimitivesPool[leaf_index] = inPrimitive;
+  const auto primitive_aabox = BoundingAAHyperBox(inPrimitive);
+  if (Contains(mNodes[leaf_index].mAABox, primitive_aabox))
+    return false;
+
+  // Predict the next moves, so that a proxy moving in a steady direction does not get reinserted every time
+  const auto predicted_displacement = inDisplacement * mDisplacementMultiplier;
+  const auto zero = All<Vec3<ValueType>>(static_cast<ValueType>(0));
+  RemoveLeaf(leaf_index);
+  mNodes[leaf_index].mAABox = AABoxType(primitive_aabox.GetMin() - mFatMargin + Min(predicted_displacement, zero),
+      primitive_aabox.GetMax() + mFatMargin + Max(predicted_displacement, zero));
+  InsertLeaf(leaf_index);
+  return true;
+}
+
+template <typename TPrimitive>
+bool DynamicAABBTree<TPrimitive>::HasProxy(const ProxyId inProxyId) const
+{
+  return inProxyId < mNodes.size() && mNodes[inProxyId].mHeight == 0;
+}
+
+template <typename TPrimitive>
+const TPrimitive& DynamicAABBTree<TPrimitive>::GetPrimitive(const ProxyId inProxyId) const
+{
+  EXPECTS(HasProxy(inProxyId));
+  return mPrimitivesPool[inProxyId];
+}
+
+template <typename TPrimitive>
+const typename DynamicAABBTree<TPrimitive>::AABoxType& DynamicAABBTree<TPrimitive>::GetFatAABox(
+    const ProxyId inProxyId) const
+{
+  EXPECTS(HasProxy(inProxyId));
+  return mNodes[inProxyId].mAABox;
+}
+
+template <typename TPrimitive>
+const typename DynamicAABBTree<TPrimitive>::AABoxType& DynamicAABBTree<TPrimitive>::GetAABox() const
+{
+  EXPECTS(!IsEmpty());
+  return mNodes[mRootIndex].mAABox;
+}
+
+template <typename TPrimitive>
+typename DynamicAABBTree<TPrimitive>::NodeIndex DynamicAABBTree<TPrimitive>::AllocateNode()
+{
+  if (mFirstFreeNodeIndex == InvalidNodeIndex)
+  {
+    EXPECTS(mNodes.size() < InvalidNodeIndex);
+    mNodes.emplace_back();
+    mPrimitivesPool.emplace_back();
+    return static_cast<NodeIndex>(mNodes.size() - 1);
+  }
+
+  const auto node_index = mFirstFreeNodeIndex;
+  mFirstFreeNodeIndex = mNodes[node_index].mParentIndex;
+  mNodes[node_index] = Node {};
+  return node_index;
+}
+
+template <typename TPrimitive>
+void DynamicAABBTree<TPrimitive>::FreeNode(const NodeIndex inNodeIndex)
+{
+  auto& node = mNodes[inNodeIndex];
+  node.mParentIndex = mFirstFreeNodeIndex;
+  node.mChildrenIndices = { InvalidNodeIndex, InvalidNodeIndex };
+  node.mHeight = -1;
+  mFirstFreeNodeIndex = inNodeIndex;
+}
+
+template <typename TPrimitive>
+void DynamicAABBTree<TPrimitive>::InsertLeaf(const NodeIndex inLeafIndex)
+{
+  using hierarchy_detail::HalfSurfaceArea;
+  using hierarchy_detail::MakeUnion;
+
+  if (IsEmpty())
+  {
+    mRootIndex = inLeafIndex;
+    mNodes[inLeafIndex].mParentIndex = InvalidNodeIndex;
+    return;
+  }
+
+  // Descend to the sibling that increases the total surface area the least. Going down a child costs the growth of
+  // the current node (inherited by all the nodes below), plus the growth of the child (or the new parent, for a leaf).
+  const auto leaf_aabox = mNodes[inLeafIndex].mAABox;
+  auto sibling_index = mRootIndex;
+  while (!mNodes[sibling_index].IsLeaf())
+  {
+    const auto& node = mNodes[sibling_index];
+    const auto node_half_surface_area = HalfSurfaceArea(node.mAABox);
+    const auto combined_half_surface_area = HalfSurfaceArea(MakeUnion(node.mAABox, leaf_aabox));
+
+    // Cost of making a new parent for this node and the leaf
+    const auto sibling_cost = static_cast<ValueType>(2) * combined_half_surface_area;
+    const auto inheritance_cost = static_cast<ValueType>(2) * (combined_half_surface_area - node_half_surface_area);
+
+    std::array<ValueType, 2> children_costs {};
+    for (std::size_t child_side = 0; child_side < 2; ++child_side)
+    {
+      const auto& child = mNodes[node.mChildrenIndices[child_side]];
+      const auto child_combined_half_surface_area = HalfSurfaceArea(MakeUnion(child.mAABox, leaf_aabox));
+      children_costs[child_side] = inheritance_cost
+          + (child.IsLeaf() ? child_combined_half_surface_area
+                            : (child_combined_half_surface_area - HalfSurfaceArea(child.mAABox)));
+    }
+
+    if (sibling_cost < children_costs[0] && sibling_cost < children_costs[1])
+      break;
+
+    sibling_index = node.mChildrenIndices[children_costs[0] <= children_costs[1] ? 0 : 1];
+  }
+
+  const auto old_parent_index = mNodes[sibling_index].mParentIndex;
+  const auto new_parent_index = AllocateNode();
+  auto& new_parent = mNodes[new_parent_index];
+  new_parent.mParentIndex = old_parent_index;
+  new_parent.mChildrenIndices = { sibling_index, inLeafIndex };
+  new_parent.mAABox = MakeUnion(leaf_aabox, mNodes[sibling_index].mAABox);
+  new_parent.mHeight = mNodes[sibling_index].mHeight + 1;
+  mNodes[sibling_index].mParentIndex = new_parent_index;
+  mNodes[inLeafIndex].mParentIndex = new_parent_index;
+
+  if (old_parent_index == InvalidNodeIndex)
+  {
+    mRootIndex = new_parent_index;
+  }
+  else
+  {
+    auto& old_parent_children_indices = mNodes[old_parent_index].mChildrenIndices;
+    old_parent_children_indices[old_parent_children_indices[0] == sibling_index ? 0 : 1] = new_parent_index;
+  }
+
+  RefitAncestors(old_parent_index);
+}
+
+template <typename TPrimitive>
+void DynamicAABBTree<TPrimitive>::RemoveLeaf(const NodeIndex inLeafIndex)
+{
+  if (inLeafIndex == mRootIndex)
+  {
+    mRootIndex = InvalidNodeIndex;
+    return;
+  }
+
+  // The sibling takes the place of the parent
+  const auto parent_index = mNodes[inLeafIndex].mParentIndex;
+  const auto& parent_children_indices = mNodes[parent_index].mChildrenIndices;
+  const auto sibling_index = parent_children_indices[parent_children_indices[0] == inLeafIndex ? 1 : 0];
+  const auto grand_parent_index = mNodes[parent_index].mParentIndex;
+  mNodes[sibling_index].mParentIndex = grand_parent_index;
+  if (grand_parent_index == InvalidNodeIndex)
+  {
+    mRootIndex = sibling_index;
+  }
+  else
+  {
+    auto& grand_parent_children_indices = mNodes[grand_parent_index].mChildrenIndices;
+    grand_parent_children_indices[grand_parent_children_indices[0] == parent_index ? 0 : 1] = sibling_index;
+  }
+  FreeNode(parent_index);
+
+  mNodes[inLeafIndex].mParentIndex = InvalidNodeIndex;
+  RefitAncestors(grand_parent_index);
+}
+
+template <typename TPrimitive>
+void DynamicAABBTree<TPrimitive>::RefitAncestors(const NodeIndex inNodeIndex)
+{
+  for (auto node_index = inNodeIndex; node_index != InvalidNodeIndex; node_index = mNodes[node_index].mParentIndex)
+  {
+    Rotate(node_index);
+
+    auto& node = mNodes[node_index];
+    const auto& child0 = mNodes[node.mChildrenIndices[0]];
+    const auto& child1 = mNodes[node.mChildrenIndices[1]];
+    node.mAABox = hierarchy_detail::MakeUnion(child0.mAABox, child1.mAABox);
+    node.mHeight = std::max(child0.mHeight, child1.mHeight) + 1;
+  }
+}
+
+template <typename TPrimitive>
+void DynamicAABBTree<TPrimitive>::Rotate(const NodeIndex inNodeIndex)
+{
+  using hierarchy_detail::HalfSurfaceArea;
+  using hierarchy_detail::MakeUnion;
+
+  // Same rotations as Bvh::Optimize: swap a child with a grandchild below the other child, if it reduces the surface
+  // area of that other child (the only box that changes)
+  struct Rotation final
+  {
+    std::size_t mChildSide = 0;
+    std::size_t mGrandChildSide = 0;
+    ValueType mHalfSurfaceAreaReduction = static_cast<ValueType>(0);
+  };
+
+  auto& children_indices = mNodes[inNodeIndex].mChildrenIndices;
+  std::optional<Rotation> best_rotation;
+  for (std::size_t child_side = 0; child_side < 2; ++child_side)
+  {
+    const auto& other_child = mNodes[children_indices[1 - child_side]];
+    if (other_child.IsLeaf())
+      continue;
+
+    const auto other_child_half_surface_area = HalfSurfaceArea(other_child.mAABox);
+    for (std::size_t grandchild_side = 0; grandchild_side < 2; ++grandchild_side)
+    {
+      const auto rotated_other_child_aabox = MakeUnion(mNodes[children_indices[child_side]].mAABox,
+          mNodes[other_child.mChildrenIndices[1 - grandchild_side]].mAABox);
+      const auto reduction = (other_child_half_surface_area - HalfSurfaceArea(rotated_other_child_aabox));
+      if (reduction > (best_rotation ? best_rotation->mHalfSurfaceAreaReduction : static_cast<ValueType>(0)))
+        best_rotation = Rotation { child_side, grandchild_side, reduction };
+    }
+  }
+
+  if (!best_rotation)
+    return;
+
+  const auto other_child_index = children_indices[1 - best_rotation->mChildSide];
+  auto& other_child = mNodes[other_child_index];
+  auto& child_index = children_indices[best_rotation->mChildSide];
+  auto& grandchild_index = other_child.mChildrenIndices[best_rotation->mGrandChildSide];
+  std::swap(child_index, grandchild_index);
+  mNodes[child_index].mParentIndex = inNodeIndex;
+  mNodes[grandchild_index].mParentIndex = other_child_index;
+
+  const auto& grandchild0 = mNodes[other_child.mChildrenIndices[0]];
+  const auto& grandchild1 = mNodes[other_child.mChildrenIndices[1]];
+  other_child.mAABox = MakeUnion(grandchild0.mAABox, grandchild1.mAABox);
+  other_child.mHeight = std::max(grandchild0.mHeight, grandchild1.mHeight) + 1;
+}
+
+template <EIntersectMode TIntersectMode, typename TPrimitive>
+auto Intersect(const DynamicAABBTree<TPrimitive>& inDynamicAABBTree,
+    const Ray3<ValueType_t<TPrimitive>>& inRay,
+    const ValueType_t<TPrimitive> inMaxDistance)
+{
+  using NodeIndex = typename DynamicAABBTree<TPrimitive>::NodeIndex;
+
+  ray_query_detail::RayQueryHelper<TPrimitive> ray_query { inRay, inMaxDistance };
+  if (inDynamicAABBTree.IsEmpty())
+    return ray_query.template GetResult<TIntersectMode>();
+
+  // Leaves hold a single primitive, whose proxy id is the leaf node index
+  const auto get_children_indices = [](const NodeIndex, const auto& inNode) { return inNode.mChildrenIndices; };
+  const auto intersect_leaf = [&](const NodeIndex inNodeIndex, const auto&) {
+    return ray_query.template IntersectPrimitive<TIntersectMode>(inNodeIndex,
+        inDynamicAABBTree.GetPrimitive(inNodeIndex));
+  };
+
+  return ray_query.template IntersectBinaryHierarchy<TIntersectMode>(inDynamicAABBTree.GetNodes(),
+      inDynamicAABBTree.GetRootIndex(),
+      get_children_indices,
+      intersect_leaf);
+}
+
+template <EIntersectMode TIntersectMode, typename TPrimitive>
+auto Intersect(const Ray3<ValueType_t<TPrimitive>>& inRay,
+    const DynamicAABBTree<TPrimitive>& inDynamicAABBTree,
+    const ValueType_t<TPrimitive> inMaxDistance)
+{
+  return Intersect<TIntersectMode, TPrimitive>(inDynamicAABBTree, inRay, inMaxDistance);
+}
+
+namespace dynamic_aabb_tree_detail
+{
+  // Calls inCallback(inProxyId) for every proxy overlapping inQueryPrimitive, as the traversal finds them. Leaves
+  // hold a single proxy and every proxy is in a single leaf, so each one is found once.
+  template <typename TPrimitive, typename TQueryPrimitive, typename TCallback>
+  void ForEachOverlappingProxy(const DynamicAABBTree<TPrimitive>& inDynamicAABBTree,
+      const TQueryPrimitive& inQueryPrimitive,
+      const TCallback& inCallback)
+  {
+    using ProxyId = typename DynamicAABBTree<TPrimitive>::ProxyId;
+    using NodeIndex = typename DynamicAABBTree<TPrimitive>::NodeIndex;
+
+    if (inDynamicAABBTree.IsEmpty())
+      return;
+
+    const auto& nodes = inDynamicAABBTree.GetNodes();
+    std::vector<NodeIndex> nodes_to_explore { inDynamicAABBTree.GetRootIndex() };
+    while (!nodes_to_explore.empty())
+    {
+      const auto node_index = nodes_to_explore.back();
+      nodes_to_explore.pop_back();
+
+      const auto& node = nodes[node_index];
+      if (!IntersectCheck(inQueryPrimitive, node.mAABox))
+        continue;
+
+      if (node.IsLeaf())
+      {
+        if (IntersectCheck(inQueryPrimitive, inDynamicAABBTree.GetPrimitive(node_index)))
+          inCallback(static_cast<ProxyId>(node_index));
+        continue;
+      }
+
+      nodes_to_explore.push_back(node.mChildrenIndices[1]);
+      nodes_to_explore.push_back(node.mChildrenIndices[0]);
+    }
+  }
+}
+
+template <typename TPrimitive, typename TQueryPrimitive, typename TCallback>
+void QueryOverlap(const DynamicAABBTree<TPrimitive>& inDynamicAABBTree,
+    const TQueryPrimitive& inQueryPrimitive,
+    const TCallback& inCallback)
+{
+  dynamic_aabb_tree_detail::ForEachOverlappingProxy(inDynamicAABBTree, inQueryPrimitive, inCallback);
+}
+
+template <typename TPrimitive, typename TQueryPrimitive>
+std::size_t QueryOverlap(const DynamicAABBTree<TPrimitive>& inDynamicAABBTree,
+    const TQueryPrimitive& inQueryPrimitive,
+    std::vector<typename DynamicAABBTree<TPrimitive>::ProxyId>& outProxyIds)
+{
+  outProxyIds.clear();
+  dynamic_aabb_tree_detail::ForEachOverlappingProxy(inDynamicAABBTree,
+      inQueryPrimitive,
+      [&](const typename DynamicAABBTree<TPrimitive>::ProxyId inProxyId) { outProxyIds.push_back(inProxyId); });
+  std::sort(outProxyIds.begin(), outProxyIds.end());
+  return outProxyIds.size();
+}
+
+template <typename TPrimitive, typename TCallback>
+void QueryOverlappingPairs(const DynamicAABBTree<TPrimitive>& inDynamicAABBTree, const TCallback& inCallback)
+{
+  using ProxyId = typename DynamicAABBTree<TPrimitive>::ProxyId;
+  using NodeIndex = typename DynamicAABBTree<TPrimitive>::NodeIndex;
+
+  if (inDynamicAABBTree.IsEmpty())
+    return;
+
+  // Simultaneous descent of the tree against itself. A pair (A, A) stands for the pairs inside the subtree A, which are
+  // the pairs inside each child plus the pairs between both children. Every pair of leaves is reached exactly once.
+  const auto& nodes = inDynamicAABBTree.GetNodes();
+  std::vector<std::pair<NodeIndex, NodeIndex>> node_pairs_to_explore;
+  node_pairs_to_explore.emplace_back(inDynamicAABBTree.GetRootIndex(), inDynamicAABBTree.GetRootIndex());
+  while (!node_pairs_to_explore.empty())
+  {
+    const auto [node_index0, node_index1] = node_pairs_to_explore.back();
+    node_pairs_to_explore.pop_back();
+
+    const auto& node0 = nodes[node_index0];
+    const auto& node1 = nodes[node_index1];
+    if (node_index0 == node_index1)
+    {
+      if (node0.IsLeaf())
+        continue;
+
+      node_pairs_to_explore.emplace_back(node0.mChildrenIndices[0], node0.mChildrenIndices[0]);
+      node_pairs_to_explore.emplace_back(node0.mChildrenIndices[1], node0.mChildrenIndices[1]);
+      node_pairs_to_explore.emplace_back(node0.mChildrenIndices[0], node0.mChildrenIndices[1]);
+      continue;
+    }
+
+    if (!IntersectCheck(node0.mAABox, node1.mAABox))
+      continue;
+
+    if (node0.IsLeaf() && node1.IsLeaf())
+    {
+      inCallback(static_cast<ProxyId>(std::min(node_index0, node_index1)),
+          static_cast<ProxyId>(std::max(node_index0, node_index1)));
+      continue;
+    }
+
+    // Descend into the bigger node, so that both sides shrink at a similar pace
+    const auto descend_node0 = !node0.IsLeaf()
+        && (node1.IsLeaf()
+            || hierarchy_detail::HalfSurfaceArea(node0.mAABox) >= hierarchy_detail::HalfSurfaceArea(node1.mAABox));
+    if (descend_node0)
+    {
+      node_pairs_to_explore.emplace_back(node0.mChildrenIndices[0], node_index1);
+      node_pairs_to_explore.emplace_back(node0.mChildrenIndices[1], node_index1);
+    }
+    else
+    {
+      node_pairs_to_explore.emplace_back(node_index0, node1.mChildrenIndices[0]);
+      node_pairs_to_explore.emplace_back(node_index0, node1.mChildrenIndices[1]);
+    }
+  }
+}
+}
\ No newline at end of file
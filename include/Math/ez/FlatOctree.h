@@ -0,0 +1,106 @@
+#pragma once
+
+#include <ez/AAHyperBox.h>
+#include <ez/IntersectMode.h>
+#include <ez/MathTypeTraits.h>
+#include <ez/Octree.h>
+#include <ez/Span.h>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace ez
+{
+
+template <typename TPrimitive>
+class FlatOctreeBuilder;
+
+// Pointer-free version of Octree, meant for fast (cache-friendly) queries.
+// All the nodes live in a single contiguous array, where the existing children of a node are stored consecutively.
+// Leaves do not own their primitives indices, they point to a range inside a shared primitives indices buffer.
+// Node boxes are not stored: ray queries walk the children with the ray parameters at their planes, obtained from the
+// root box (same parametric traversal as Octree).
+template <typename TPrimitive>
+class FlatOctree final
+{
+public:
+  using ValueType = ValueType_t<TPrimitive>;
+  using AABoxType = AABox<ValueType>;
+  using ChildSequentialIndex = typename Octree<TPrimitive>::ChildSequentialIndex;
+  using PrimitiveIndex = typename Octree<TPrimitive>::PrimitiveIndex;
+  using Intersection = typename Octree<TPrimitive>::Intersection;
+  using NodeIndex = uint32_t;
+  using CompactPrimitiveIndex = uint32_t;
+
+  struct Node final
+  {
+    NodeIndex mFirstChildIndex = 0;                     // Index in the nodes array of the first existing child
+    CompactPrimitiveIndex mPrimitivesIndicesBegin = 0;  // Leaf range begin in the shared primitives indices buffer
+    CompactPrimitiveIndex mNumPrimitivesIndices = 0;    // Leaf range size in the shared primitives indices buffer
+    uint8_t mChildrenMask = 0;                          // Bit i is set if the child with sequential index i exists
+
+    bool IsLeaf() const { return mChildrenMask == 0; }
+    bool HasChild(const ChildSequentialIndex inChildSequentialIndex) const;
+    NodeIndex GetChildIndex(const ChildSequentialIndex inChildSequentialIndex) const;
+    // Whether the children range (which must come after the node, so that traversals terminate) or the leaf range is
+    // inside the nodes and primitives indices arrays, for nodes loaded from files
+    bool HasValidRanges(const std::size_t inNodeIndex,
+        const std::size_t inNumNodes,
+        const std::size_t inNumPrimitivesIndices) const;
+  };
+
+  FlatOctree() = default;
+  explicit FlatOctree(const Octree<TPrimitive>& inOctree);
+  FlatOctree(const Span<TPrimitive>& inPrimitives,
+      const std::size_t inLeafNodesMaxCapacity = 8,
+      const std::size_t inMaxDepth = 8);
+  FlatOctree(const FlatOctree&) = delete;
+  FlatOctree& operator=(const FlatOctree&) = delete;
+  FlatOctree(FlatOctree&&) = default;
+  FlatOctree& operator=(FlatOctree&&) = default;
+
+  const AABoxType& GetAABox() const { return mAABox; }
+  const std::vector<TPrimitive>& GetPrimitivesPool() const { return mPrimitivesPool; }
+  const std::vector<CompactPrimitiveIndex>& GetPrimitivesIndices() const { return mPrimitivesIndices; }
+  const std::vector<Node>& GetNodes() const { return mNodes; }
+  const Node& GetRootNode() const;
+  std::size_t GetMaxDepth() const { return mMaxDepth; }
+  bool IsEmpty() const { return mNodes.empty(); }
+
+  static AABoxType GetChildAABox(const AABoxType& inParentAABox, const ChildSequentialIndex inChildSequentialIndex);
+
+private:
+  AABoxType mAABox;
+  std::vector<Node> mNodes;                                 // Root is at index 0
+  std::vector<CompactPrimitiveIndex> mPrimitivesIndices;    // Shared buffer with the leaves primitives indices
+  std::vector<TPrimitive> mPrimitivesPool;
+  std::size_t mMaxDepth = 0;
+
+  friend class FlatOctreeBuilder<TPrimitive>;
+};
+
+template <typename TPrimitive>
+class FlatOctreeBuilder final
+{
+public:
+  FlatOctreeBuilder() = delete;
+
+  static FlatOctree<TPrimitive> Build(const Octree<TPrimitive>& inOctree);
+  static FlatOctree<TPrimitive> Build(const Span<TPrimitive>& inPrimitives,
+      const std::size_t inLeafNodesMaxCapacity = 8,
+      const std::size_t inMaxDepth = 8);
+};
+
+// Intersection functions
+template <EIntersectMode TIntersectMode, typename TPrimitive>
+auto Intersect(const FlatOctree<TPrimitive>& inFlatOctree,
+    const Ray3<ValueType_t<TPrimitive>>& inRay,
+    const ValueType_t<TPrimitive> inMaxDistance = Infinity<ValueType_t<TPrimitive>>());
+
+template <EIntersectMode TIntersectMode, typename TPrimitive>
+auto Intersect(const Ray3<ValueType_t<TPrimitive>>& inRay,
+    const FlatOctree<TPrimitive>& inFlatOctree,
+    const ValueType_t<TPrimitive> inMaxDistance = Infinity<ValueType_t<TPrimitive>>());
+}
+
+#include "ez/FlatOctree.tcc"
\ No newline at end of file
@@ -0,0 +1,317 @@
+#include <ez/FlatOctree.h>
+#include <ez/Macros.h>
+#include <ez/Ray.h>
+#include <ez/RayQueryHelper.h>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <iterator>
+#include <queue>
+#include <type_traits>
+#include <utility>
+
+namespace ez
+{
+
+template <typename TPrimitive>
+bool FlatOctree<TPrimitive>::Node::HasChild(const ChildSequentialIndex inChildSequentialIndex) const
+{
+  EXPECTS(inChildSequentialIndex < 8);
+  return (mChildrenMask & (1u << inChildSequentialIndex)) != 0;
+}
+
+template <typename TPrimitive>
+typename FlatOctree<TPrimitive>::NodeIndex FlatOctree<TPrimitive>::Node::GetChildIndex(
+    const ChildSequentialIndex inChildSequentialIndex) const
+{
+  EXPECTS(HasChild(inChildSequentialIndex));
+
+  // Only existing children are stored, so the offset is the number of existing children before this one
+  const auto previous_children_mask = static_cast<uint8_t>(mChildrenMask & ((1u << inChildSequentialIndex) - 1u));
+  return mFirstChildIndex + static_cast<NodeIndex>(std::popcount(previous_children_mask));
+}
+
+template <typename TPrimitive>
+bool FlatOctree<TPrimitive>::Node::HasValidRanges(const std::size_t inNodeIndex,
+    const std::size_t inNumNodes,
+    const std::size_t inNumPrimitivesIndices) const
+{
+  if (IsLeaf())
+  {
+    const auto primitives_indices_end
+        = static_cast<uint64_t>(mPrimitivesIndicesBegin) + static_cast<uint64_t>(mNumPrimitivesIndices);
+    return primitives_indices_end <= static_cast<uint64_t>(inNumPrimitivesIndices);
+  }
+
+  const auto first_child_index = static_cast<uint64_t>(mFirstChildIndex);
+  const auto num_children = static_cast<uint64_t>(std::popcount(mChildrenMask));
+  return first_child_index > static_cast<uint64_t>(inNodeIndex)
+      && first_child_index + num_children <= static_cast<uint64_t>(inNumNodes);
+}
+
+template <typename TPrimitive>
+FlatOctree<TPrimitive>::FlatOctree(const Octree<TPrimitive>& inOctree)
+{
+  *this = FlatOctreeBuilder<TPrimitive>::Build(inOctree);
+}
+
+template <typename TPrimitive>
+FlatOctree<TPrimitive>::FlatOctree(const Span<TPrimitive>& inPrimitives,
+    const std::size_t inLeafNodesMaxCapacity,
+    const std::size_t inMaxDepth)
+{
+  *this = FlatOctreeBuilder<TPrimitive>::Build(inPrimitives, inLeafNodesMaxCapacity, inMaxDepth);
+}
+
+template <typename TPrimitive>
+const typename FlatOctree<TPrimitive>::Node& FlatOctree<TPrimitive>::GetRootNode() const
+{
+  EXPECTS(!IsEmpty());
+  return mNodes.front();
+}
+
+template <typename TPrimitive>
+typename FlatOctree<TPrimitive>::AABoxType FlatOctree<TPrimitive>::GetChildAABox(const AABoxType& inParentAABox,
+    const ChildSequentialIndex inChildSequentialIndex)
+{
+  const auto child_multi_index = MakeBinaryIndex<3, ValueType>(inChildSequentialIndex);
+  const auto child_aabox_size = (inParentAABox.GetSize() / static_cast<ValueType>(2));
+  const auto child_aabox_min = inParentAABox.GetMin() + child_aabox_size * child_multi_index;
+  const auto child_aabox_max = child_aabox_min + child_aabox_size;
+  return AABoxType(child_aabox_min, child_aabox_max);
+}
+
+template <typename TPrimitive>
+FlatOctree<TPrimitive> FlatOctreeBuilder<TPrimitive>::Build(const Octree<TPrimitive>& inOctree)
+{
+  using FlatOctreeType = FlatOctree<TPrimitive>;
+  using NodeIndex = typename FlatOctreeType::NodeIndex;
+  using CompactPrimitiveIndex = typename FlatOctreeType::CompactPrimitiveIndex;
+
+  FlatOctreeType flat_octree;
+  flat_octree.mAABox = inOctree.GetAABox();
+  const auto octree_primitives = inOctree.GetPrimitives(); // The flat octree always owns a copy, even of a view
+  flat_octree.mPrimitivesPool.assign(octree_primitives.cbegin(), octree_primitives.cend());
+  EXPECTS(flat_octree.mPrimitivesPool.size() <= Max<CompactPrimitiveIndex>());
+
+  // Breadth-first, so that the existing children of each node end up consecutive in the nodes array
+  std::queue<std::tuple<const Octree<TPrimitive>*, NodeIndex, std::size_t>> octrees_queue;
+  flat_octree.mNodes.emplace_back();
+  octrees_queue.emplace(&inOctree, 0, 0);
+  while (!octrees_queue.empty())
+  {
+    const auto [octree, node_index, depth] = octrees_queue.front();
+    octrees_queue.pop();
+    flat_octree.mMaxDepth = std::max(flat_octree.mMaxDepth, depth);
+
+    if (octree->IsLeaf())
+    {
+      const auto& octree_primitives_indices = octree->GetPrimitivesIndices();
+      auto& leaf_node = flat_octree.mNodes.at(node_index);
+      leaf_node.mPrimitivesIndicesBegin = static_cast<CompactPrimitiveIndex>(flat_octree.mPrimitivesIndices.size());
+      leaf_node.mNumPrimitivesIndices = static_cast<CompactPrimitiveIndex>(octree_primitives_indices.size());
+      flat_octree.mPrimitivesIndices.insert(flat_octree.mPrimitivesIndices.end(),
+          octree_primitives_indices.cbegin(),
+          octree_primitives_indices.cend());
+      continue;
+    }
+
+    const auto first_child_index = static_cast<NodeIndex>(flat_octree.mNodes.size());
+    auto children_mask = static_cast<uint8_t>(0);
+    for (std::size_t i = 0; i < 8; ++i)
+    {
+      const auto child_octree = octree->GetChildOctree(i);
+      if (!child_octree)
+        continue;
+
+      children_mask |= static_cast<uint8_t>(1u << i);
+      octrees_queue.emplace(child_octree, static_cast<NodeIndex>(flat_octree.mNodes.size()), depth + 1);
+      flat_octree.mNodes.emplace_back();
+    }
+
+    auto& internal_node = flat_octree.mNodes.at(node_index); // Get it after emplacing, it might have been reallocated
+    internal_node.mFirstChildIndex = first_child_index;
+    internal_node.mChildrenMask = children_mask;
+  }
+
+  flat_octree.mNodes.shrink_to_fit();
+  flat_octree.mPrimitivesIndices.shrink_to_fit();
+  return flat_octree;
+}
+
+template <typename TPrimitive>
+FlatOctree<TPrimitive> FlatOctreeBuilder<TPrimitive>::Build(const Span<TPrimitive>& inPrimitives,
+    const std::size_t inLeafNodesMaxCapacity,
+    const std::size_t inMaxDepth)
+{
+  const auto octree = OctreeBuilder<TPrimitive>::Build(inPrimitives, inLeafNodesMaxCapacity, inMaxDepth);
+  return Build(octree);
+}
+
+template <typename TPrimitive>
+struct FlatOctreeIntersectHelperStruct final
+{
+  using FlatOctreeType = FlatOctree<TPrimitive>;
+  using ValueType = ValueType_t<TPrimitive>;
+  using AABoxType = typename FlatOctreeType::AABoxType;
+  using NodeIndex = typename FlatOctreeType::NodeIndex;
+
+  // Same parametric traversal as Octree (see octree_detail::ForEachParametricChild), which does not need the node
+  // boxes, only the ray parameters at their planes
+  struct NodeToExplore final
+  {
+    NodeIndex mNodeIndex = 0;
+    Vec3<ValueType> mEnterDistances; // Ray parameter at the (mirrored) min plane of each axis
+    Vec3<ValueType> mExitDistances;  // Ray parameter at the (mirrored) max plane of each axis
+    AABoxType mAABox;                // Only kept for rays parallel to some axis, to know which side of the mid planes
+  };
+
+  ray_query_detail::RayQueryHelper<TPrimitive> mRayQuery;
+
+  FlatOctreeIntersectHelperStruct(const Ray3<ValueType>& inRay, const ValueType& inMaxDistance)
+      : mRayQuery { inRay, inMaxDistance }
+  {
+  }
+
+  // Works with any flat octree storage with the same interface as FlatOctree (e.g. MappedFlatOctree)
+  template <EIntersectMode TIntersectMode, typename TFlatOctree>
+  auto Intersect(const TFlatOctree& inFlatOctree)
+  {
+    static_assert(TIntersectMode == EIntersectMode::ALL_INTERSECTIONS || TIntersectMode == EIntersectMode::ONLY_CLOSEST
+            || TIntersectMode == EIntersectMode::ONLY_CHECK,
+        "Unsupported EIntersectMode");
+
+    const auto& ray = mRayQuery.mRay;
+    const auto& ray_direction = ray.GetDirection();
+    const auto is_ray_parallel_to_some_axis
+        = (std::find(ray_direction.cbegin(), ray_direction.cend(), static_cast<ValueType>(0)) != ray_direction.cend());
+    std::vector<NodeToExplore> nodes_to_explore;
+    std::size_t mirror_mask = 0;
+    if (!inFlatOctree.IsEmpty())
+    {
+      auto root_to_explore = NodeToExplore { 0, Vec3<ValueType>(), Vec3<ValueType>(), inFlatOctree.GetAABox() };
+      mirror_mask = octree_detail::GetParametricRootDistances(ray,
+          inFlatOctree.GetAABox(),
+          root_to_explore.mEnterDistances,
+          root_to_explore.mExitDistances);
+      if (IsTraversed(root_to_explore, mRayQuery.mMaxDistance))
+      {
+        nodes_to_explore.reserve(4 * (inFlatOctree.GetMaxDepth() + 1));
+        nodes_to_explore.push_back(root_to_explore);
+      }
+    }
+
+    // Storages loaded from files (e.g. MappedFlatOctree) may be corrupted: their nodes and primitives indices are
+    // checked as they are read, and out of range ones are skipped
+    constexpr auto CheckRanges = !std::is_same_v<TFlatOctree, FlatOctreeType>;
+
+    const auto& nodes = inFlatOctree.GetNodes();
+    const auto& primitives_indices = inFlatOctree.GetPrimitivesIndices();
+    const auto& primitives_pool = inFlatOctree.GetPrimitivesPool();
+    while (!nodes_to_explore.empty())
+    {
+      const auto node_to_explore = nodes_to_explore.back();
+      nodes_to_explore.pop_back();
+
+      // Nodes are explored front-to-back, so nothing behind the closest intersection found so far can be closer
+      if constexpr (TIntersectMode == EIntersectMode::ONLY_CLOSEST)
+      {
+        if (Max(node_to_explore.mEnterDistances) > mRayQuery.template GetCullDistance<TIntersectMode>())
+          continue;
+      }
+
+      const auto& node = nodes[node_to_explore.mNodeIndex];
+      if constexpr (CheckRanges)
+      {
+        if (!node.HasValidRanges(node_to_explore.mNodeIndex, nodes.size(), primitives_indices.size()))
+          continue;
+      }
+
+      if (node.IsLeaf())
+      {
+        // Base case, linear search through the leaf range of primitives indices
+        const auto primitives_indices_begin = primitives_indices.begin() + node.mPrimitivesIndicesBegin;
+        const auto primitives_indices_end = primitives_indices_begin + node.mNumPrimitivesIndices;
+        for (auto it = primitives_indices_begin; it != primitives_indices_end; ++it)
+        {
+          const auto primitive_index = static_cast<typename FlatOctreeType::PrimitiveIndex>(*it);
+          if constexpr (CheckRanges)
+          {
+            if (primitive_index >= primitives_pool.size())
+              continue;
+          }
+
+          const auto& primitive = primitives_pool[primitive_index];
+          if constexpr (TIntersectMode == EIntersectMode::ONLY_CHECK)
+          {
+            if (mRayQuery.template IntersectPrimitive<TIntersectMode>(primitive_index, primitive))
+              return true;
+          }
+          else
+          {
+            mRayQuery.template IntersectPrimitive<TIntersectMode>(primitive_index, primitive);
+          }
+        }
+        continue;
+      }
+
+      // Recursive case, collect the (up to 4) existing children crossed by the ray, in order
+      std::array<NodeToExplore, 4> children_to_explore;
+      std::size_t num_children_to_explore = 0;
+      octree_detail::ForEachParametricChild(
+          ray,
+          node_to_explore.mEnterDistances,
+          node_to_explore.mExitDistances,
+          [&]() { return node_to_explore.mAABox.GetCenter(); },
+          [&](const std::size_t inChildSequentialIndex,
+              const Vec3<ValueType>& inChildEnterDistances,
+              const Vec3<ValueType>& inChildExitDistances) {
+            const auto child_sequential_index = (inChildSequentialIndex ^ mirror_mask);
+            if (!node.HasChild(child_sequential_index))
+              return;
+
+            const auto child_index = node.GetChildIndex(child_sequential_index);
+            auto child_to_explore = NodeToExplore { child_index, inChildEnterDistances, inChildExitDistances };
+            if (!IsTraversed(child_to_explore, mRayQuery.template GetCullDistance<TIntersectMode>()))
+              return;
+
+            if (is_ray_parallel_to_some_axis)
+              child_to_explore.mAABox = FlatOctreeType::GetChildAABox(node_to_explore.mAABox, child_sequential_index);
+            children_to_explore[num_children_to_explore++] = child_to_explore;
+          });
+
+      // Push them reversed, so that the closest one is popped first
+      nodes_to_explore.insert(nodes_to_explore.end(),
+          std::make_reverse_iterator(children_to_explore.cbegin() + num_children_to_explore),
+          children_to_explore.crend());
+    }
+
+    return mRayQuery.template GetResult<TIntersectMode>();
+  }
+
+  static bool IsTraversed(const NodeToExplore& inNodeToExplore, const ValueType inMaxDistance)
+  {
+    return octree_detail::IsParametricNodeTraversed(inNodeToExplore.mEnterDistances,
+        inNodeToExplore.mExitDistances,
+        inMaxDistance);
+  }
+};
+
+template <EIntersectMode TIntersectMode, typename TPrimitive>
+auto Intersect(const FlatOctree<TPrimitive>& inFlatOctree,
+    const Ray3<ValueType_t<TPrimitive>>& inRay,
+    const ValueType_t<TPrimitive> inMaxDistance)
+{
+  FlatOctreeIntersectHelperStruct<TPrimitive> intersecter { inRay, inMaxDistance };
+  return intersecter.template Intersect<TIntersectMode>(inFlatOctree);
+}
+
+template <EIntersectMode TIntersectMode, typename TPrimitive>
+auto Intersect(const Ray3<ValueType_t<TPrimitive>>& inRay,
+    const FlatOctree<TPrimitive>& inFlatOctree,
+    const ValueType_t<TPrimitive> inMaxDistance)
+{
+  return Intersect<TIntersectMode, TPrimitive>(inFlatOctree, inRay, inMaxDistance);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <ez/AAHyperBox.h>
+#include <ez/MathInitializers.h>
+#include <ez/MathMultiComponent.h>
+#include <ez/Vec.h>
+#include <cstddef>
+
+namespace ez
+{
+
+// Index of a primitive in the primitives pool of a spatial hierarchy (Octree, FlatOctree, LooseOctree, Bvh,
+// DynamicAABBTree)
+using HierarchyPrimitiveIndex = std::size_t;
+
+// Ray hit of the spatial hierarchies, which all share this type so that they can be used interchangeably
+template <typename T>
+struct HierarchyIntersection final
+{
+  T mDistance { Infinity<T>() };                                            // The distance to the intersection
+  HierarchyPrimitiveIndex mPrimitiveIndex { Max<HierarchyPrimitiveIndex>() }; // The intersected primitive index
+
+  HierarchyIntersection() = default;
+  HierarchyIntersection(const T& inDistance, const HierarchyPrimitiveIndex& inPrimitiveIndex)
+      : mDistance { inDistance }, mPrimitiveIndex { inPrimitiveIndex }
+  {
+  }
+};
+
+namespace hierarchy_detail
+{
+  template <typename T>
+  AABox<T> MakeEmptyAABox()
+  {
+    return AABox<T>(All<Vec3<T>>(Infinity<T>()), All<Vec3<T>>(-Infinity<T>()));
+  }
+
+  template <typename T>
+  AABox<T> MakeUnion(const AABox<T>& inLHS, const AABox<T>& inRHS)
+  {
+    return AABox<T>(Min(inLHS.GetMin(), inRHS.GetMin()), Max(inLHS.GetMax(), inRHS.GetMax()));
+  }
+
+  // Half of the box surface area, the cost metric of the Surface Area Heuristic
+  template <typename T>
+  T HalfSurfaceArea(const AABox<T>& inAABox)
+  {
+    const auto size = inAABox.GetSize();
+    return size[0] * size[1] + size[1] * size[2] + size[2] * size[0];
+  }
+}
+}
@@ -11,4 +11,11 @@ enum class EIntersectMode
   ONLY_CHECK,        // Only returns a boolean telling whether they intersect or not.
 };
 DECLARE_FLAGS(EIntersectMode);
+
+// How the 3D line/ray-triangle intersections test whether the hit is inside the triangle
+enum class ETriangleIntersectAlgorithm
+{
+  MOLLER_TRUMBORE, // Fastest. A ray through an edge shared by two triangles can miss both (rounding errors).
+  WATERTIGHT,      // Woop et al., edge tests in ray space. A ray through a shared edge hits at least one triangle.
+};
 }
\ No newline at end of file
@@ -75,7 +75,10 @@ auto Intersect(const Line3<T>& inLine, const Cylinder<T>& inCylinder);
 template <EIntersectMode TIntersectMode, typename T, std::size_t N>
 auto Intersect(const Line<T, N>& inLine, const Capsule<T, N>& inCapsule);
 
-template <EIntersectMode TIntersectMode, typename T, std::size_t N>
+template <EIntersectMode TIntersectMode,
+    ETriangleIntersectAlgorithm TAlgorithm = ETriangleIntersectAlgorithm::MOLLER_TRUMBORE,
+    typename T,
+    std::size_t N>
 auto Intersect(const Line<T, N>& inLine, const Triangle<T, N>& inTriangle);
 
 // Contains
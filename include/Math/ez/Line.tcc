@@ -155,6 +155,93 @@ namespace line_detail
   {
   }
 
+  // Line parameter of the intersection with the triangle (both faces), if any
+  template <ETriangleIntersectAlgorithm TAlgorithm, typename T>
+  std::optional<T> IntersectTriangle3(const Vec3<T>& inOrigin, const Vec3<T>& inDirection, const Triangle3<T>& inTriangle)
+  {
+    if constexpr (TAlgorithm == ETriangleIntersectAlgorithm::MOLLER_TRUMBORE)
+    {
+      const auto edge01 = inTriangle[1] - inTriangle[0];
+      const auto edge02 = inTriangle[2] - inTriangle[0];
+      const auto p = Cross(inDirection, edge02);
+      const auto determinant = Dot(edge01, p);
+      if (determinant == static_cast<T>(0)) // Parallel to the triangle plane
+        return std::nullopt;
+
+      const auto determinant_inverse = (static_cast<T>(1) / determinant);
+      const auto origin_from_point0 = inOrigin - inTriangle[0];
+      const auto u = Dot(origin_from_point0, p) * determinant_inverse;
+      if (u < static_cast<T>(0) || u > static_cast<T>(1))
+        return std::nullopt;
+
+      const auto q = Cross(origin_from_point0, edge01);
+      const auto v = Dot(inDirection, q) * determinant_inverse;
+      if (v < static_cast<T>(0) || u + v > static_cast<T>(1))
+        return std::nullopt;
+
+      return std::make_optional(Dot(edge02, q) * determinant_inverse);
+    }
+    else if constexpr (TAlgorithm == ETriangleIntersectAlgorithm::WATERTIGHT)
+    {
+      // Shear and scale the space so that the line goes along +Z from the origin, then test the edges in 2D
+      const auto abs_direction = Abs(inDirection);
+      const auto z_axis = static_cast<std::size_t>(
+          abs_direction[0] > abs_direction[1] ? (abs_direction[0] > abs_direction[2] ? 0 : 2)
+                                              : (abs_direction[1] > abs_direction[2] ? 1 : 2));
+      auto x_axis = (z_axis + 1) % 3;
+      auto y_axis = (x_axis + 1) % 3;
+      if (inDirection[z_axis] < static_cast<T>(0)) // Keep the winding
+        std::swap(x_axis, y_axis);
+
+      const auto shear_x = inDirection[x_axis] / inDirection[z_axis];
+      const auto shear_y = inDirection[y_axis] / inDirection[z_axis];
+      const auto scale_z = static_cast<T>(1) / inDirection[z_axis];
+
+      std::array<Vec3<T>, 3> points;
+      for (std::size_t i = 0; i < 3; ++i)
+      {
+        const auto point = inTriangle[i] - inOrigin;
+        points[i] = Vec3<T> { point[x_axis] - shear_x * point[z_axis],
+          point[y_axis] - shear_y * point[z_axis],
+          scale_z * point[z_axis] };
+      }
+
+      // Scaled barycentric coordinates, from the signed areas of the edges seen from the line
+      const auto edge_function = [](const Vec3<T>& inLHS, const Vec3<T>& inRHS) {
+        return inLHS[0] * inRHS[1] - inLHS[1] * inRHS[0];
+      };
+      auto u = edge_function(points[2], points[1]);
+      auto v = edge_function(points[0], points[2]);
+      auto w = edge_function(points[1], points[0]);
+      if constexpr (std::is_same_v<T, float>)
+      {
+        // On an edge, float rounding cannot tell the side. Double precision is exact for these products.
+        if (u == 0.0f || v == 0.0f || w == 0.0f)
+        {
+          const auto edge_function_double = [](const Vec3<T>& inLHS, const Vec3<T>& inRHS) {
+            return static_cast<T>(static_cast<double>(inLHS[0]) * static_cast<double>(inRHS[1])
+                - static_cast<double>(inLHS[1]) * static_cast<double>(inRHS[0]));
+          };
+          u = edge_function_double(points[2], points[1]);
+          v = edge_function_double(points[0], points[2]);
+          w = edge_function_double(points[1], points[0]);
+        }
+      }
+
+      const auto has_negative = (u < static_cast<T>(0) || v < static_cast<T>(0) || w < static_cast<T>(0));
+      const auto has_positive = (u > static_cast<T>(0) || v > static_cast<T>(0) || w > static_cast<T>(0));
+      if (has_negative && has_positive)
+        return std::nullopt;
+
+      const auto determinant = u + v + w;
+      if (determinant == static_cast<T>(0))
+        return std::nullopt;
+
+      const auto scaled_distance = u * points[0][2] + v * points[1][2] + w * points[2][2];
+      return std::make_optional(scaled_distance / determinant);
+    }
+  }
+
   template <typename T>
   std::optional<T> GetMinIntersectionDistance(const std::array<std::optional<T>, 1>& inIntersectionDistances)
   {
@@ -496,7 +583,7 @@ auto Intersect(const Line<T, N>& inLine, const Capsule<T, N>& inCapsule)
   }
 }
 
-template <EIntersectMode TIntersectMode, typename T, std::size_t N>
+template <EIntersectMode TIntersectMode, ETriangleIntersectAlgorithm TAlgorithm, typename T, std::size_t N>
 auto Intersect(const Line<T, N>& inLine, const Triangle<T, N>& inTriangle)
 {
   static_assert(TIntersectMode == EIntersectMode::ALL_INTERSECTIONS || TIntersectMode == EIntersectMode::ONLY_CLOSEST
@@ -529,6 +616,18 @@ auto Intersect(const Line<T, N>& inLine, const Triangle<T, N>& inTriangle)
       return intersects;
     }
   }
+  else if constexpr (N == 3)
+  {
+    const auto intersection = line_detail::IntersectTriangle3<TAlgorithm>(inLine.GetOrigin(),
+        Direction(inLine),
+        inTriangle);
+    if constexpr (TIntersectMode == EIntersectMode::ALL_INTERSECTIONS)
+      return std::array { intersection };
+    else if constexpr (TIntersectMode == EIntersectMode::ONLY_CLOSEST)
+      return intersection;
+    else if constexpr (TIntersectMode == EIntersectMode::ONLY_CHECK)
+      return intersection.has_value();
+  }
 }
 
 template <typename T, std::size_t N>
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <ez/AAHyperBox.h>
+#include <ez/IntersectMode.h>
+#include <ez/MathTypeTraits.h>
+#include <ez/Octree.h>
+#include <ez/Span.h>
+#include <array>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace ez
+{
+
+template <typename TPrimitive>
+class LooseOctreeBuilder;
+
+// Octree whose nodes have a loose box, which is their cell box scaled by a looseness factor around its center.
+// Every primitive is stored exactly once, along the path of the cells containing the center of its bounding box: a
+// node over capacity (and above the maximum depth) pushes it down to that child if it fits in the child loose box, and
+// keeps it otherwise. A node under capacity keeps all its primitives, so they are not necessarily in the deepest node
+// they fit in. Internal nodes can have primitives too, and primitives straddling cells (e.g. long thin triangles) are
+// not duplicated down several branches, at the cost of overlapping node boxes.
+template <typename TPrimitive>
+class LooseOctree final
+{
+public:
+  using ValueType = ValueType_t<TPrimitive>;
+  using AABoxType = AABox<ValueType>;
+  using ChildSequentialIndex = typename Octree<TPrimitive>::ChildSequentialIndex;
+  using PrimitiveIndex = typename Octree<TPrimitive>::PrimitiveIndex;
+  using Intersection = typename Octree<TPrimitive>::Intersection;
+
+  LooseOctree() = default;
+  LooseOctree(const Span<TPrimitive>& inPrimitives,
+      const std::size_t inNodesMaxCapacity = 8,
+      const std::size_t inMaxDepth = 8,
+      const ValueType inLooseness = static_cast<ValueType>(2));
+  LooseOctree(const LooseOctree&) = delete;
+  LooseOctree& operator=(const LooseOctree&) = delete;
+  LooseOctree(LooseOctree&&) = default;
+  LooseOctree& operator=(LooseOctree&&) = default;
+
+  const AABoxType& GetAABox() const { return mAABox; }           // Cell box
+  const AABoxType& GetLooseAABox() const { return mLooseAABox; } // Box bounding all the primitives in the subtree
+  const std::vector<TPrimitive>& GetPrimitivesPool() const;      // Only available in top LooseOctree
+  const std::vector<PrimitiveIndex>& GetPrimitivesIndices() const { return mPrimitivesIndices; } // Of this node only
+  const std::array<std::unique_ptr<LooseOctree>, 8>& GetChildren() const { return mChildren; }
+  const LooseOctree* GetChildOctree(const ChildSequentialIndex inChildSequentialIndex) const;
+  bool IsEmpty() const { return mPrimitivesIndices.empty() && IsLeaf(); }
+  bool IsLeaf() const;
+
+private:
+  AABoxType mAABox;
+  AABoxType mLooseAABox;
+  std::optional<std::vector<TPrimitive>> mPrimitivesPool; // Only filled in top LooseOctree
+  std::vector<PrimitiveIndex> mPrimitivesIndices;         // Primitives that do not fit in any child
+  std::array<std::unique_ptr<LooseOctree>, 8> mChildren;
+
+  friend class LooseOctreeBuilder<TPrimitive>;
+};
+
+template <typename TPrimitive>
+class LooseOctreeBuilder final
+{
+public:
+  LooseOctreeBuilder() = delete;
+
+  // Nodes with more than inNodesMaxCapacity primitives push down the ones that fit in their children loose boxes.
+  // inLooseness must be >= 1 (1 is a regular octree, where only the primitives inside a single cell go down).
+  static LooseOctree<TPrimitive> Build(const Span<TPrimitive>& inPrimitives,
+      const std::size_t inNodesMaxCapacity = 8,
+      const std::size_t inMaxDepth = 8,
+      const ValueType_t<TPrimitive> inLooseness = static_cast<ValueType_t<TPrimitive>>(2));
+
+private:
+  static void BuildChildrenRecursive(LooseOctree<TPrimitive>& ioLooseOctree,
+      const std::vector<TPrimitive>& inPrimitivesPool,
+      const std::vector<AABox<ValueType_t<TPrimitive>>>& inPrimitivesAABoxes,
+      const std::size_t inNodesMaxCapacity,
+      const std::size_t inMaxDepth,
+      const std::size_t inCurrentDepth,
+      const ValueType_t<TPrimitive> inLooseness);
+
+  static AABox<ValueType_t<TPrimitive>> MakeLooseAABox(const AABox<ValueType_t<TPrimitive>>& inAABox,
+      const ValueType_t<TPrimitive> inLooseness);
+};
+
+// Intersection functions. Each primitive is tested at most once per query, so ALL_INTERSECTIONS has no repeated hits.
+template <EIntersectMode TIntersectMode, typename TPrimitive>
+auto Intersect(const LooseOctree<TPrimitive>& inLooseOctree,
+    const Ray3<ValueType_t<TPrimitive>>& inRay,
+    const ValueType_t<TPrimitive> inMaxDistance = Infinity<ValueType_t<TPrimitive>>());
+
+template <EIntersectMode TIntersectMode, typename TPrimitive>
+auto Intersect(const Ray3<ValueType_t<TPrimitive>>& inRay,
+    const LooseOctree<TPrimitive>& inLooseOctree,
+    const ValueType_t<TPrimitive> inMaxDistance = Infinity<ValueType_t<TPrimitive>>());
+}
+
+#include "ez/LooseOctree.tcc"
\ No newline at end of file
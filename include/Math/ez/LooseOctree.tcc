@@ -0,0 +1,264 @@
+#include <ez/BinaryIndex.h>
+#include <ez/LooseOctree.h>
+#include <ez/Macros.h>
+#include <ez/Ray.h>
+#include <ez/RayQueryHelper.h>
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+namespace ez
+{
+
+template <typename TPrimitive>
+LooseOctree<TPrimitive>::LooseOctree(const Span<TPrimitive>& inPrimitives,
+    const std::size_t inNodesMaxCapacity,
+    const std::size_t inMaxDepth,
+    const ValueType inLooseness)
+{
+  *this = LooseOctreeBuilder<TPrimitive>::Build(inPrimitives, inNodesMaxCapacity, inMaxDepth, inLooseness);
+}
+
+template <typename TPrimitive>
+const std::vector<TPrimitive>& LooseOctree<TPrimitive>::GetPrimitivesPool() const
+{
+  EXPECTS(mPrimitivesPool);
+  return *mPrimitivesPool;
+}
+
+template <typename TPrimitive>
+const LooseOctree<TPrimitive>* LooseOctree<TPrimitive>::GetChildOctree(
+    const ChildSequentialIndex inChildSequentialIndex) const
+{
+  EXPECTS(inChildSequentialIndex < 8);
+  return mChildren[inChildSequentialIndex].get();
+}
+
+template <typename TPrimitive>
+bool LooseOctree<TPrimitive>::IsLeaf() const
+{
+  return std::all_of(mChildren.cbegin(), mChildren.cend(), [](const auto& child) { return child == nullptr; });
+}
+
+template <typename TPrimitive>
+LooseOctree<TPrimitive> LooseOctreeBuilder<TPrimitive>::Build(const Span<TPrimitive>& inPrimitives,
+    const std::size_t inNodesMaxCapacity,
+    const std::size_t inMaxDepth,
+    const ValueType_t<TPrimitive> inLooseness)
+{
+  EXPECTS(inLooseness >= static_cast<ValueType_t<TPrimitive>>(1));
+
+  // The top cell bounds all the primitives, so it does not need to be loose
+  LooseOctree<TPrimitive> loose_octree;
+  loose_octree.mAABox = BoundingAAHyperBox(inPrimitives);
+  loose_octree.mLooseAABox = loose_octree.mAABox;
+  loose_octree.mPrimitivesPool = std::make_optional<std::vector<TPrimitive>>(inPrimitives.cbegin(), inPrimitives.cend());
+
+  const auto& primitives_pool = *loose_octree.mPrimitivesPool;
+  std::vector<AABox<ValueType_t<TPrimitive>>> primitives_aaboxes;
+  primitives_aaboxes.reserve(primitives_pool.size());
+  for (const auto& primitive : primitives_pool) primitives_aaboxes.push_back(BoundingAAHyperBox(primitive));
+
+  loose_octree.mPrimitivesIndices.resize(primitives_pool.size());
+  std::iota(loose_octree.mPrimitivesIndices.begin(), loose_octree.mPrimitivesIndices.end(), 0);
+
+  BuildChildrenRecursive(loose_octree,
+      primitives_pool,
+      primitives_aaboxes,
+      inNodesMaxCapacity,
+      inMaxDepth,
+      0,
+      inLooseness);
+  return loose_octree;
+}
+
+template <typename TPrimitive>
+void LooseOctreeBuilder<TPrimitive>::BuildChildrenRecursive(LooseOctree<TPrimitive>& ioLooseOctree,
+    const std::vector<TPrimitive>& inPrimitivesPool,
+    const std::vector<AABox<ValueType_t<TPrimitive>>>& inPrimitivesAABoxes,
+    const std::size_t inNodesMaxCapacity,
+    const std::size_t inMaxDepth,
+    const std::size_t inCurrentDepth,
+    const ValueType_t<TPrimitive> inLooseness)
+{
+  using LooseOctreeType = LooseOctree<TPrimitive>;
+  using ValueType = ValueType_t<TPrimitive>;
+  using PrimitiveIndex = typename LooseOctreeType::PrimitiveIndex;
+
+  if (ioLooseOctree.mPrimitivesIndices.size() <= inNodesMaxCapacity || inCurrentDepth >= inMaxDepth)
+    return;
+
+  const auto& aabox = ioLooseOctree.mAABox;
+  const auto aabox_center = aabox.GetCenter();
+  const auto child_aabox_size = (aabox.GetSize() / static_cast<ValueType>(2));
+  std::array<AABox<ValueType>, 8> children_aaboxes;
+  std::array<AABox<ValueType>, 8> children_loose_aaboxes;
+  for (std::size_t i = 0; i < 8; ++i)
+  {
+    const auto child_aabox_min = aabox.GetMin() + child_aabox_size * MakeBinaryIndex<3, ValueType>(i);
+    children_aaboxes[i] = AABox<ValueType>(child_aabox_min, child_aabox_min + child_aabox_size);
+    children_loose_aaboxes[i] = MakeLooseAABox(children_aaboxes[i], inLooseness);
+  }
+
+  // Each primitive goes to the child cell containing its center, if it fits inside that child loose box
+  std::array<std::vector<PrimitiveIndex>, 8> children_primitives_indices;
+  std::vector<PrimitiveIndex> remaining_primitives_indices;
+  for (const auto& primitive_index : ioLooseOctree.mPrimitivesIndices)
+  {
+    const auto& primitive_aabox = inPrimitivesAABoxes[primitive_index];
+    const auto primitive_center = primitive_aabox.GetCenter();
+    typename LooseOctreeType::ChildSequentialIndex child_sequential_index = 0;
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+      if (primitive_center[i] >= aabox_center[i])
+        child_sequential_index |= (static_cast<typename LooseOctreeType::ChildSequentialIndex>(1) << (2 - i));
+    }
+
+    if (Contains(children_loose_aaboxes[child_sequential_index], primitive_aabox))
+      children_primitives_indices[child_sequential_index].push_back(primitive_index);
+    else
+      remaining_primitives_indices.push_back(primitive_index);
+  }
+
+  remaining_primitives_indices.shrink_to_fit();
+  ioLooseOctree.mPrimitivesIndices = std::move(remaining_primitives_indices);
+
+  for (std::size_t i = 0; i < 8; ++i)
+  {
+    if (children_primitives_indices[i].empty())
+      continue;
+
+    auto child_loose_octree = std::make_unique<LooseOctreeType>();
+    child_loose_octree->mAABox = children_aaboxes[i];
+    child_loose_octree->mLooseAABox = children_loose_aaboxes[i];
+    child_loose_octree->mPrimitivesIndices = std::move(children_primitives_indices[i]);
+    BuildChildrenRecursive(*child_loose_octree,
+        inPrimitivesPool,
+        inPrimitivesAABoxes,
+        inNodesMaxCapacity,
+        inMaxDepth,
+        inCurrentDepth + 1,
+        inLooseness);
+    ioLooseOctree.mChildren[i] = std::move(child_loose_octree);
+  }
+}
+
+template <typename TPrimitive>
+AABox<ValueType_t<TPrimitive>> LooseOctreeBuilder<TPrimitive>::MakeLooseAABox(
+    const AABox<ValueType_t<TPrimitive>>& inAABox,
+    const ValueType_t<TPrimitive> inLooseness)
+{
+  const auto loose_half_size = (inAABox.GetSize() * (inLooseness / static_cast<ValueType_t<TPrimitive>>(2)));
+  const auto center = inAABox.GetCenter();
+  return AABox<ValueType_t<TPrimitive>>(center - loose_half_size, center + loose_half_size);
+}
+
+template <typename TPrimitive>
+struct LooseOctreeIntersectHelperStruct final
+{
+  using LooseOctreeType = LooseOctree<TPrimitive>;
+  using ValueType = ValueType_t<TPrimitive>;
+
+  struct NodeToExplore final
+  {
+    const LooseOctreeType* mLooseOctree = nullptr;
+    ValueType mEnterDistance = static_cast<ValueType>(0);
+  };
+
+  ray_query_detail::RayQueryHelper<TPrimitive> mRayQuery;
+
+  LooseOctreeIntersectHelperStruct(const Ray3<ValueType>& inRay, const ValueType& inMaxDistance)
+      : mRayQuery { inRay, inMaxDistance }
+  {
+  }
+
+  template <EIntersectMode TIntersectMode>
+  auto Intersect(const LooseOctreeType& inTopLooseOctree)
+  {
+    static_assert(TIntersectMode == EIntersectMode::ALL_INTERSECTIONS || TIntersectMode == EIntersectMode::ONLY_CLOSEST
+            || TIntersectMode == EIntersectMode::ONLY_CHECK,
+        "Unsupported EIntersectMode");
+
+    std::vector<NodeToExplore> nodes_to_explore;
+    if (!inTopLooseOctree.IsEmpty())
+    {
+      if (const auto top_enter_distance = mRayQuery.GetEnterDistance(inTopLooseOctree.GetLooseAABox()))
+        nodes_to_explore.push_back({ &inTopLooseOctree, *top_enter_distance });
+    }
+
+    const auto& primitives_pool = inTopLooseOctree.GetPrimitivesPool();
+    while (!nodes_to_explore.empty())
+    {
+      const auto node_to_explore = nodes_to_explore.back();
+      nodes_to_explore.pop_back();
+
+      // Loose boxes overlap, so a node behind the closest intersection found so far is skipped, but not the next ones
+      if constexpr (TIntersectMode == EIntersectMode::ONLY_CLOSEST)
+      {
+        if (node_to_explore.mEnterDistance > mRayQuery.template GetCullDistance<TIntersectMode>())
+          continue;
+      }
+
+      // Primitives stored in this node, internal or not
+      const auto& loose_octree = *node_to_explore.mLooseOctree;
+      for (const auto& primitive_index : loose_octree.GetPrimitivesIndices())
+      {
+        const auto& primitive = primitives_pool[primitive_index];
+        if constexpr (TIntersectMode == EIntersectMode::ONLY_CHECK)
+        {
+          if (mRayQuery.template IntersectPrimitive<TIntersectMode>(primitive_index, primitive))
+            return true;
+        }
+        else
+        {
+          mRayQuery.template IntersectPrimitive<TIntersectMode>(primitive_index, primitive);
+        }
+      }
+
+      // Push the intersected children so that the closest one gets explored first. They are kept sorted by decreasing
+      // enter distance as they come (small insertion sort).
+      std::array<NodeToExplore, 8> children_to_explore;
+      std::size_t num_children_to_explore = 0;
+      for (const auto& child_loose_octree : loose_octree.GetChildren())
+      {
+        if (!child_loose_octree)
+          continue;
+
+        const auto child_enter_distance = mRayQuery.GetEnterDistance(child_loose_octree->GetLooseAABox());
+        if (!child_enter_distance)
+          continue;
+
+        auto insert_index = num_children_to_explore++;
+        for (; insert_index > 0 && children_to_explore[insert_index - 1].mEnterDistance < *child_enter_distance;
+             --insert_index)
+          children_to_explore[insert_index] = children_to_explore[insert_index - 1];
+        children_to_explore[insert_index] = { child_loose_octree.get(), *child_enter_distance };
+      }
+
+      nodes_to_explore.insert(nodes_to_explore.end(),
+          children_to_explore.cbegin(),
+          children_to_explore.cbegin() + num_children_to_explore);
+    }
+
+    return mRayQuery.template GetResult<TIntersectMode>();
+  }
+};
+
+template <EIntersectMode TIntersectMode, typename TPrimitive>
+auto Intersect(const LooseOctree<TPrimitive>& inLooseOctree,
+    const Ray3<ValueType_t<TPrimitive>>& inRay,
+    const ValueType_t<TPrimitive> inMaxDistance)
+{
+  LooseOctreeIntersectHelperStruct<TPrimitive> intersecter { inRay, inMaxDistance };
+  return intersecter.template Intersect<TIntersectMode>(inLooseOctree);
+}
+
+template <EIntersectMode TIntersectMode, typename TPrimitive>
+auto Intersect(const Ray3<ValueType_t<TPrimitive>>& inRay,
+    const LooseOctree<TPrimitive>& inLooseOctree,
+    const ValueType_t<TPrimitive> inMaxDistance)
+{
+  return Intersect<TIntersectMode, TPrimitive>(inLooseOctree, inRay, inMaxDistance);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <ez/FlatOctree.h>
+#include <ez/IntersectMode.h>
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <type_traits>
+
+namespace ez
+{
+
+// Binary file with a FlatOctree, meant to be memory-mapped and queried in place.
+// All offsets are from the beginning of the file, so the file is relocatable. Sections are aligned to
+// SectionAlignment, in this order:
+//   - MappedFlatOctreeFileHeader
+//   - Nodes: mNumNodes x FlatOctree::Node
+//   - Primitives indices: mNumPrimitivesIndices x FlatOctree::CompactPrimitiveIndex
+//   - Primitives pool: mNumPrimitives x TPrimitive
+// Primitives and nodes are stored as their raw bytes, so the file can only be opened on a platform with the same
+// endianness and type layouts (which is checked when opening it).
+struct MappedFlatOctreeFileHeader final
+{
+  static constexpr std::array<char, 8> MagicNumber = { 'E', 'Z', 'O', 'C', 'T', 'R', 'E', 'E' };
+  static constexpr uint32_t CurrentVersion = 1;
+  static constexpr uint32_t EndiannessCheck = 0x01020304;
+  static constexpr uint64_t SectionAlignment = 64;
+
+  std::array<char, 8> mMagicNumber = MagicNumber;
+  uint32_t mVersion = CurrentVersion;
+  uint32_t mEndiannessCheck = EndiannessCheck;
+  uint32_t mValueTypeSize = 0;
+  uint32_t mPrimitiveSize = 0;
+  uint32_t mPrimitiveAlignment = 0;
+  uint32_t mNodeSize = 0;
+  std::array<double, 3> mAABoxMin {};
+  std::array<double, 3> mAABoxMax {};
+  uint64_t mMaxDepth = 0;
+  uint64_t mNumNodes = 0;
+  uint64_t mNodesOffset = 0;
+  uint64_t mNumPrimitivesIndices = 0;
+  uint64_t mPrimitivesIndicesOffset = 0;
+  uint64_t mNumPrimitives = 0;
+  uint64_t mPrimitivesOffset = 0;
+  uint64_t mFileSize = 0;
+};
+
+// Returns false if the file could not be written
+template <typename TPrimitive>
+bool SaveMappableOctree(const FlatOctree<TPrimitive>& inFlatOctree, const std::filesystem::path& inFilePath);
+
+template <typename TPrimitive>
+bool SaveMappableOctree(const Octree<TPrimitive>& inOctree, const std::filesystem::path& inFilePath);
+
+// Read-only FlatOctree living in a memory-mapped file written with SaveMappableOctree.
+// Opening it does not allocate the octree contents, and several processes mapping the same file share the same physical
+// memory. Only the header is read when opening it, the other pages are loaded lazily by the OS as queries touch them.
+// Queries check the children and leaves ranges of the nodes they read, so a corrupted file can not make them read
+// outside of the mapping. Validate checks the whole octree data up front instead.
+template <typename TPrimitive>
+class MappedFlatOctree final
+{
+public:
+  static_assert(std::is_trivially_copyable_v<TPrimitive>, "MappedFlatOctree primitives must be trivially copyable");
+
+  using FlatOctreeType = FlatOctree<TPrimitive>;
+  using ValueType = typename FlatOctreeType::ValueType;
+  using AABoxType = typename FlatOctreeType::AABoxType;
+  using PrimitiveIndex = typename FlatOctreeType::PrimitiveIndex;
+  using CompactPrimitiveIndex = typename FlatOctreeType::CompactPrimitiveIndex;
+  using Intersection = typename FlatOctreeType::Intersection;
+  using Node = typename FlatOctreeType::Node;
+
+  // Returns std::nullopt if the file can not be mapped, or if its header is not valid for this TPrimitive (including
+  // the sections bounds)
+  static std::optional<MappedFlatOctree> Open(const std::filesystem::path& inFilePath);
+
+  MappedFlatOctree(const MappedFlatOctree&) = delete;
+  MappedFlatOctree& operator=(const MappedFlatOctree&) = delete;
+  MappedFlatOctree(MappedFlatOctree&& ioRHS) noexcept;
+  MappedFlatOctree& operator=(MappedFlatOctree&& ioRHS) noexcept;
+  ~MappedFlatOctree();
+
+  const AABoxType& GetAABox() const { return mAABox; }
+  std::span<const TPrimitive> GetPrimitivesPool() const { return mPrimitivesPool; }
+  std::span<const CompactPrimitiveIndex> GetPrimitivesIndices() const { return mPrimitivesIndices; }
+  std::span<const Node> GetNodes() const { return mNodes; }
+  std::size_t GetMaxDepth() const { return mMaxDepth; }
+  bool IsEmpty() const { return mNodes.empty(); }
+
+  // Whether all the children ranges, leaves ranges and primitives indices are in range, for files from untrusted
+  // sources. It is a full pass over the nodes and primitives indices sections, so it reads all their pages.
+  bool Validate() const;
+
+private:
+  MappedFlatOctree() = default;
+  void Unmap();
+
+  void* mMappedData = nullptr;
+  std::size_t mMappedSize = 0;
+  AABoxType mAABox;
+  std::span<const Node> mNodes;
+  std::span<const CompactPrimitiveIndex> mPrimitivesIndices;
+  std::span<const TPrimitive> mPrimitivesPool;
+  std::size_t mMaxDepth = 0;
+};
+
+// Intersection functions
+template <EIntersectMode TIntersectMode, typename TPrimitive>
+auto Intersect(const MappedFlatOctree<TPrimitive>& inMappedFlatOctree,
+    const Ray3<ValueType_t<TPrimitive>>& inRay,
+    const ValueType_t<TPrimitive> inMaxDistance = Infinity<ValueType_t<TPrimitive>>());
+
+template <EIntersectMode TIntersectMode, typename TPrimitive>
+auto Intersect(const Ray3<ValueType_t<TPrimitive>>& inRay,
+    const MappedFlatOctree<TPrimitive>& inMappedFlatOctree,
+    const ValueType_t<TPrimitive> inMaxDistance = Infinity<ValueType_t<TPrimitive>>());
+}
+
+#include "ez/MappedFlatOctree.tcc"
\ No newline at end of file
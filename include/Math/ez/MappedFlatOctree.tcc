@@ -0,0 +1,271 @@
+#include <ez/Macros.h>
+#include <ez/MappedFlatOctree.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define EZ_MAPPED_FLAT_OCTREE_HAS_MMAP 1
+#else
+#define EZ_MAPPED_FLAT_OCTREE_HAS_MMAP 0
+#endif
+
+namespace ez
+{
+
+namespace mapped_flat_octree_detail
+{
+  inline uint64_t AlignOffset(const uint64_t inOffset)
+  {
+    constexpr auto Alignment = MappedFlatOctreeFileHeader::SectionAlignment;
+    return ((inOffset + Alignment - 1) / Alignment) * Alignment;
+  }
+
+  template <typename TPrimitive>
+  MappedFlatOctreeFileHeader MakeFileHeader()
+  {
+    MappedFlatOctreeFileHeader header;
+    header.mValueTypeSize = static_cast<uint32_t>(sizeof(ValueType_t<TPrimitive>));
+    header.mPrimitiveSize = static_cast<uint32_t>(sizeof(TPrimitive));
+    header.mPrimitiveAlignment = static_cast<uint32_t>(alignof(TPrimitive));
+    header.mNodeSize = static_cast<uint32_t>(sizeof(typename FlatOctree<TPrimitive>::Node));
+    return header;
+  }
+
+  // Checks that the section [inOffset, inOffset + inNumElements * inElementSize) is aligned and inside the file
+  inline bool IsValidSection(const uint64_t inOffset,
+      const uint64_t inNumElements,
+      const uint64_t inElementSize,
+      const uint64_t inFileSize)
+  {
+    if (inOffset % MappedFlatOctreeFileHeader::SectionAlignment != 0 || inOffset > inFileSize)
+      return false;
+    return inElementSize == 0 || inNumElements <= (inFileSize - inOffset) / inElementSize;
+  }
+
+  // Checks, in a single pass over the nodes and the primitives indices, that the children ranges, the leaves ranges and
+  // the primitives indices are all in range
+  template <typename TNode, typename TCompactPrimitiveIndex>
+  bool IsValidOctreeData(const std::span<const TNode>& inNodes,
+      const std::span<const TCompactPrimitiveIndex>& inPrimitivesIndices,
+      const uint64_t inNumPrimitives)
+  {
+    for (std::size_t node_index = 0; node_index < inNodes.size(); ++node_index)
+    {
+      if (!inNodes[node_index].HasValidRanges(node_index, inNodes.size(), inPrimitivesIndices.size()))
+        return false;
+    }
+
+    return std::all_of(inPrimitivesIndices.begin(),
+        inPrimitivesIndices.end(),
+        [&](const auto& inPrimitiveIndex) { return static_cast<uint64_t>(inPrimitiveIndex) < inNumPrimitives; });
+  }
+
+  template <typename T>
+  void WriteSection(std::ofstream& ioFileStream, const uint64_t inOffset, const T* inData, const uint64_t inNumElements)
+  {
+    const auto current_offset = static_cast<uint64_t>(ioFileStream.tellp());
+    EXPECTS(current_offset <= inOffset);
+    constexpr std::array<char, MappedFlatOctreeFileHeader::SectionAlignment> Padding {};
+    ioFileStream.write(Padding.data(), static_cast<std::streamsize>(inOffset - current_offset));
+    if (inNumElements > 0)
+    {
+      ioFileStream.write(reinterpret_cast<const char*>(inData),
+          static_cast<std::streamsize>(inNumElements * sizeof(T)));
+    }
+  }
+}
+
+template <typename TPrimitive>
+bool SaveMappableOctree(const FlatOctree<TPrimitive>& inFlatOctree, const std::filesystem::path& inFilePath)
+{
+  static_assert(std::is_trivially_copyable_v<TPrimitive>, "Mappable octree primitives must be trivially copyable");
+  using FlatOctreeType = FlatOctree<TPrimitive>;
+  using Node = typename FlatOctreeType::Node;
+  using CompactPrimitiveIndex = typename FlatOctreeType::CompactPrimitiveIndex;
+  using namespace mapped_flat_octree_detail;
+
+  const auto& nodes = inFlatOctree.GetNodes();
+  const auto& primitives_indices = inFlatOctree.GetPrimitivesIndices();
+  const auto& primitives_pool = inFlatOctree.GetPrimitivesPool();
+
+  auto header = MakeFileHeader<TPrimitive>();
+  for (std::size_t i = 0; i < 3; ++i)
+  {
+    header.mAABoxMin[i] = static_cast<double>(inFlatOctree.GetAABox().GetMin()[i]);
+    header.mAABoxMax[i] = static_cast<double>(inFlatOctree.GetAABox().GetMax()[i]);
+  }
+  header.mMaxDepth = inFlatOctree.GetMaxDepth();
+  header.mNumNodes = nodes.size();
+  header.mNodesOffset = AlignOffset(sizeof(MappedFlatOctreeFileHeader));
+  header.mNumPrimitivesIndices = primitives_indices.size();
+  header.mPrimitivesIndicesOffset = AlignOffset(header.mNodesOffset + nodes.size() * sizeof(Node));
+  header.mNumPrimitives = primitives_pool.size();
+  header.mPrimitivesOffset = AlignOffset(
+      header.mPrimitivesIndicesOffset + primitives_indices.size() * sizeof(CompactPrimitiveIndex));
+  header.mFileSize = header.mPrimitivesOffset + primitives_pool.size() * sizeof(TPrimitive);
+
+  std::ofstream file_stream { inFilePath, std::ios::binary | std::ios::trunc };
+  if (!file_stream)
+    return false;
+
+  WriteSection(file_stream, 0, &header, 1);
+  WriteSection(file_stream, header.mNodesOffset, nodes.data(), header.mNumNodes);
+  WriteSection(file_stream, header.mPrimitivesIndicesOffset, primitives_indices.data(), header.mNumPrimitivesIndices);
+  WriteSection(file_stream, header.mPrimitivesOffset, primitives_pool.data(), header.mNumPrimitives);
+  file_stream.flush();
+  return static_cast<bool>(file_stream);
+}
+
+template <typename TPrimitive>
+bool SaveMappableOctree(const Octree<TPrimitive>& inOctree, const std::filesystem::path& inFilePath)
+{
+  return SaveMappableOctree(FlatOctree<TPrimitive> { inOctree }, inFilePath);
+}
+
+template <typename TPrimitive>
+std::optional<MappedFlatOctree<TPrimitive>> MappedFlatOctree<TPrimitive>::Open(const std::filesystem::path& inFilePath)
+{
+#if EZ_MAPPED_FLAT_OCTREE_HAS_MMAP
+  using namespace mapped_flat_octree_detail;
+
+  const auto file_descriptor = ::open(inFilePath.c_str(), O_RDONLY);
+  if (file_descriptor < 0)
+    return std::nullopt;
+
+  struct stat file_stat;
+  const auto stat_result = ::fstat(file_descriptor, &file_stat);
+  const auto file_size = (stat_result == 0) ? static_cast<uint64_t>(file_stat.st_size) : 0;
+  void* mapped_data = nullptr;
+  if (file_size >= sizeof(MappedFlatOctreeFileHeader))
+  {
+    mapped_data = ::mmap(nullptr, file_size, PROT_READ, MAP_SHARED, file_descriptor, 0);
+    if (mapped_data == MAP_FAILED)
+      mapped_data = nullptr;
+  }
+  ::close(file_descriptor); // The mapping keeps its own reference to the file
+  if (!mapped_data)
+    return std::nullopt;
+
+  MappedFlatOctree mapped_flat_octree;
+  mapped_flat_octree.mMappedData = mapped_data;
+  mapped_flat_octree.mMappedSize = file_size;
+
+  MappedFlatOctreeFileHeader header;
+  std::memcpy(&header, mapped_data, sizeof(MappedFlatOctreeFileHeader));
+  const auto expected_header = MakeFileHeader<TPrimitive>();
+  const auto is_valid_header = (header.mMagicNumber == expected_header.mMagicNumber)
+      && (header.mVersion == expected_header.mVersion) && (header.mEndiannessCheck == expected_header.mEndiannessCheck)
+      && (header.mValueTypeSize == expected_header.mValueTypeSize)
+      && (header.mPrimitiveSize == expected_header.mPrimitiveSize)
+      && (header.mPrimitiveAlignment == expected_header.mPrimitiveAlignment)
+      && (header.mNodeSize == expected_header.mNodeSize) && (header.mFileSize == file_size)
+      && (header.mMaxDepth <= header.mNumNodes)
+      && IsValidSection(header.mNodesOffset, header.mNumNodes, sizeof(Node), file_size)
+      && IsValidSection(header.mPrimitivesIndicesOffset,
+          header.mNumPrimitivesIndices,
+          sizeof(CompactPrimitiveIndex),
+          file_size)
+      && IsValidSection(header.mPrimitivesOffset, header.mNumPrimitives, sizeof(TPrimitive), file_size);
+  if (!is_valid_header)
+    return std::nullopt; // Unmapped by the destructor
+
+  // mmap returns page-aligned memory and sections are aligned within the file, so the sections can be used in place
+  const auto mapped_bytes = static_cast<const std::byte*>(mapped_data);
+  mapped_flat_octree.mNodes = std::span<const Node> {
+    reinterpret_cast<const Node*>(mapped_bytes + header.mNodesOffset), static_cast<std::size_t>(header.mNumNodes)
+  };
+  mapped_flat_octree.mPrimitivesIndices = std::span<const CompactPrimitiveIndex> {
+    reinterpret_cast<const CompactPrimitiveIndex*>(mapped_bytes + header.mPrimitivesIndicesOffset),
+    static_cast<std::size_t>(header.mNumPrimitivesIndices)
+  };
+  mapped_flat_octree.mPrimitivesPool = std::span<const TPrimitive> {
+    reinterpret_cast<const TPrimitive*>(mapped_bytes + header.mPrimitivesOffset),
+    static_cast<std::size_t>(header.mNumPrimitives)
+  };
+  mapped_flat_octree.mAABox = AABoxType(
+      Vec3<ValueType> { static_cast<ValueType>(header.mAABoxMin[0]),
+          static_cast<ValueType>(header.mAABoxMin[1]),
+          static_cast<ValueType>(header.mAABoxMin[2]) },
+      Vec3<ValueType> { static_cast<ValueType>(header.mAABoxMax[0]),
+          static_cast<ValueType>(header.mAABoxMax[1]),
+          static_cast<ValueType>(header.mAABoxMax[2]) });
+  mapped_flat_octree.mMaxDepth = static_cast<std::size_t>(header.mMaxDepth);
+  return std::make_optional(std::move(mapped_flat_octree));
+#else
+  (void)inFilePath;
+  return std::nullopt; // Memory mapping not supported on this platform
+#endif
+}
+
+template <typename TPrimitive>
+bool MappedFlatOctree<TPrimitive>::Validate() const
+{
+  return mapped_flat_octree_detail::IsValidOctreeData(mNodes,
+      mPrimitivesIndices,
+      static_cast<uint64_t>(mPrimitivesPool.size()));
+}
+
+template <typename TPrimitive>
+MappedFlatOctree<TPrimitive>::MappedFlatOctree(MappedFlatOctree&& ioRHS) noexcept
+{
+  *this = std::move(ioRHS);
+}
+
+template <typename TPrimitive>
+MappedFlatOctree<TPrimitive>& MappedFlatOctree<TPrimitive>::operator=(MappedFlatOctree&& ioRHS) noexcept
+{
+  if (this == &ioRHS)
+    return *this;
+
+  Unmap();
+  mMappedData = std::exchange(ioRHS.mMappedData, nullptr);
+  mMappedSize = std::exchange(ioRHS.mMappedSize, 0);
+  mAABox = ioRHS.mAABox;
+  mNodes = std::exchange(ioRHS.mNodes, {});
+  mPrimitivesIndices = std::exchange(ioRHS.mPrimitivesIndices, {});
+  mPrimitivesPool = std::exchange(ioRHS.mPrimitivesPool, {});
+  mMaxDepth = std::exchange(ioRHS.mMaxDepth, 0);
+  return *this;
+}
+
+template <typename TPrimitive>
+MappedFlatOctree<TPrimitive>::~MappedFlatOctree()
+{
+  Unmap();
+}
+
+template <typename TPrimitive>
+void MappedFlatOctree<TPrimitive>::Unmap()
+{
+#if EZ_MAPPED_FLAT_OCTREE_HAS_MMAP
+  if (mMappedData)
+    ::munmap(mMappedData, mMappedSize);
+#endif
+  mMappedData = nullptr;
+  mMappedSize = 0;
+}
+
+template <EIntersectMode TIntersectMode, typename TPrimitive>
+auto Intersect(const MappedFlatOctree<TPrimitive>& inMappedFlatOctree,
+    const Ray3<ValueType_t<TPrimitive>>& inRay,
+    const ValueType_t<TPrimitive> inMaxDistance)
+{
+  FlatOctreeIntersectHelperStruct<TPrimitive> intersecter { inRay, inMaxDistance };
+  return intersecter.template Intersect<TIntersectMode>(inMappedFlatOctree);
+}
+
+template <EIntersectMode TIntersectMode, typename TPrimitive>
+auto Intersect(const Ray3<ValueType_t<TPrimitive>>& inRay,
+    const MappedFlatOctree<TPrimitive>& inMappedFlatOctree,
+    const ValueType_t<TPrimitive> inMaxDistance)
+{
+  return Intersect<TIntersectMode, TPrimitive>(inMappedFlatOctree, inRay, inMaxDistance);
+}
+
+}
\ No newline at end of file
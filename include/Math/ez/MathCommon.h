@@ -5,9 +5,11 @@
 #include <ez/MathMultiComponent.h>
 #include <ez/MathRandom.h>
 #include <ez/MathTypeTraits.h>
+#include <ez/VecSIMD.h>
 #include <cmath>
 #include <cstdint>
 #include <tuple>
+#include <type_traits>
 
 namespace ez
 {
@@ -20,6 +22,12 @@ constexpr auto Dot(const T& inLHS, const T& inRHS)
   }
   else
   {
+    if constexpr (vec_simd_detail::IsSIMDVec_v<T>)
+    {
+      if (!std::is_constant_evaluated())
+        return vec_simd_detail::Dot(inLHS, inRHS);
+    }
+
     auto dot = static_cast<ValueType_t<T>>(0);
     for (std::size_t i = 0; i < NumComponents_v<T>; ++i) { dot += inLHS[i] * inRHS[i]; }
     return dot;
@@ -102,6 +102,15 @@ using Ray3 = Ray<T, 3>;
 using Ray3f = Ray3<float>;
 using Ray3d = Ray3<double>;
 
+// PrecomputedRay
+template <typename T, std::size_t N>
+class PrecomputedRay;
+
+template <typename T>
+using PrecomputedRay3 = PrecomputedRay<T, 3>;
+using PrecomputedRay3f = PrecomputedRay3<float>;
+using PrecomputedRay3d = PrecomputedRay3<double>;
+
 // Line
 template <typename T, std::size_t N>
 class Line;
@@ -227,6 +236,30 @@ using Boxd = Box<double>;
 template <typename TPrimitive>
 class Octree;
 
+template <typename TPrimitive>
+class FlatOctree;
+
+template <typename TPrimitive>
+class MappedFlatOctree;
+
+template <typename TPrimitive>
+class LooseOctree;
+
+// Bvh
+template <typename TPrimitive>
+class Bvh;
+
+template <typename TPrimitive>
+class DynamicAABBTree;
+
+// SpatialHashGrid
+template <typename TPrimitive, std::size_t N>
+class SpatialHashGrid;
+
+// SweepAndPrune
+template <typename T, std::size_t N>
+class SweepAndPrune;
+
 // Segment
 template <typename T, std::size_t N>
 class Segment;
@@ -276,6 +309,13 @@ template <typename T>
 using Triangle3 = Triangle<T, 3>;
 using Triangle3f = Triangle3<float>;
 
+// TriangleAccel
+template <typename T>
+class TriangleAccel;
+
+using TriangleAccelf = TriangleAccel<float>;
+using TriangleAcceld = TriangleAccel<double>;
+
 // Color
 template <typename T, ::std::size_t N>
 using Color = Vec<T, N>;
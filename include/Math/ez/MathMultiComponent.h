@@ -2,9 +2,11 @@
 
 #include <ez/MathInitializers.h>
 #include <ez/MathTypeTraits.h>
+#include <ez/VecSIMD.h>
 #include <array>
 #include <cmath>
 #include <limits>
+#include <type_traits>
 
 namespace ez
 {
@@ -81,6 +83,11 @@ constexpr auto Abs(const T& inValue)
   }
   else
   {
+    if constexpr (vec_simd_detail::IsSIMDVec_v<T>)
+    {
+      if (!std::is_constant_evaluated())
+        return vec_simd_detail::Abs(inValue);
+    }
     return MathMultiComponentApplied<T, Abs<ValueType_t<T>>>(inValue);
   }
 }
@@ -325,6 +332,11 @@ constexpr auto Min(const T& inLHS, const T& inRHS)
   }
   else
   {
+    if constexpr (vec_simd_detail::IsSIMDVec_v<T>)
+    {
+      if (!std::is_constant_evaluated())
+        return vec_simd_detail::Min(inLHS, inRHS);
+    }
     return MathMultiComponentApplied<T, Min<ValueType_t<T>>>(inLHS, inRHS);
   }
 }
@@ -419,6 +431,11 @@ constexpr auto Max(const T& inLHS, const T& inRHS)
   }
   else
   {
+    if constexpr (vec_simd_detail::IsSIMDVec_v<T>)
+    {
+      if (!std::is_constant_evaluated())
+        return vec_simd_detail::Max(inLHS, inRHS);
+    }
     return MathMultiComponentApplied<T, Max<ValueType_t<T>>>(inLHS, inRHS);
   }
 }
@@ -2,8 +2,11 @@
 
 #include <ez/AAHyperBox.h>
 #include <ez/BinaryIndex.h>
+#include <ez/HierarchyCommon.h>
 #include <ez/IntersectMode.h>
 #include <ez/MathTypeTraits.h>
+#include <ez/ParallelPolicy.h>
+#include <ez/RayPacket.h>
 #include <ez/Span.h>
 #include <array>
 #include <memory>
@@ -16,6 +19,46 @@ namespace ez
 template <typename TPrimitive>
 class OctreeBuilder;
 
+template <typename TPrimitive>
+class OctreeMortonBuilder;
+
+// How Intersect(Octree, Ray) walks the octree nodes
+enum class EOctreeTraversalMode
+{
+  PLANES,    // Recursive, intersecting the ray with the external and internal planes of every node
+  PARAMETRIC // Iterative and front-to-back, from per-axis ray parameters at the node planes (Revelles et al.)
+};
+
+// Default query counters policy of the octree queries, counts nothing (optimized away)
+struct OctreeNoQueryCounters final
+{
+  void OnNodeVisited() {}
+  void OnPrimitiveTested() {}
+  void OnEarlyOut() {}
+};
+
+// Query counters policy that counts the traversal work, see the Intersect overload taking OctreeQueryCounters
+struct OctreeQueryCounters final
+{
+  std::size_t mNumVisitedNodes = 0;
+  std::size_t mNumPrimitiveTests = 0;
+  std::size_t mNumEarlyOuts = 0; // Subtrees or queries cut short (hit found, or beyond the max/closest distance)
+
+  void OnNodeVisited() { ++mNumVisitedNodes; }
+  void OnPrimitiveTested() { ++mNumPrimitiveTests; }
+  void OnEarlyOut() { ++mNumEarlyOuts; }
+};
+
+// Default filter of the any-hit queries, accepts every hit
+struct OctreeAcceptAllFilter final
+{
+  template <typename TPrimitiveIndex, typename TDistance>
+  constexpr bool operator()(const TPrimitiveIndex&, const TDistance&) const
+  {
+    return true;
+  }
+};
+
 template <typename TPrimitive>
 class Octree
 {
@@ -24,19 +67,8 @@ public:
   using ValueType = ValueType_t<TPrimitive>;
   using AABoxType = AABox<ValueType>;
   using ChildSequentialIndex = std::size_t;
-  using PrimitiveIndex = std::size_t;
-
-  struct Intersection final
-  {
-    ValueType mDistance { Infinity<ValueType>() };            // The distance to the intersection
-    PrimitiveIndex mPrimitiveIndex { Max<PrimitiveIndex>() }; // The intersected primitive index in the primitive pool
-
-    Intersection() = default;
-    Intersection(const ValueType& inDistance, const PrimitiveIndex& inPrimitiveIndex)
-        : mDistance { inDistance }, mPrimitiveIndex { inPrimitiveIndex }
-    {
-    }
-  };
+  using PrimitiveIndex = HierarchyPrimitiveIndex;
+  using Intersection = HierarchyIntersection<ValueType>;
 
   Octree() = default;
   explicit Octree(const AABoxf& inAABox);
@@ -48,18 +80,32 @@ public:
   Octree(Octree&&) = default;
   Octree& operator=(Octree&&) = default;
 
-  bool
+  // Dynamic updates are only available when the octree owns its primitives pool (not for views, see BuildView).
+  // Returns the index of the added primitive in the primitives pool (slots of removed primitives are reused).
+  // A primitive outside the root box doubles it towards the primitive, the old root becoming one of the children.
+  // The nodes this pushes below inMaxDepth are merged into leaves, so the octree stays within inMaxDepth.
+  std::optional<PrimitiveIndex>
   AddPrimitive(const TPrimitive& inPrimitive, const std::size_t inLeafNodesMaxCapacity, const std::size_t inMaxDepth);
+  // Only the nodes the primitive intersects are touched. Nodes whose children end up holding at most
+  // inLeafNodesMaxCapacity primitives are collapsed back into a leaf. The pool slot is freed, but not erased.
+  bool RemovePrimitive(const PrimitiveIndex inPrimitiveIndex, const std::size_t inLeafNodesMaxCapacity);
+  // Moves the primitive keeping its index in the primitives pool
+  bool UpdatePrimitive(const PrimitiveIndex inPrimitiveIndex,
+      const TPrimitive& inNewPrimitive,
+      const std::size_t inLeafNodesMaxCapacity,
+      const std::size_t inMaxDepth);
   const AABox<ValueType>& GetAABox() const { return mAABox; }
-  const std::vector<TPrimitive>& GetPrimitivesPool() const; // Only available in top Octree
-  const std::vector<PrimitiveIndex>& GetPrimitivesIndices() const { return mPrimitivesIndices; }
+  const std::vector<TPrimitive>& GetPrimitivesPool() const; // Only available in top Octree, if it is not a view
+  Span<TPrimitive> GetPrimitives() const; // Only in top Octree, the primitives the indices refer to (owned or not)
+  bool IsView() const { return mExternalPrimitives.has_value(); }
+  const std::vector<PrimitiveIndex>& GetPrimitivesIndices() const { return mPrimitivesIndices; } // Only in leaves
   const std::array<std::unique_ptr<Octree>, 8>& GetChildren() const { return mChildren; }
   AABoxType GetChildAABox(const ChildSequentialIndex inChildSequentialIndex) const;
   Octree* GetChildOctree(const Octree::ChildMultiIndex01 inChildIndex);
   const Octree* GetChildOctree(const Octree::ChildMultiIndex01 inChildIndex) const;
   Octree* GetChildOctree(const ChildSequentialIndex inChildSequentialIndex);
   const Octree* GetChildOctree(const ChildSequentialIndex inChildSequentialIndex) const;
-  bool IsEmpty() const { return mPrimitivesIndices.empty(); }
+  bool IsEmpty() const { return mPrimitivesIndices.empty() && IsLeaf(); }
   bool IsLeaf() const;
 
   template <bool IsConst>
@@ -128,7 +174,9 @@ private:
 
   AABox<ValueType> mAABox;
   std::optional<std::vector<TPrimitive>> mPrimitivesPool; // Only filled in top Octree
-  std::vector<std::size_t> mPrimitivesIndices;
+  std::optional<Span<TPrimitive>> mExternalPrimitives;    // Only filled in top Octree built as a view, not owned
+  std::vector<PrimitiveIndex> mFreePrimitivesIndices;     // Only filled in top Octree, removed primitives slots
+  std::vector<PrimitiveIndex> mPrimitivesIndices;         // Only filled in leaves
   std::array<std::unique_ptr<Octree>, 8> mChildren;
 
   std::optional<ChildSequentialIndex> GetNextChildOctreeIndexToExplore(
@@ -139,20 +187,117 @@ private:
       const Vec3<ValueType>& inRayDirection,
       const Vec3<ValueType>& inIntersectionPoint) const;
 
+  void WrapAABox(const TPrimitive& inPrimitive, const std::size_t inLeafNodesMaxCapacity, const std::size_t inMaxDepth);
+  void RebuildWrappingAABox(const AABoxType& inAABoxToWrap,
+      const std::size_t inLeafNodesMaxCapacity,
+      const std::size_t inMaxDepth);
   bool AddPrimitiveRecursive(const TPrimitive& inPrimitive,
+      const PrimitiveIndex inPrimitiveIndex,
       const std::size_t inLeafNodesMaxCapacity,
       const std::size_t inMaxDepth,
       const std::size_t inCurrentDepth,
-      const std::size_t inNewPrimitiveIndexIfAdded,
-      std::vector<TPrimitive>& ioPrimitivesPool,
-      const bool inAddPrimitiveToPool);
+      const std::vector<TPrimitive>& inPrimitivesPool);
+  bool RemovePrimitiveRecursive(const TPrimitive& inPrimitive,
+      const PrimitiveIndex inPrimitiveIndex,
+      const std::size_t inLeafNodesMaxCapacity);
+  void CollapseIfPossible(const std::size_t inLeafNodesMaxCapacity);
+  void CollapseBelowDepth(const std::size_t inDepth, const std::size_t inCurrentDepth);
+  std::size_t GetHeight() const;
 
   friend class OctreeBuilder<TPrimitive>;
+  friend class OctreeMortonBuilder<TPrimitive>;
 
-  template <typename T>
+  template <typename T, typename TQueryCounters>
   friend class IntersectHelperStruct;
 };
 
+// Structural statistics, to tune inLeafNodesMaxCapacity and inMaxDepth
+struct OctreeStats final
+{
+  std::size_t mNumNodes = 0;
+  std::size_t mNumLeaves = 0;
+  std::vector<std::size_t> mNumNodesPerDepth; // Depth histogram, the top octree is at depth 0
+  std::size_t mMaxLeafNumPrimitives = 0;
+  double mAverageLeafNumPrimitives = 0.0;
+  double mPrimitivesDuplicationFactor = 0.0; // Primitives indices in leaves per primitive, > 1 when they straddle
+  std::size_t mMemoryBytes = 0;              // Nodes, primitives indices and owned primitives pool (allocated)
+};
+
+template <typename TPrimitive>
+OctreeStats ComputeStats(const Octree<TPrimitive>& inTopOctree);
+
+// Any-hit query, for shadow and visibility rays: whether the ray hits, within inMaxDistance, a primitive hit that
+// inFilter(inPrimitiveIndex, inDistance) -> bool accepts (e.g. to skip alpha-tested texels or the ray caster).
+// Stops at the first accepted hit. Hits are offered in traversal order, not sorted by distance, and a primitive can
+// be offered more than once if it is in several leaves.
+template <typename TPrimitive, typename TFilter>
+bool IntersectAny(const Octree<TPrimitive>& inTopOctree,
+    const Ray3<ValueType_t<TPrimitive>>& inRay,
+    const TFilter& inFilter,
+    const ValueType_t<TPrimitive> inMaxDistance = Infinity<ValueType_t<TPrimitive>>());
+
+template <typename T>
+struct OctreeBatchIntersectOptions final
+{
+  T mMaxDistance = Infinity<T>();
+  ParallelPolicy mParallelPolicy;
+  std::size_t mGrainSize = 64; // Number of consecutive rays handed to a thread at once
+};
+
+// Closest intersection of every ray, written to outIntersections[i] (resized to the number of rays).
+// Rays are spread across the policy threads. Each thread reuses its own traversal stack, so there is no per-ray heap
+// allocation once the stacks have grown.
+template <typename TPrimitive>
+void IntersectBatch(const Octree<TPrimitive>& inTopOctree,
+    const Span<Ray3<ValueType_t<TPrimitive>>>& inRays,
+    std::vector<std::optional<typename Octree<TPrimitive>::Intersection>>& outIntersections,
+    const OctreeBatchIntersectOptions<ValueType_t<TPrimitive>>& inOptions = {});
+
+template <typename TPrimitive>
+std::vector<std::optional<typename Octree<TPrimitive>::Intersection>> IntersectBatch(
+    const Octree<TPrimitive>& inTopOctree,
+    const Span<Ray3<ValueType_t<TPrimitive>>>& inRays,
+    const OctreeBatchIntersectOptions<ValueType_t<TPrimitive>>& inOptions = {});
+
+// Proximity queries. Nodes are explored best-first (closest box first), and the ones whose box is further than the
+// current search distance are pruned. The distance to a primitive is the one to its closest point.
+
+// Writes the inK primitives closest to inPoint, sorted by increasing distance (the outputs are resized to the number of
+// primitives found, which is smaller when the octree does not have enough primitives). Returns that number.
+template <typename TPrimitive>
+std::size_t FindKNearest(const Octree<TPrimitive>& inTopOctree,
+    const Vec3<ValueType_t<TPrimitive>>& inPoint,
+    const std::size_t inK,
+    std::vector<typename Octree<TPrimitive>::PrimitiveIndex>& outPrimitivesIndices,
+    std::vector<ValueType_t<TPrimitive>>& outDistances);
+
+// Writes the primitives at distance <= inRadius from inPoint, sorted by increasing distance (the outputs are resized to
+// the number of primitives found). Returns that number.
+template <typename TPrimitive>
+std::size_t FindWithinRadius(const Octree<TPrimitive>& inTopOctree,
+    const Vec3<ValueType_t<TPrimitive>>& inPoint,
+    const ValueType_t<TPrimitive> inRadius,
+    std::vector<typename Octree<TPrimitive>::PrimitiveIndex>& outPrimitivesIndices,
+    std::vector<ValueType_t<TPrimitive>>& outDistances);
+
+// Overlap queries, for any query primitive for which IntersectCheck(query, primitive) is defined.
+// Subtrees whose box is entirely inside the query (if Contains(query, AAHyperBox) is defined) are accepted without
+// testing their primitives. Every overlapping primitive is reported once, even if it is in several leaves.
+
+// Calls inCallback(inPrimitiveIndex) for every primitive overlapping inQueryPrimitive, as the traversal finds them (no
+// particular order)
+template <typename TPrimitive, typename TQueryPrimitive, typename TCallback>
+void QueryOverlap(const Octree<TPrimitive>& inTopOctree,
+    const TQueryPrimitive& inQueryPrimitive,
+    const TCallback& inCallback);
+
+// Writes the indices of the primitives overlapping inQueryPrimitive, by increasing index (the output is cleared first,
+// so its capacity is reused across queries). Returns their number.
+template <typename TPrimitive, typename TQueryPrimitive>
+std::size_t QueryOverlap(const Octree<TPrimitive>& inTopOctree,
+    const TQueryPrimitive& inQueryPrimitive,
+    std::vector<typename Octree<TPrimitive>::PrimitiveIndex>& outPrimitivesIndices);
+
 template <typename TPrimitive>
 class OctreeBuilder final
 {
@@ -163,13 +308,44 @@ public:
       const std::size_t inLeafNodesMaxCapacity = 8,
       const std::size_t inMaxDepth = 8);
 
+  // Same output as the serial Build, but independent subtrees are built concurrently
+  static Octree<TPrimitive> Build(const Span<TPrimitive>& inPrimitives,
+      const std::size_t inLeafNodesMaxCapacity,
+      const std::size_t inMaxDepth,
+      const ParallelPolicy& inParallelPolicy);
+
+  // Same as Build, but the octree does not copy the primitives, it only stores indices into inPrimitives (e.g. a
+  // memory-mapped buffer owned by the caller, that must outlive the octree and not change while it is in use).
+  static Octree<TPrimitive> BuildView(const Span<TPrimitive>& inPrimitives,
+      const std::size_t inLeafNodesMaxCapacity = 8,
+      const std::size_t inMaxDepth = 8);
+  static Octree<TPrimitive> BuildView(const Span<TPrimitive>& inPrimitives,
+      const std::size_t inLeafNodesMaxCapacity,
+      const std::size_t inMaxDepth,
+      const ParallelPolicy& inParallelPolicy);
+
 private:
+  friend class OctreeMortonBuilder<TPrimitive>; // Splits its over-capacity leaves the same way (BuildChildrenRecursive)
+
+  static Octree<TPrimitive> CopyPrimitivesPool(Octree<TPrimitive>&& ioOctreeView);
+
   static Octree<TPrimitive> BuildRecursive(const typename Octree<TPrimitive>::AABoxType& inBoundingAABox,
       const Span<TPrimitive>& inTopOctreePrimitivesPool,
       const Span<typename Octree<TPrimitive>::PrimitiveIndex>& inParentPrimitivesIndices,
       const std::size_t inLeafNodesMaxCapacity,
       const std::size_t inMaxDepth,
       const std::size_t inCurrentDepth);
+
+  static void BuildChildrenRecursive(Octree<TPrimitive>& ioOctree,
+      const Span<TPrimitive>& inTopOctreePrimitivesPool,
+      const std::size_t inLeafNodesMaxCapacity,
+      const std::size_t inMaxDepth,
+      const std::size_t inCurrentDepth);
+
+  static Octree<TPrimitive> BuildNode(const typename Octree<TPrimitive>::AABoxType& inBoundingAABox,
+      const Span<TPrimitive>& inTopOctreePrimitivesPool,
+      const Span<typename Octree<TPrimitive>::PrimitiveIndex>& inParentPrimitivesIndices,
+      const std::size_t inCurrentDepth);
 };
 }
 
@@ -2,9 +2,13 @@
 #include <ez/Math.h>
 #include <ez/Octree.h>
 #include <ez/Plane.h>
+#include <ez/PrecomputedRay.h>
+#include <ez/Ray.h>
+#include <ez/RayQueryHelper.h>
 #include <algorithm>
+#include <bit>
 #include <numeric>
-#include <stack>
+#include <queue>
 #include <tuple>
 #include <utility>
 
@@ -33,6 +37,16 @@ const std::vector<TPrimitive>& Octree<TPrimitive>::GetPrimitivesPool() const
   return *mPrimitivesPool;
 }
 
+template <typename TPrimitive>
+Span<TPrimitive> Octree<TPrimitive>::GetPrimitives() const
+{
+  if (mExternalPrimitives)
+    return *mExternalPrimitives;
+
+  EXPECTS(mPrimitivesPool);
+  return MakeSpan(*mPrimitivesPool);
+}
+
 template <typename TPrimitive>
 Octree<TPrimitive>::AABoxType Octree<TPrimitive>::GetChildAABox(
     const typename Octree<TPrimitive>::ChildSequentialIndex inInternalIndex) const
@@ -74,130 +88,323 @@ const Octree<TPrimitive>* Octree<TPrimitive>::GetChildOctree(
 }
 
 template <typename TPrimitive>
-bool Octree<TPrimitive>::AddPrimitive(const TPrimitive& inPrimitive,
+std::optional<typename Octree<TPrimitive>::PrimitiveIndex> Octree<TPrimitive>::AddPrimitive(const TPrimitive& inPrimitive,
     const std::size_t inLeafNodesMaxCapacity,
     const std::size_t inMaxDepth)
 {
+  EXPECTS(mPrimitivesPool);
+
   // Adapt octree size if needed(and children's size as well)
   if (!Contains(mAABox, inPrimitive))
+    WrapAABox(inPrimitive, inLeafNodesMaxCapacity, inMaxDepth);
+
+  // Reuse the slot of some removed primitive if possible
+  auto& primitives_pool = *mPrimitivesPool;
+  const auto reuse_free_primitive_index = !mFreePrimitivesIndices.empty();
+  const auto primitive_index = (reuse_free_primitive_index ? mFreePrimitivesIndices.back() : primitives_pool.size());
+  const auto primitive_added
+      = AddPrimitiveRecursive(inPrimitive, primitive_index, inLeafNodesMaxCapacity, inMaxDepth, 0, primitives_pool);
+  if (!primitive_added)
+    return std::nullopt;
+
+  if (reuse_free_primitive_index)
+  {
+    primitives_pool.at(primitive_index) = inPrimitive;
+    mFreePrimitivesIndices.pop_back();
+  }
+  else
+  {
+    primitives_pool.push_back(inPrimitive);
+  }
+  return primitive_index;
+}
+
+template <typename TPrimitive>
+bool Octree<TPrimitive>::RemovePrimitive(const PrimitiveIndex inPrimitiveIndex, const std::size_t inLeafNodesMaxCapacity)
+{
+  EXPECTS(mPrimitivesPool);
+  EXPECTS(inPrimitiveIndex < mPrimitivesPool->size());
+
+  const auto& primitive = mPrimitivesPool->at(inPrimitiveIndex);
+  const auto primitive_removed = RemovePrimitiveRecursive(primitive, inPrimitiveIndex, inLeafNodesMaxCapacity);
+  if (primitive_removed)
+    mFreePrimitivesIndices.push_back(inPrimitiveIndex);
+  return primitive_removed;
+}
+
+template <typename TPrimitive>
+bool Octree<TPrimitive>::UpdatePrimitive(const PrimitiveIndex inPrimitiveIndex,
+    const TPrimitive& inNewPrimitive,
+    const std::size_t inLeafNodesMaxCapacity,
+    const std::size_t inMaxDepth)
+{
+  if (!RemovePrimitive(inPrimitiveIndex, inLeafNodesMaxCapacity))
+    return false; // Not in the octree (e.g. already removed)
+
+  // The slot just freed is the last one, so it is the one AddPrimitive reuses
+  const auto new_primitive_index = AddPrimitive(inNewPrimitive, inLeafNodesMaxCapacity, inMaxDepth);
+  ENSURES(!new_primitive_index || *new_primitive_index == inPrimitiveIndex);
+  return new_primitive_index.has_value();
+}
+
+template <typename TPrimitive>
+void Octree<TPrimitive>::WrapAABox(const TPrimitive& inPrimitive,
+    const std::size_t inLeafNodesMaxCapacity,
+    const std::size_t inMaxDepth)
+{
+  const auto primitive_aabox = BoundingAAHyperBox(inPrimitive);
+
+  // Double the root box towards the primitive until it contains it. The old root becomes the child of the new one on
+  // the opposite side, so the existing nodes are kept as they are, one level deeper. The nodes pushed below
+  // inMaxDepth are merged into their ancestor at inMaxDepth, which becomes a leaf, so that the octree does not get
+  // deeper with every far primitive.
+  auto height = GetHeight();
+  while (!Contains(mAABox, inPrimitive))
   {
-    mAABox.Wrap(BoundingAABox(inPrimitive));
+    // A leaf root holds all the primitives, it only needs the larger box
+    if (IsLeaf())
+    {
+      mAABox.Wrap(primitive_aabox);
+      return;
+    }
 
-    std::stack<std::tuple<Octree*, Octree*, std::size_t>> octree_stack;
-    octree_stack.emplace(this, nullptr, 0ul);
-    while (!octree_stack.empty())
+    const auto aabox_size = mAABox.GetSize();
+    auto new_aabox_min = mAABox.GetMin();
+    auto new_aabox_max = mAABox.GetMax();
+    ChildSequentialIndex old_root_child_sequential_index = 0;
+    for (std::size_t i = 0; i < 3; ++i)
     {
-      const auto& octree_stack_top = octree_stack.top();
-      const auto octree = std::get<0>(octree_stack_top);
-      const auto parent_octree = std::get<1>(octree_stack_top);
-      const auto octree_index_in_parent = std::get<2>(octree_stack_top);
-      octree_stack.pop();
+      if (aabox_size[i] <= static_cast<ValueType>(0))
+      {
+        // A flat box can not be doubled, so wrap it and distribute the primitives again
+        RebuildWrappingAABox(primitive_aabox, inLeafNodesMaxCapacity, inMaxDepth);
+        return;
+      }
 
-      for (std::size_t i = 0; i < 8; ++i) // Enqueue children if any
+      if (primitive_aabox.GetMin()[i] < mAABox.GetMin()[i])
+      {
+        new_aabox_min[i] -= aabox_size[i];
+        old_root_child_sequential_index |= static_cast<ChildSequentialIndex>(1u << (2 - i)); // X is the MSB
+      }
+      else
       {
-        if (const auto octree_child = octree->GetChildOctree(i))
-          octree_stack.emplace(octree_child, octree, i);
+        new_aabox_max[i] += aabox_size[i];
       }
+    }
 
-      if (!parent_octree)
-        continue;
+    auto old_root_octree = std::make_unique<Octree>(mAABox);
+    old_root_octree->mPrimitivesPool.reset(); // Only the top octree has a pool
+    old_root_octree->mChildren = std::move(mChildren);
+    mChildren = {};
+    mChildren.at(old_root_child_sequential_index) = std::move(old_root_octree);
+    mAABox = AABoxType(new_aabox_min, new_aabox_max);
 
-      octree->mAABox = parent_octree->GetChildAABox(octree_index_in_parent); // Change size
+    if (++height > inMaxDepth)
+    {
+      CollapseBelowDepth(inMaxDepth, 0);
+      height = inMaxDepth;
     }
   }
+}
 
-  const auto old_primitives_pool_size = mPrimitivesPool->size();
-  const auto new_primitive_index_if_added = mPrimitivesPool->size();
-  const auto new_primitive_added = AddPrimitiveRecursive(inPrimitive,
-      inLeafNodesMaxCapacity,
-      inMaxDepth,
-      0,
-      new_primitive_index_if_added,
-      *mPrimitivesPool,
-      true);
+template <typename TPrimitive>
+void Octree<TPrimitive>::RebuildWrappingAABox(const AABoxType& inAABoxToWrap,
+    const std::size_t inLeafNodesMaxCapacity,
+    const std::size_t inMaxDepth)
+{
+  mAABox.Wrap(inAABoxToWrap);
 
-  if (new_primitive_added)
-    assert(mPrimitivesPool->size() == old_primitives_pool_size + 1);
-  else
-    assert(mPrimitivesPool->size() == old_primitives_pool_size);
+  // All the children boxes change, so the primitives have to be distributed again
+  const auto& primitives_pool = *mPrimitivesPool;
+  std::vector<bool> is_free_primitive_index(primitives_pool.size(), false);
+  for (const auto& free_primitive_index : mFreePrimitivesIndices) is_free_primitive_index[free_primitive_index] = true;
+
+  mPrimitivesIndices.clear();
+  for (auto& child_octree : mChildren) child_octree.reset();
+  for (std::size_t primitive_index = 0; primitive_index < primitives_pool.size(); ++primitive_index)
+  {
+    if (is_free_primitive_index[primitive_index])
+      continue;
 
-  return new_primitive_added;
+    AddPrimitiveRecursive(primitives_pool[primitive_index],
+        primitive_index,
+        inLeafNodesMaxCapacity,
+        inMaxDepth,
+        0,
+        primitives_pool);
+  }
 }
 
 template <typename TPrimitive>
 bool Octree<TPrimitive>::AddPrimitiveRecursive(const TPrimitive& inPrimitive,
+    const PrimitiveIndex inPrimitiveIndex,
     const std::size_t inLeafNodesMaxCapacity,
     const std::size_t inMaxDepth,
     const std::size_t inCurrentDepth,
-    const std::size_t inNewPrimitiveIndexIfAdded,
-    std::vector<TPrimitive>& ioPrimitivesPool,
-    const bool inAddPrimitiveToPool)
+    const std::vector<TPrimitive>& inPrimitivesPool)
 {
-  if (inCurrentDepth > inMaxDepth)
+  if (!IntersectCheck(inPrimitive, mAABox))
     return false;
 
+  if (IsLeaf() && (mPrimitivesIndices.size() < inLeafNodesMaxCapacity || inCurrentDepth >= inMaxDepth))
+  {
+    mPrimitivesIndices.push_back(inPrimitiveIndex);
+    return true;
+  }
+
+  // Not enough room in this level. We have to go one level deeper.
+  const auto AddPrimitiveToChildren = [&](const TPrimitive& inPrimitive, const PrimitiveIndex inPrimitiveIndex) {
+    auto added_to_some_child = false;
+    for (std::size_t i = 0; i < 8; ++i)
+    {
+      const auto child_octree_aabox = GetChildAABox(i);
+      if (!IntersectCheck(inPrimitive, child_octree_aabox))
+        continue;
+
+      auto child_octree = GetChildOctree(i);
+      if (!child_octree)
+      {
+        mChildren.at(i) = std::make_unique<Octree>(child_octree_aabox);
+        child_octree = mChildren.at(i).get();
+        child_octree->mPrimitivesPool.reset(); // Only the top octree has a pool
+      }
+
+      added_to_some_child |= child_octree->AddPrimitiveRecursive(inPrimitive,
+          inPrimitiveIndex,
+          inLeafNodesMaxCapacity,
+          inMaxDepth,
+          inCurrentDepth + 1,
+          inPrimitivesPool);
+    }
+    return added_to_some_child;
+  };
+
+  if (IsLeaf())
+  {
+    // This node will stop being a leaf, so move its indices to its children
+    const auto primitives_indices_to_be_reallocated_in_children = std::move(mPrimitivesIndices);
+    mPrimitivesIndices.clear();
+    for (const auto& primitive_index_to_be_reallocated_in_children : primitives_indices_to_be_reallocated_in_children)
+    {
+      AddPrimitiveToChildren(inPrimitivesPool.at(primitive_index_to_be_reallocated_in_children),
+          primitive_index_to_be_reallocated_in_children);
+    }
+  }
+
+  return AddPrimitiveToChildren(inPrimitive, inPrimitiveIndex);
+}
+
+template <typename TPrimitive>
+bool Octree<TPrimitive>::RemovePrimitiveRecursive(const TPrimitive& inPrimitive,
+    const PrimitiveIndex inPrimitiveIndex,
+    const std::size_t inLeafNodesMaxCapacity)
+{
+  // The primitive was only added to the octrees it intersects
   if (!IntersectCheck(inPrimitive, mAABox))
     return false;
 
-  if (mPrimitivesIndices.size() < inLeafNodesMaxCapacity)
+  if (IsLeaf())
   {
-    mPrimitivesIndices.push_back(inNewPrimitiveIndexIfAdded);
-    if (inAddPrimitiveToPool)
-      ioPrimitivesPool.push_back(inPrimitive);
+    const auto primitive_index_it = std::find(mPrimitivesIndices.cbegin(), mPrimitivesIndices.cend(), inPrimitiveIndex);
+    if (primitive_index_it == mPrimitivesIndices.cend())
+      return false;
+
+    mPrimitivesIndices.erase(primitive_index_it);
     return true;
   }
 
-  // Not enough room in this level. We have to go one level deeper.
-  const auto AddPrimitiveToChildren
-      = [&](const TPrimitive& inPrimitive, const std::size_t inPrimitiveIndex, const bool inAddPrimitiveToPool) {
-          auto added_to_some_child = false;
-          for (std::size_t i = 0; i < 8; ++i)
-          {
-            const auto child_octree_aabox = GetChildAABox(i);
-            if (!IntersectCheck(inPrimitive, child_octree_aabox))
-              continue;
+  auto removed_from_some_child = false;
+  for (auto& child_octree : mChildren)
+  {
+    if (!child_octree || !child_octree->RemovePrimitiveRecursive(inPrimitive, inPrimitiveIndex, inLeafNodesMaxCapacity))
+      continue;
 
-            auto child_octree = GetChildOctree(i);
-            if (!child_octree)
-            {
-              mChildren.at(i) = std::move(std::make_unique<Octree>(child_octree_aabox));
-              child_octree = mChildren.at(i).get();
-            }
+    removed_from_some_child = true;
+    if (child_octree->IsEmpty())
+      child_octree.reset();
+  }
 
-            const auto add_primitive_to_pool = (inAddPrimitiveToPool && !added_to_some_child);
-            const auto added_to_child = child_octree->AddPrimitiveRecursive(inPrimitive,
-                inLeafNodesMaxCapacity,
-                inMaxDepth,
-                inCurrentDepth + 1,
-                inPrimitiveIndex,
-                ioPrimitivesPool,
-                add_primitive_to_pool);
+  if (removed_from_some_child)
+    CollapseIfPossible(inLeafNodesMaxCapacity);
 
-            added_to_some_child |= added_to_child;
-          }
-          return added_to_some_child;
-        };
+  return removed_from_some_child;
+}
+
+template <typename TPrimitive>
+void Octree<TPrimitive>::CollapseIfPossible(const std::size_t inLeafNodesMaxCapacity)
+{
+  // Internal octrees always hold more than inLeafNodesMaxCapacity primitives, so it is only possible if all
+  // the children are leaves. Then, count the unique primitives among them (a primitive can be in several).
+  std::vector<PrimitiveIndex> unique_primitives_indices;
+  for (const auto& child_octree : mChildren)
+  {
+    if (!child_octree)
+      continue;
 
-  // Save a copy of the primitives indices of this node before to reallocate them afterwards
-  const auto old_primitive_indices_copy_to_be_reallocated_in_children = mPrimitivesIndices;
-  mPrimitivesIndices.clear(); // Empty this node because it will no longer be a leaft
+    if (!child_octree->IsLeaf())
+      return;
 
-  // Also, this node will stop being a leaf, so readd its indices in its children.
-  for (const auto& old_primitive_index_to_be_reallocated_in_children :
-      old_primitive_indices_copy_to_be_reallocated_in_children)
+    for (const auto& primitive_index : child_octree->mPrimitivesIndices)
+    {
+      if (std::find(unique_primitives_indices.cbegin(), unique_primitives_indices.cend(), primitive_index)
+          != unique_primitives_indices.cend())
+        continue;
+
+      if (unique_primitives_indices.size() == inLeafNodesMaxCapacity)
+        return;
+
+      unique_primitives_indices.push_back(primitive_index);
+    }
+  }
+
+  mPrimitivesIndices = std::move(unique_primitives_indices);
+  for (auto& child_octree : mChildren) child_octree.reset();
+}
+
+template <typename TPrimitive>
+void Octree<TPrimitive>::CollapseBelowDepth(const std::size_t inDepth, const std::size_t inCurrentDepth)
+{
+  if (IsLeaf())
+    return;
+
+  for (auto& child_octree : mChildren)
   {
-    const auto& old_primitive_to_be_reallocated_in_children
-        = ioPrimitivesPool.at(old_primitive_index_to_be_reallocated_in_children);
-    AddPrimitiveToChildren(old_primitive_to_be_reallocated_in_children,
-        old_primitive_index_to_be_reallocated_in_children,
-        false);
+    if (child_octree)
+      child_octree->CollapseBelowDepth(inDepth, inCurrentDepth + 1);
   }
 
-  // Add input primitive
-  const auto input_primitive_added_to_some_child
-      = AddPrimitiveToChildren(inPrimitive, inNewPrimitiveIndexIfAdded, inAddPrimitiveToPool);
+  if (inCurrentDepth < inDepth)
+    return;
 
-  return input_primitive_added_to_some_child;
+  // All the children are leaves now, gather their unique primitives (a primitive can be in several)
+  std::vector<PrimitiveIndex> unique_primitives_indices;
+  for (const auto& child_octree : mChildren)
+  {
+    if (child_octree)
+    {
+      unique_primitives_indices.insert(unique_primitives_indices.end(),
+          child_octree->mPrimitivesIndices.cbegin(),
+          child_octree->mPrimitivesIndices.cend());
+    }
+  }
+  std::sort(unique_primitives_indices.begin(), unique_primitives_indices.end());
+  unique_primitives_indices.erase(std::unique(unique_primitives_indices.begin(), unique_primitives_indices.end()),
+      unique_primitives_indices.end());
+
+  mPrimitivesIndices = std::move(unique_primitives_indices);
+  for (auto& child_octree : mChildren) child_octree.reset();
+}
+
+template <typename TPrimitive>
+std::size_t Octree<TPrimitive>::GetHeight() const
+{
+  std::size_t height = 0;
+  for (const auto& child_octree : mChildren)
+  {
+    if (child_octree)
+      height = Max(height, child_octree->GetHeight() + 1);
+  }
+  return height;
 }
 
 template <typename TPrimitive>
@@ -291,7 +498,37 @@ Octree<TPrimitive> OctreeBuilder<TPrimitive>::Build(const Span<TPrimitive>& inPr
     const std::size_t inLeafNodesMaxCapacity,
     const std::size_t inMaxDepth)
 {
-  const auto bounding_aa_box = BoundingAABox(inPrimitives);
+  return CopyPrimitivesPool(BuildView(inPrimitives, inLeafNodesMaxCapacity, inMaxDepth));
+}
+
+template <typename TPrimitive>
+Octree<TPrimitive> OctreeBuilder<TPrimitive>::Build(const Span<TPrimitive>& inPrimitives,
+    const std::size_t inLeafNodesMaxCapacity,
+    const std::size_t inMaxDepth,
+    const ParallelPolicy& inParallelPolicy)
+{
+  return CopyPrimitivesPool(BuildView(inPrimitives, inLeafNodesMaxCapacity, inMaxDepth, inParallelPolicy));
+}
+
+template <typename TPrimitive>
+Octree<TPrimitive> OctreeBuilder<TPrimitive>::CopyPrimitivesPool(Octree<TPrimitive>&& ioOctreeView)
+{
+  EXPECTS(ioOctreeView.mExternalPrimitives);
+
+  // The tree only refers to primitives by index, so it stays valid once the primitives are copied in the pool
+  const auto& external_primitives = *ioOctreeView.mExternalPrimitives;
+  ioOctreeView.mPrimitivesPool
+      = std::make_optional<std::vector<TPrimitive>>(external_primitives.cbegin(), external_primitives.cend());
+  ioOctreeView.mExternalPrimitives.reset();
+  return std::move(ioOctreeView);
+}
+
+template <typename TPrimitive>
+Octree<TPrimitive> OctreeBuilder<TPrimitive>::BuildView(const Span<TPrimitive>& inPrimitives,
+    const std::size_t inLeafNodesMaxCapacity,
+    const std::size_t inMaxDepth)
+{
+  const auto bounding_aa_box = BoundingAAHyperBox(inPrimitives);
   return BuildRecursive(bounding_aa_box,
       inPrimitives,
       MakeSpan<typename Octree<TPrimitive>::PrimitiveIndex>({}),
@@ -300,6 +537,73 @@ Octree<TPrimitive> OctreeBuilder<TPrimitive>::Build(const Span<TPrimitive>& inPr
       0);
 }
 
+template <typename TPrimitive>
+Octree<TPrimitive> OctreeBuilder<TPrimitive>::BuildView(const Span<TPrimitive>& inPrimitives,
+    const std::size_t inLeafNodesMaxCapacity,
+    const std::size_t inMaxDepth,
+    const ParallelPolicy& inParallelPolicy)
+{
+  if (inParallelPolicy.mNumThreads <= 1)
+    return BuildView(inPrimitives, inLeafNodesMaxCapacity, inMaxDepth);
+
+  const auto bounding_aa_box = BoundingAAHyperBox(inPrimitives);
+  auto top_octree
+      = BuildNode(bounding_aa_box, inPrimitives, MakeSpan<typename Octree<TPrimitive>::PrimitiveIndex>({}), 0);
+
+  // Octrees (and their depth) whose children still have to be built
+  std::vector<std::pair<Octree<TPrimitive>*, std::size_t>> octrees_to_split;
+  if (top_octree.mPrimitivesIndices.size() > inLeafNodesMaxCapacity)
+    octrees_to_split.emplace_back(&top_octree, 0);
+
+  // Top levels have few, very big nodes. Build them level by level, all the children of a level in parallel,
+  // until there are enough independent subtrees to keep all threads busy.
+  const auto min_num_subtrees_to_split = (inParallelPolicy.mNumThreads * 8);
+  while (!octrees_to_split.empty() && octrees_to_split.size() < min_num_subtrees_to_split)
+  {
+    std::vector<Octree<TPrimitive>> built_children(octrees_to_split.size() * 8);
+    ParallelFor(inParallelPolicy, built_children.size(), [&](const std::size_t inChildIndex, const std::size_t) {
+      const auto& [parent_octree, parent_depth] = octrees_to_split[inChildIndex / 8];
+      if (parent_depth + 1 > inMaxDepth)
+        return;
+
+      built_children[inChildIndex] = BuildNode(parent_octree->GetChildAABox(inChildIndex % 8),
+          inPrimitives,
+          MakeSpan(parent_octree->mPrimitivesIndices),
+          parent_depth + 1);
+    });
+
+    std::vector<std::pair<Octree<TPrimitive>*, std::size_t>> next_level_octrees_to_split;
+    for (std::size_t i = 0; i < built_children.size(); ++i)
+    {
+      auto& built_child = built_children[i];
+      if (built_child.IsEmpty())
+        continue;
+
+      const auto& [parent_octree, parent_depth] = octrees_to_split[i / 8];
+      auto& child_octree = parent_octree->mChildren[i % 8];
+      child_octree = std::make_unique<Octree<TPrimitive>>(std::move(built_child));
+      if (child_octree->mPrimitivesIndices.size() > inLeafNodesMaxCapacity)
+        next_level_octrees_to_split.emplace_back(child_octree.get(), parent_depth + 1);
+    }
+
+    // Only leaves keep their primitives indices
+    for (const auto& [octree_split, depth] : octrees_to_split)
+    {
+      if (!octree_split->IsLeaf())
+        std::vector<typename Octree<TPrimitive>::PrimitiveIndex>().swap(octree_split->mPrimitivesIndices);
+    }
+    octrees_to_split = std::move(next_level_octrees_to_split);
+  }
+
+  // The remaining subtrees do not depend on each other, build each one of them serially in some thread
+  ParallelFor(inParallelPolicy, octrees_to_split.size(), [&](const std::size_t inSubtreeIndex, const std::size_t) {
+    const auto& [octree, depth] = octrees_to_split[inSubtreeIndex];
+    BuildChildrenRecursive(*octree, inPrimitives, inLeafNodesMaxCapacity, inMaxDepth, depth);
+  });
+
+  return top_octree;
+}
+
 template <typename TPrimitive>
 Octree<TPrimitive> OctreeBuilder<TPrimitive>::BuildRecursive(
     const typename Octree<TPrimitive>::AABoxType& inBoundingAABox,
@@ -312,19 +616,57 @@ Octree<TPrimitive> OctreeBuilder<TPrimitive>::BuildRecursive(
   if (inCurrentDepth > inMaxDepth)
     return {};
 
+  auto octree = BuildNode(inBoundingAABox, inPrimitivesPool, inParentPrimitivesIndices, inCurrentDepth);
+  if (octree.mPrimitivesIndices.size() <= inLeafNodesMaxCapacity)
+    return octree;
+
+  BuildChildrenRecursive(octree, inPrimitivesPool, inLeafNodesMaxCapacity, inMaxDepth, inCurrentDepth);
+  return octree;
+}
+
+template <typename TPrimitive>
+void OctreeBuilder<TPrimitive>::BuildChildrenRecursive(Octree<TPrimitive>& ioOctree,
+    const Span<TPrimitive>& inPrimitivesPool,
+    const std::size_t inLeafNodesMaxCapacity,
+    const std::size_t inMaxDepth,
+    const std::size_t inCurrentDepth)
+{
+  for (std::size_t i = 0; i < 8; ++i)
+  {
+    const auto child_bounding_aa_box = ioOctree.GetChildAABox(i);
+    auto built_child = BuildRecursive(child_bounding_aa_box,
+        inPrimitivesPool,
+        MakeSpan(ioOctree.mPrimitivesIndices),
+        inLeafNodesMaxCapacity,
+        inMaxDepth,
+        inCurrentDepth + 1);
+
+    if (!built_child.IsEmpty())
+      ioOctree.mChildren[i] = std::make_unique<Octree<TPrimitive>>(std::move(built_child));
+  }
+
+  // Only leaves keep their primitives indices
+  if (!ioOctree.IsLeaf())
+    std::vector<typename Octree<TPrimitive>::PrimitiveIndex>().swap(ioOctree.mPrimitivesIndices);
+}
+
+template <typename TPrimitive>
+Octree<TPrimitive> OctreeBuilder<TPrimitive>::BuildNode(const typename Octree<TPrimitive>::AABoxType& inBoundingAABox,
+    const Span<TPrimitive>& inPrimitivesPool,
+    const Span<typename Octree<TPrimitive>::PrimitiveIndex>& inParentPrimitivesIndices,
+    const std::size_t inCurrentDepth)
+{
   // Create octree
   Octree<TPrimitive> octree;
   octree.mAABox = inBoundingAABox;
 
   if (inCurrentDepth == 0)
   {
-    // Octree global primitives pool
-    octree.mPrimitivesPool = std::make_optional<std::vector<TPrimitive>>();
-    octree.mPrimitivesPool->reserve(inPrimitivesPool.GetNumberOfElements());
-    std::copy(inPrimitivesPool.cbegin(), inPrimitivesPool.cend(), std::back_inserter(*octree.mPrimitivesPool));
+    // Octree global primitives, not copied (Build copies them into the pool once the whole tree is built)
+    octree.mExternalPrimitives = inPrimitivesPool;
 
     // Octree primitives indices 0,1,2,...,N
-    octree.mPrimitivesIndices.resize(octree.mPrimitivesPool->size());
+    octree.mPrimitivesIndices.resize(inPrimitivesPool.GetNumberOfElements());
     std::iota(octree.mPrimitivesIndices.begin(), octree.mPrimitivesIndices.end(), 0);
   }
   else
@@ -340,56 +682,165 @@ Octree<TPrimitive> OctreeBuilder<TPrimitive>::BuildRecursive(
         });
   }
 
-  if (octree.mPrimitivesIndices.size() <= inLeafNodesMaxCapacity)
-    return octree;
+  return octree;
+}
 
-  for (std::size_t i = 0; i < 8; ++i)
+namespace octree_detail
+{
+  constexpr std::size_t GetChildSequentialIndexAxisBit(const std::size_t inAxis)
   {
-    const auto child_bounding_aa_box = octree.GetChildAABox(i);
-    auto built_child = BuildRecursive(child_bounding_aa_box,
-        inPrimitivesPool,
-        MakeSpan(octree.mPrimitivesIndices),
-        inLeafNodesMaxCapacity,
-        inMaxDepth,
-        inCurrentDepth + 1);
+    return (static_cast<std::size_t>(1) << (2 - inAxis)); // X is the MSB
+  }
 
-    if (!built_child.IsEmpty())
-      octree.mChildren[i] = std::make_unique<Octree<TPrimitive>>(std::move(built_child));
+  // Ray parameters at the planes of the root box of a parametric traversal. Axes where the ray goes backwards are
+  // mirrored, so that the ray always enters the nodes through their min planes and goes from the lower to the upper
+  // children. Mirroring an axis flips its bit in the child sequential index: the returned mask is the one to XOR.
+  template <typename T>
+  std::size_t GetParametricRootDistances(const PrecomputedRay3<T>& inRay,
+      const AABox<T>& inAABox,
+      Vec3<T>& outEnterDistances,
+      Vec3<T>& outExitDistances)
+  {
+    const auto& ray_origin = inRay.GetOrigin();
+    const auto& ray_direction = inRay.GetDirection();
+    std::size_t mirror_mask = 0;
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+      if (ray_direction[i] == static_cast<T>(0))
+      {
+        // Parallel to this axis planes, the ray is either always or never between them
+        const auto is_between = IsBetween(ray_origin[i], inAABox.GetMin()[i], inAABox.GetMax()[i]);
+        outEnterDistances[i] = (is_between ? -Infinity<T>() : Infinity<T>());
+        outExitDistances[i] = Infinity<T>();
+        continue;
+      }
+
+      const auto is_mirrored = inRay.IsDirectionNegative(i);
+      if (is_mirrored)
+        mirror_mask |= GetChildSequentialIndexAxisBit(i);
+
+      const auto ray_direction_inverse = inRay.GetDirectionInverse()[i];
+      const auto enter_plane = (is_mirrored ? inAABox.GetMax()[i] : inAABox.GetMin()[i]);
+      const auto exit_plane = (is_mirrored ? inAABox.GetMin()[i] : inAABox.GetMax()[i]);
+      outEnterDistances[i] = (enter_plane - ray_origin[i]) * ray_direction_inverse;
+      outExitDistances[i] = (exit_plane - ray_origin[i]) * ray_direction_inverse;
+    }
+    return mirror_mask;
   }
 
-  return octree;
+  template <typename T>
+  bool IsParametricNodeTraversed(const Vec3<T>& inEnterDistances, const Vec3<T>& inExitDistances, const T inMaxDistance)
+  {
+    const auto enter_distance = Max(inEnterDistances);
+    const auto exit_distance = Min(inExitDistances);
+    return enter_distance <= exit_distance && exit_distance >= static_cast<T>(0) && enter_distance <= inMaxDistance;
+  }
+
+  // Calls inChildFunction(inChildSequentialIndex, inChildEnterDistances, inChildExitDistances) for the (up to 4)
+  // children of a node crossed by the ray, in the order the ray crosses them. The child sequential indices are the
+  // mirrored ones (XOR them with the mirror mask). inGetNodeCenter() is only called for rays parallel to some axis.
+  template <typename T, typename TGetNodeCenter, typename TChildFunction>
+  void ForEachParametricChild(const PrecomputedRay3<T>& inRay,
+      const Vec3<T>& inEnterDistances,
+      const Vec3<T>& inExitDistances,
+      const TGetNodeCenter& inGetNodeCenter,
+      const TChildFunction& inChildFunction)
+  {
+    // Parameters at the node mid planes. A ray parallel to an axis is before or after its mid plane forever.
+    const auto& ray_origin = inRay.GetOrigin();
+    const auto& ray_direction = inRay.GetDirection();
+    Vec3<T> mid_distances;
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+      if (ray_direction[i] != static_cast<T>(0))
+        mid_distances[i] = (inEnterDistances[i] + inExitDistances[i]) / static_cast<T>(2);
+      else
+        mid_distances[i] = (ray_origin[i] < inGetNodeCenter()[i] ? Infinity<T>() : -Infinity<T>());
+    }
+
+    // First child: the ray enters it in the upper half of every axis whose mid plane it crosses before the node
+    const auto node_enter_distance = Max(inEnterDistances);
+    std::size_t child_sequential_index = 0;
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+      if (mid_distances[i] < node_enter_distance)
+        child_sequential_index |= GetChildSequentialIndexAxisBit(i);
+    }
+
+    // Walk the children crossed by the ray in order, by leaving each one through its closest exit plane
+    while (child_sequential_index < 8)
+    {
+      Vec3<T> child_enter_distances;
+      Vec3<T> child_exit_distances;
+      for (std::size_t i = 0; i < 3; ++i)
+      {
+        const auto is_upper_child = ((child_sequential_index & GetChildSequentialIndexAxisBit(i)) != 0);
+        child_enter_distances[i] = (is_upper_child ? mid_distances[i] : inEnterDistances[i]);
+        child_exit_distances[i] = (is_upper_child ? inExitDistances[i] : mid_distances[i]);
+      }
+
+      inChildFunction(child_sequential_index, child_enter_distances, child_exit_distances);
+
+      const auto exit_axis = static_cast<std::size_t>(
+          std::min_element(child_exit_distances.cbegin(), child_exit_distances.cend()) - child_exit_distances.cbegin());
+      const auto exit_axis_bit = GetChildSequentialIndexAxisBit(exit_axis);
+      const auto exits_node = ((child_sequential_index & exit_axis_bit) != 0);
+      child_sequential_index = (exits_node ? 8 : (child_sequential_index | exit_axis_bit));
+    }
+  }
 }
 
-template <typename TPrimitive>
+template <typename TPrimitive, typename TQueryCounters = OctreeNoQueryCounters>
 struct IntersectHelperStruct final
 {
   using ValueType = ValueType_t<TPrimitive>;
-  const Ray3<ValueType> mRay;
-  const ValueType mMaxDistance;
 
-  IntersectHelperStruct(const Ray3<ValueType>& inRay, const ValueType& inMaxDistance)
-      : mRay { inRay }, mMaxDistance { inMaxDistance }
+  struct ParametricNodeToExplore final
+  {
+    const Octree<TPrimitive>* mOctree = nullptr;
+    Vec3<ValueType> mEnterDistances; // Ray parameter at the (mirrored) min plane of each axis
+    Vec3<ValueType> mExitDistances;  // Ray parameter at the (mirrored) max plane of each axis
+  };
+
+  const PrecomputedRay3<ValueType> mRay;
+  const ValueType mMaxDistance;
+  ValueType mCurrentMaxDistance; // Shrinks to the closest intersection found so far in ONLY_CLOSEST queries
+  [[no_unique_address]] TQueryCounters mQueryCounters;
+
+  IntersectHelperStruct(const Ray3<ValueType>& inRay,
+      const ValueType& inMaxDistance,
+      const TQueryCounters& inQueryCounters = {})
+      : mRay { inRay },
+        mMaxDistance { inMaxDistance },
+        mCurrentMaxDistance { inMaxDistance },
+        mQueryCounters { inQueryCounters }
   {
   }
 
-  template <EIntersectMode TIntersectMode>
+  template <EIntersectMode TIntersectMode, EOctreeTraversalMode TTraversalMode>
   auto Intersect(const Octree<TPrimitive>& inTopOctree)
   {
     static_assert(TIntersectMode == EIntersectMode::ALL_INTERSECTIONS || TIntersectMode == EIntersectMode::ONLY_CLOSEST
             || TIntersectMode == EIntersectMode::ONLY_CHECK,
         "Unsupported EIntersectMode");
-    EXPECTS(inTopOctree.mPrimitivesPool);
+    static_assert(TTraversalMode == EOctreeTraversalMode::PLANES || TTraversalMode == EOctreeTraversalMode::PARAMETRIC,
+        "Unsupported EOctreeTraversalMode");
+    const auto primitives = inTopOctree.GetPrimitives();
 
     using IntersectionType = typename Octree<TPrimitive>::Intersection;
     std::vector<IntersectionType> intersections;
 
-    if constexpr (TIntersectMode == EIntersectMode::ONLY_CHECK)
+    if constexpr (TTraversalMode == EOctreeTraversalMode::PARAMETRIC)
+    {
+      return IntersectParametric<TIntersectMode>(inTopOctree, primitives);
+    }
+    else if constexpr (TIntersectMode == EIntersectMode::ONLY_CHECK)
     {
-      return IntersectRecursive<TIntersectMode>(inTopOctree, *inTopOctree.mPrimitivesPool, intersections);
+      return IntersectRecursive<TIntersectMode>(inTopOctree, primitives, intersections);
     }
     else
     {
-      IntersectRecursive<TIntersectMode>(inTopOctree, *inTopOctree.mPrimitivesPool, intersections);
+      IntersectRecursive<TIntersectMode>(inTopOctree, primitives, intersections);
 
       if constexpr (TIntersectMode == EIntersectMode::ALL_INTERSECTIONS)
       {
@@ -403,6 +854,201 @@ struct IntersectHelperStruct final
     }
   }
 
+  template <EIntersectMode TIntersectMode>
+  auto IntersectParametric(const Octree<TPrimitive>& inTopOctree, const Span<TPrimitive>& inPrimitivesPool)
+  {
+    std::vector<ParametricNodeToExplore> nodes_to_explore;
+    return IntersectParametric<TIntersectMode>(inTopOctree, inPrimitivesPool, nodes_to_explore);
+  }
+
+  // Same as above, but using the given nodes stack, so that its memory can be reused across queries.
+  // In ONLY_CHECK mode, only the hits inFilter accepts count (see IntersectAny).
+  template <EIntersectMode TIntersectMode, typename TFilter = OctreeAcceptAllFilter>
+  auto IntersectParametric(const Octree<TPrimitive>& inTopOctree,
+      const Span<TPrimitive>& inPrimitivesPool,
+      std::vector<ParametricNodeToExplore>& ioNodesToExplore,
+      const TFilter& inFilter = {})
+  {
+    using OctreeType = Octree<TPrimitive>;
+    using ChildSequentialIndexType = typename OctreeType::ChildSequentialIndex;
+    using IntersectionType = typename OctreeType::Intersection;
+
+    std::vector<IntersectionType> intersections;
+    std::optional<IntersectionType> closest_intersection;
+
+    ParametricNodeToExplore top_node_to_explore { &inTopOctree, Vec3<ValueType>(), Vec3<ValueType>() };
+    const auto mirror_mask = static_cast<ChildSequentialIndexType>(octree_detail::GetParametricRootDistances(mRay,
+        inTopOctree.mAABox,
+        top_node_to_explore.mEnterDistances,
+        top_node_to_explore.mExitDistances));
+
+    auto& nodes_to_explore = ioNodesToExplore;
+    nodes_to_explore.clear();
+    if (IsParametricNodeTraversed(top_node_to_explore))
+      nodes_to_explore.push_back(top_node_to_explore);
+
+    while (!nodes_to_explore.empty())
+    {
+      const auto node_to_explore = nodes_to_explore.back();
+      nodes_to_explore.pop_back();
+
+      // Nodes are popped front-to-back, so once the closest intersection is before the next node, we are done
+      if constexpr (TIntersectMode == EIntersectMode::ONLY_CLOSEST)
+      {
+        if (Max(node_to_explore.mEnterDistances) > mCurrentMaxDistance)
+        {
+          mQueryCounters.OnEarlyOut();
+          break;
+        }
+      }
+
+      mQueryCounters.OnNodeVisited();
+      const auto& octree = *node_to_explore.mOctree;
+      if (octree.IsLeaf())
+      {
+        // Base case, linear search through its contained primitives
+        for (const auto& primitive_index : octree.mPrimitivesIndices)
+        {
+          mQueryCounters.OnPrimitiveTested();
+          const auto& primitive = inPrimitivesPool[primitive_index];
+          if constexpr (TIntersectMode == EIntersectMode::ONLY_CHECK)
+          {
+            if (IntersectCheckPrimitive(primitive_index, primitive, inFilter))
+            {
+              mQueryCounters.OnEarlyOut();
+              return true;
+            }
+          }
+          else
+          {
+            TreatIntersectionResult<TIntersectMode>(primitive_index,
+                IntersectPrimitive<TIntersectMode>(primitive),
+                intersections,
+                closest_intersection);
+          }
+        }
+        continue;
+      }
+
+      // Collect the (up to 4) children crossed by the ray, in order
+      std::array<ParametricNodeToExplore, 4> children_to_explore;
+      std::size_t num_children_to_explore = 0;
+      octree_detail::ForEachParametricChild(
+          mRay,
+          node_to_explore.mEnterDistances,
+          node_to_explore.mExitDistances,
+          [&]() { return octree.mAABox.GetCenter(); },
+          [&](const ChildSequentialIndexType inChildSequentialIndex,
+              const Vec3<ValueType>& inChildEnterDistances,
+              const Vec3<ValueType>& inChildExitDistances) {
+            const auto child_octree = octree.GetChildOctree(inChildSequentialIndex ^ mirror_mask);
+            const auto child_to_explore
+                = ParametricNodeToExplore { child_octree, inChildEnterDistances, inChildExitDistances };
+            if (child_to_explore.mOctree && IsParametricNodeTraversed(child_to_explore))
+              children_to_explore[num_children_to_explore++] = child_to_explore;
+          });
+
+      // Push them reversed, so that the closest one is popped first
+      nodes_to_explore.insert(nodes_to_explore.end(),
+          std::make_reverse_iterator(children_to_explore.cbegin() + num_children_to_explore),
+          children_to_explore.crend());
+    }
+
+    if constexpr (TIntersectMode == EIntersectMode::ALL_INTERSECTIONS)
+      return intersections;
+    else if constexpr (TIntersectMode == EIntersectMode::ONLY_CLOSEST)
+      return closest_intersection;
+    else if constexpr (TIntersectMode == EIntersectMode::ONLY_CHECK)
+      return false;
+  }
+
+  bool IsParametricNodeTraversed(const ParametricNodeToExplore& inNodeToExplore) const
+  {
+    return octree_detail::IsParametricNodeTraversed(inNodeToExplore.mEnterDistances,
+        inNodeToExplore.mExitDistances,
+        mCurrentMaxDistance);
+  }
+
+  template <EIntersectMode TIntersectMode>
+  auto IntersectPrimitive(const TPrimitive& inPrimitive) const
+  {
+    return ray_query_detail::IntersectRayPrimitive<TIntersectMode>(mRay, inPrimitive, mCurrentMaxDistance);
+  }
+
+  bool IntersectCheckPrimitive(const TPrimitive& inPrimitive) const
+  {
+    if (mMaxDistance == Infinity<ValueType>())
+      return ::ez::IntersectCheck(mRay.GetRay(), inPrimitive);
+
+    const auto primitive_closest_intersection = ::ez::IntersectClosest(mRay.GetRay(), inPrimitive);
+    return primitive_closest_intersection && *primitive_closest_intersection <= mMaxDistance;
+  }
+
+  // Whether any of the primitive hits within the max distance is accepted by inFilter. All the hits are offered, not
+  // only the closest one, so that a rejected front hit (e.g. an alpha-tested texel) does not hide the back one.
+  template <typename TFilter>
+  bool IntersectCheckPrimitive(const typename Octree<TPrimitive>::PrimitiveIndex inPrimitiveIndex,
+      const TPrimitive& inPrimitive,
+      const TFilter& inFilter) const
+  {
+    if constexpr (std::is_same_v<TFilter, OctreeAcceptAllFilter>)
+    {
+      UNUSED(inPrimitiveIndex);
+      UNUSED(inFilter);
+      return IntersectCheckPrimitive(inPrimitive);
+    }
+    else
+    {
+      const auto is_accepted = [&](const auto& inIntersectionDistance) {
+        return inIntersectionDistance && *inIntersectionDistance <= mMaxDistance
+            && inFilter(inPrimitiveIndex, *inIntersectionDistance);
+      };
+
+      const auto primitive_intersections = IntersectPrimitive<EIntersectMode::ALL_INTERSECTIONS>(inPrimitive);
+      if constexpr (IsArray_v<decltype(primitive_intersections)>)
+        return std::any_of(primitive_intersections.cbegin(), primitive_intersections.cend(), is_accepted);
+      else
+        return is_accepted(primitive_intersections);
+    }
+  }
+
+  template <EIntersectMode TIntersectMode, typename TIntersectionDistances>
+  void TreatIntersectionResult(const typename Octree<TPrimitive>::PrimitiveIndex inPrimitiveIndex,
+      const TIntersectionDistances& inIntersectionDistances,
+      std::vector<typename Octree<TPrimitive>::Intersection>& ioIntersections,
+      std::optional<typename Octree<TPrimitive>::Intersection>& ioClosestIntersection)
+  {
+    if constexpr (IsArray_v<TIntersectionDistances>)
+    {
+      for (const auto& intersection_distance : inIntersectionDistances)
+      {
+        TreatIntersectionResult<TIntersectMode>(inPrimitiveIndex,
+            intersection_distance,
+            ioIntersections,
+            ioClosestIntersection);
+      }
+    }
+    else
+    {
+      const auto& intersection_distance = inIntersectionDistances;
+      if (!intersection_distance || *intersection_distance > mCurrentMaxDistance)
+        return; // Do not consider intersections further than the maximum distance (or the closest one so far)
+
+      if constexpr (TIntersectMode == EIntersectMode::ALL_INTERSECTIONS)
+      {
+        ioIntersections.emplace_back(*intersection_distance, inPrimitiveIndex);
+      }
+      else if constexpr (TIntersectMode == EIntersectMode::ONLY_CLOSEST)
+      {
+        if (!ioClosestIntersection || *intersection_distance < ioClosestIntersection->mDistance)
+        {
+          ioClosestIntersection = typename Octree<TPrimitive>::Intersection { *intersection_distance, inPrimitiveIndex };
+          mCurrentMaxDistance = *intersection_distance;
+        }
+      }
+    }
+  }
+
   template <EIntersectMode TIntersectMode, typename TIntersectionDistances>
   auto TreatIntersectionResult(const Octree<TPrimitive>& inOctree,
       const Octree<TPrimitive>::PrimitiveIndex inPrimitiveIndex,
@@ -419,8 +1065,8 @@ struct IntersectHelperStruct final
     else
     {
       const auto& inIntersectionDistance = inIntersectionDistances;
-      if (!inIntersectionDistance || *inIntersectionDistance > mMaxDistance)
-        return; // Do not consider intersections further than the maximum distance
+      if (!inIntersectionDistance || *inIntersectionDistance > mCurrentMaxDistance)
+        return; // Do not consider intersections further than the maximum distance (or the closest one so far)
 
       if constexpr (TIntersectMode == EIntersectMode::ALL_INTERSECTIONS)
       {
@@ -429,35 +1075,34 @@ struct IntersectHelperStruct final
       }
       else if constexpr (TIntersectMode == EIntersectMode::ONLY_CLOSEST)
       {
-        if (ioIntersections.empty() || *inIntersectionDistance < ioIntersections.front().mDistance)
-        {
-          // Only save the closest intersection out of all primitives
+        // Only save the closest intersection out of all primitives
+        if (ioIntersections.empty())
           ioIntersections.emplace_back(*inIntersectionDistance, inPrimitiveIndex);
-          ioIntersections.resize(0);
-        }
+        else if (*inIntersectionDistance < ioIntersections.front().mDistance)
+          ioIntersections.front() = typename Octree<TPrimitive>::Intersection { *inIntersectionDistance, inPrimitiveIndex };
+        mCurrentMaxDistance = ioIntersections.front().mDistance;
       }
     }
   }
 
   template <EIntersectMode TIntersectMode>
   auto IntersectRecursive(const Octree<TPrimitive>& inOctree,
-      const std::vector<TPrimitive>& inPrimitivesPool,
+      const Span<TPrimitive>& inPrimitivesPool,
       std::vector<typename Octree<TPrimitive>::Intersection>& ioIntersections)
   {
     using OctreeType = Octree<TPrimitive>;
     using ChildSequentialIndexType = typename OctreeType::ChildSequentialIndex;
 
+    mQueryCounters.OnNodeVisited();
     const auto aabox_size = inOctree.mAABox.GetSize();
-    const auto aabox_half_size = (aabox_size / static_cast<ValueType>(2));
 
-    // Check whether this AABox needs to be checked because of max distance or not
-    if (mMaxDistance != Infinity<ValueType>())
+    // Skip the nodes further from the ray origin than the max distance (or the closest intersection so far)
+    if (mCurrentMaxDistance != Infinity<ValueType>())
     {
-      const auto max_box_half_size = Max(aabox_half_size);
-      const auto aabox_sphere = Sphere<ValueType>(inOctree.mAABox.GetCenter(), max_box_half_size);
-      const auto ray_max_distance_sphere = Sphere<ValueType>(mRay.GetOrigin(), mMaxDistance);
-      if (!::ez::IntersectCheck(aabox_sphere, ray_max_distance_sphere))
+      const auto& ray_origin = mRay.GetOrigin();
+      if (SqDistance(ray_origin, ClosestPoint(inOctree.mAABox, ray_origin)) > Sq(mCurrentMaxDistance))
       {
+        mQueryCounters.OnEarlyOut();
         if constexpr (TIntersectMode == EIntersectMode::ONLY_CHECK)
         {
           return false;
@@ -474,9 +1119,10 @@ struct IntersectHelperStruct final
       // Base case, linear search through its contained primitives
       for (const auto& primitive_index : inOctree.mPrimitivesIndices)
       {
+        mQueryCounters.OnPrimitiveTested();
         const auto& primitive = inPrimitivesPool.at(primitive_index);
 
-        const auto primitive_intersections = ::ez::Intersect<TIntersectMode>(mRay, primitive);
+        const auto primitive_intersections = IntersectPrimitive<TIntersectMode>(primitive);
         // TODO: Put this if/else below into a separate function, as done with TreatIntersectionResult
         if constexpr (IsArray_v<decltype(primitive_intersections)>)
         {
@@ -485,7 +1131,10 @@ struct IntersectHelperStruct final
             if (std::any_of(primitive_intersections.cbegin(),
                     primitive_intersections.cend(),
                     [&](const auto& inHasIntersected) { return inHasIntersected; }))
+            {
+              mQueryCounters.OnEarlyOut();
               return true;
+            }
           }
           else
           {
@@ -504,7 +1153,10 @@ struct IntersectHelperStruct final
           if constexpr (TIntersectMode == EIntersectMode::ONLY_CHECK)
           {
             if (primitive_intersection)
+            {
+              mQueryCounters.OnEarlyOut();
               return true;
+            }
           }
           else
           {
@@ -543,6 +1195,7 @@ struct IntersectHelperStruct final
 
       // Recursive case, check which children octrees the ray intersects
       std::array<std::optional<typename OctreeType::ChildSequentialIndex>, 4> child_octree_indices_to_explore;
+      std::array<ValueType, 4> child_octree_enter_distances {};
 
       // Determine entry intersection in the octree by looking at external planes.
       // This will give us the first child octree to explore.
@@ -555,11 +1208,11 @@ struct IntersectHelperStruct final
         const auto remapped_external_plane_normal = Max(external_plane_normal, Zero<Vec3<ValueType>>());
         const auto external_plane_point = inOctree.mAABox.GetMin() + remapped_external_plane_normal * aabox_size;
         const auto external_plane = Plane<ValueType>(external_plane_normal, external_plane_point);
-        const auto ray_plane_intersection_distance = ::ez::IntersectClosest(mRay, external_plane);
+        const auto ray_plane_intersection_distance = ::ez::IntersectClosest(mRay.GetRay(), external_plane);
         if (!ray_plane_intersection_distance)
           continue;
 
-        if (*ray_plane_intersection_distance > mMaxDistance)
+        if (*ray_plane_intersection_distance > mCurrentMaxDistance)
           continue;
 
         const auto external_plane_id = static_cast<typename OctreeType::EExternalOctreePlaneId>(external_plane_i);
@@ -569,6 +1222,7 @@ struct IntersectHelperStruct final
           continue;
 
         child_octree_indices_to_explore[0] = first_child_octree_id_to_explore;
+        child_octree_enter_distances[0] = *ray_plane_intersection_distance;
         break; // We can only enter to the octree from one of its faces, so as soon as we find it, break
       }
 
@@ -584,11 +1238,11 @@ struct IntersectHelperStruct final
         const auto& internal_plane_normal = OctreeType::InternalOctreePlaneNormals.at(internal_plane_i);
         const auto internal_plane_point = inOctree.mAABox.GetCenter();
         const auto internal_plane = Plane<ValueType>(internal_plane_normal, internal_plane_point);
-        const auto ray_plane_intersection_distance = ::ez::IntersectClosest(mRay, internal_plane);
+        const auto ray_plane_intersection_distance = ::ez::IntersectClosest(mRay.GetRay(), internal_plane);
         if (!ray_plane_intersection_distance)
           continue;
 
-        if (*ray_plane_intersection_distance > mMaxDistance)
+        if (*ray_plane_intersection_distance > mCurrentMaxDistance)
           continue;
 
         const auto internal_plane_id = static_cast<typename OctreeType::EInternalOctreePlaneId>(internal_plane_i);
@@ -611,23 +1265,37 @@ struct IntersectHelperStruct final
             [](auto& inLHS, auto& inRHS) { return std::get<1>(inLHS) < std::get<1>(inRHS); });
       }
 
-      child_octree_indices_to_explore[1] = std::get<0>(internal_plane_intersection_distances[0]);
-      child_octree_indices_to_explore[2] = std::get<0>(internal_plane_intersection_distances[1]);
-      child_octree_indices_to_explore[3] = std::get<0>(internal_plane_intersection_distances[2]);
+      for (std::size_t i = 0; i < 3; ++i)
+      {
+        child_octree_indices_to_explore[i + 1] = std::get<0>(internal_plane_intersection_distances[i]);
+        child_octree_enter_distances[i + 1] = std::get<1>(internal_plane_intersection_distances[i]);
+      }
 
       // Recursive calls to explore up to 4 children
-      for (const auto child_octree_index : child_octree_indices_to_explore)
+      for (std::size_t i = 0; i < child_octree_indices_to_explore.size(); ++i)
       {
+        const auto& child_octree_index = child_octree_indices_to_explore[i];
         if (!child_octree_index)
           continue;
 
+        // Children are sorted front-to-back, so once the closest intersection is before the next child, we are done.
+        // An intersection found in a child can be further than the next ones (primitives can span several children).
+        if constexpr (TIntersectMode == EIntersectMode::ONLY_CLOSEST)
+        {
+          if (child_octree_enter_distances[i] > mCurrentMaxDistance)
+          {
+            mQueryCounters.OnEarlyOut();
+            break;
+          }
+        }
+
         const auto child_octree_to_explore = inOctree.GetChildOctree(*child_octree_index);
         if (!child_octree_to_explore)
           continue;
 
         if constexpr (TIntersectMode == EIntersectMode::ONLY_CHECK)
         {
-          if (IntersectRecursive<TIntersectMode, TPrimitive>(*child_octree_to_explore,
+          if (IntersectRecursive<TIntersectMode>(*child_octree_to_explore,
                   inPrimitivesPool,
                   ioIntersections))
           {
@@ -637,11 +1305,6 @@ struct IntersectHelperStruct final
         else
         {
           IntersectRecursive<TIntersectMode>(*child_octree_to_explore, inPrimitivesPool, ioIntersections);
-          if constexpr (TIntersectMode == EIntersectMode::ONLY_CLOSEST)
-          {
-            if (ioIntersections.size() >= 1)
-              break;
-          }
         }
       }
     }
@@ -653,21 +1316,568 @@ struct IntersectHelperStruct final
   }
 };
 
-template <EIntersectMode TIntersectMode, typename TPrimitive>
+template <EIntersectMode TIntersectMode,
+    EOctreeTraversalMode TTraversalMode = EOctreeTraversalMode::PARAMETRIC,
+    typename TPrimitive>
 auto Intersect(const Octree<TPrimitive>& inTopOctree,
     const Ray3<ValueType_t<TPrimitive>>& inRay,
     const ValueType_t<TPrimitive> inMaxDistance = Infinity<ValueType_t<TPrimitive>>())
 {
   IntersectHelperStruct<TPrimitive> intersecter { inRay, inMaxDistance };
-  return intersecter.template Intersect<TIntersectMode>(inTopOctree);
+  return intersecter.template Intersect<TIntersectMode, TTraversalMode>(inTopOctree);
 }
 
-template <EIntersectMode TIntersectMode, typename TPrimitive>
+template <EIntersectMode TIntersectMode,
+    EOctreeTraversalMode TTraversalMode = EOctreeTraversalMode::PARAMETRIC,
+    typename TPrimitive>
 auto Intersect(const Ray3<ValueType_t<TPrimitive>>& inRay,
     const Octree<TPrimitive>& inTopOctree,
     const ValueType_t<TPrimitive> inMaxDistance = Infinity<ValueType_t<TPrimitive>>())
 {
-  return Intersect<TIntersectMode, TPrimitive>(inTopOctree, inRay, inMaxDistance);
+  return Intersect<TIntersectMode, TTraversalMode, TPrimitive>(inTopOctree, inRay, inMaxDistance);
+}
+
+// Same as above, also adding the traversal work of this query to ioQueryCounters
+template <EIntersectMode TIntersectMode,
+    EOctreeTraversalMode TTraversalMode = EOctreeTraversalMode::PARAMETRIC,
+    typename TPrimitive>
+auto Intersect(const Octree<TPrimitive>& inTopOctree,
+    const Ray3<ValueType_t<TPrimitive>>& inRay,
+    const ValueType_t<TPrimitive> inMaxDistance,
+    OctreeQueryCounters& ioQueryCounters)
+{
+  IntersectHelperStruct<TPrimitive, OctreeQueryCounters> intersecter { inRay, inMaxDistance, ioQueryCounters };
+  const auto intersection_result = intersecter.template Intersect<TIntersectMode, TTraversalMode>(inTopOctree);
+  ioQueryCounters = intersecter.mQueryCounters;
+  return intersection_result;
+}
+
+template <typename TPrimitive, typename TFilter>
+bool IntersectAny(const Octree<TPrimitive>& inTopOctree,
+    const Ray3<ValueType_t<TPrimitive>>& inRay,
+    const TFilter& inFilter,
+    const ValueType_t<TPrimitive> inMaxDistance)
+{
+  IntersectHelperStruct<TPrimitive> intersecter { inRay, inMaxDistance };
+  std::vector<typename IntersectHelperStruct<TPrimitive>::ParametricNodeToExplore> nodes_to_explore;
+  return intersecter.template IntersectParametric<EIntersectMode::ONLY_CHECK>(inTopOctree,
+      inTopOctree.GetPrimitives(),
+      nodes_to_explore,
+      inFilter);
+}
+
+template <typename TPrimitive>
+void IntersectBatch(const Octree<TPrimitive>& inTopOctree,
+    const Span<Ray3<ValueType_t<TPrimitive>>>& inRays,
+    std::vector<std::optional<typename Octree<TPrimitive>::Intersection>>& outIntersections,
+    const OctreeBatchIntersectOptions<ValueType_t<TPrimitive>>& inOptions)
+{
+  outIntersections.clear();
+  outIntersections.resize(inRays.GetNumberOfElements());
+
+  // One nodes stack per thread, grown once and then reused by all the rays that thread processes
+  using NodesToExplore = std::vector<typename IntersectHelperStruct<TPrimitive>::ParametricNodeToExplore>;
+  std::vector<NodesToExplore> per_thread_nodes_to_explore(std::max(inOptions.mParallelPolicy.mNumThreads,
+      static_cast<std::size_t>(1)));
+
+  const auto primitives_pool = inTopOctree.GetPrimitives();
+  ParallelFor(
+      inOptions.mParallelPolicy,
+      inRays.GetNumberOfElements(),
+      [&](const std::size_t inRayIndex, const std::size_t inThreadIndex) {
+        IntersectHelperStruct<TPrimitive> intersecter { inRays.at(inRayIndex), inOptions.mMaxDistance };
+        outIntersections[inRayIndex] = intersecter.template IntersectParametric<EIntersectMode::ONLY_CLOSEST>(
+            inTopOctree,
+            primitives_pool,
+            per_thread_nodes_to_explore[inThreadIndex]);
+      },
+      inOptions.mGrainSize);
+}
+
+template <typename TPrimitive>
+std::vector<std::optional<typename Octree<TPrimitive>::Intersection>> IntersectBatch(
+    const Octree<TPrimitive>& inTopOctree,
+    const Span<Ray3<ValueType_t<TPrimitive>>>& inRays,
+    const OctreeBatchIntersectOptions<ValueType_t<TPrimitive>>& inOptions)
+{
+  std::vector<std::optional<typename Octree<TPrimitive>::Intersection>> intersections;
+  IntersectBatch(inTopOctree, inRays, intersections, inOptions);
+  return intersections;
+}
+
+// Packet traversal, meant for coherent rays (camera or sensor grids). The children of a node are slab-tested for all
+// the packet lanes at once, and only the ones some lane enters before its closest intersection so far are pushed, the
+// one with the closest enter distance being popped first. A popped node drops the lanes that found a closer hit since.
+// In leaves, primitives with an IntersectClosestLanes kernel (boxes, spheres, triangles) are tested against all the
+// lanes at once, the others lane by lane. Incoherent rays diverge early and end up ~2x slower than one by one (see
+// benchmarks/OctreePacketBenchmark.cpp).
+template <EIntersectMode TIntersectMode, typename TPrimitive, std::size_t TWidth>
+auto Intersect(const Octree<TPrimitive>& inTopOctree,
+    const RayPacket<ValueType_t<TPrimitive>, TWidth>& inRayPacket,
+    const ValueType_t<TPrimitive> inMaxDistance = Infinity<ValueType_t<TPrimitive>>())
+{
+  static_assert(TIntersectMode == EIntersectMode::ONLY_CLOSEST, "Unsupported EIntersectMode");
+
+  using ValueType = ValueType_t<TPrimitive>;
+  using OctreeType = Octree<TPrimitive>;
+  using RayPacketType = RayPacket<ValueType, TWidth>;
+  using LaneMask = typename RayPacketType::LaneMask;
+  using LaneValues = typename RayPacketType::LaneValues;
+
+  struct PacketNodeToExplore final
+  {
+    const OctreeType* mOctree = nullptr;
+    LaneMask mLanesMask = 0;
+    LaneValues mEnterDistances {};                       // Per lane, only valid for the lanes in mLanesMask
+    ValueType mMinEnterDistance = Infinity<ValueType>(); // Among the lanes in mLanesMask
+  };
+
+  constexpr auto HasIntersectClosestLanes
+      = requires(const RayPacketType& inPacket, const TPrimitive& inPrimitive, LaneValues& ioLaneValues) {
+          IntersectClosestLanes(inPacket, inPrimitive, ioLaneValues, LaneMask {}, ioLaneValues);
+        };
+
+  std::array<std::optional<typename OctreeType::Intersection>, TWidth> closest_intersections;
+
+  // The closest intersection distance of each lane so far, nodes further than it are culled for that lane
+  LaneValues max_distances;
+  max_distances.fill(inMaxDistance);
+
+  std::vector<PacketNodeToExplore> nodes_to_explore;
+  PacketNodeToExplore top_node_to_explore { &inTopOctree };
+  top_node_to_explore.mLanesMask = IntersectCheckLanes(inRayPacket,
+      inTopOctree.GetAABox(),
+      max_distances,
+      inRayPacket.GetActiveMask(),
+      top_node_to_explore.mEnterDistances);
+  if (top_node_to_explore.mLanesMask != 0)
+    nodes_to_explore.push_back(top_node_to_explore);
+
+  const auto primitives_pool = inTopOctree.GetPrimitives();
+  while (!nodes_to_explore.empty())
+  {
+    const auto node_to_explore = nodes_to_explore.back();
+    nodes_to_explore.pop_back();
+
+    const auto& enter_distances = node_to_explore.mEnterDistances;
+    std::array<SoALaneMask, TWidth> lanes_still_entering;
+    for (std::size_t lane = 0; lane < TWidth; ++lane)
+      lanes_still_entering[lane] = static_cast<SoALaneMask>(enter_distances[lane] <= max_distances[lane]);
+    const auto lanes_mask = (node_to_explore.mLanesMask & primitives_soa_detail::GetLanesMask(lanes_still_entering));
+    if (lanes_mask == 0)
+      continue;
+
+    const auto& octree = *node_to_explore.mOctree;
+    if (octree.IsLeaf())
+    {
+      // Base case, test the contained primitives against every lane that reached this leaf
+      if constexpr (HasIntersectClosestLanes)
+      {
+        LaneValues intersection_distances;
+        for (const auto& primitive_index : octree.GetPrimitivesIndices())
+        {
+          // The kernel only reports hits within max_distances, i.e. not further than the closest one so far
+          for (auto hit_lanes_mask = IntersectClosestLanes(inRayPacket,
+                   primitives_pool[primitive_index],
+                   max_distances,
+                   lanes_mask,
+                   intersection_distances);
+               hit_lanes_mask != 0;
+               hit_lanes_mask &= (hit_lanes_mask - 1))
+          {
+            const auto lane = static_cast<std::size_t>(std::countr_zero(hit_lanes_mask));
+            auto& closest_intersection = closest_intersections[lane];
+            if (!closest_intersection || intersection_distances[lane] < closest_intersection->mDistance)
+            {
+              closest_intersection
+                  = typename OctreeType::Intersection { intersection_distances[lane], primitive_index };
+              max_distances[lane] = intersection_distances[lane];
+            }
+          }
+        }
+      }
+      else
+      {
+        std::vector<typename OctreeType::Intersection> unused_intersections;
+        for (auto remaining_lanes_mask = lanes_mask; remaining_lanes_mask != 0;
+             remaining_lanes_mask &= (remaining_lanes_mask - 1))
+        {
+          const auto lane = static_cast<std::size_t>(std::countr_zero(remaining_lanes_mask));
+          IntersectHelperStruct<TPrimitive> intersecter { inRayPacket.GetRay(lane), max_distances[lane] };
+          for (const auto& primitive_index : octree.GetPrimitivesIndices())
+          {
+            intersecter.template TreatIntersectionResult<EIntersectMode::ONLY_CLOSEST>(primitive_index,
+                intersecter.template IntersectPrimitive<EIntersectMode::ONLY_CLOSEST>(primitives_pool[primitive_index]),
+                unused_intersections,
+                closest_intersections[lane]);
+          }
+          max_distances[lane] = intersecter.mCurrentMaxDistance;
+        }
+      }
+      continue;
+    }
+
+    // Keep the children some lane enters, sorted by decreasing closest enter distance (small insertion sort)
+    std::array<PacketNodeToExplore, 8> children_to_explore;
+    std::size_t num_children_to_explore = 0;
+    for (std::size_t i = 0; i < 8; ++i)
+    {
+      const auto child_octree = octree.GetChildOctree(i);
+      if (!child_octree)
+        continue;
+
+      PacketNodeToExplore child_to_explore { child_octree };
+      child_to_explore.mLanesMask = IntersectCheckLanes(inRayPacket,
+          child_octree->GetAABox(),
+          max_distances,
+          lanes_mask,
+          child_to_explore.mEnterDistances);
+      if (child_to_explore.mLanesMask == 0)
+        continue;
+
+      for (auto child_lanes_mask = child_to_explore.mLanesMask; child_lanes_mask != 0;
+           child_lanes_mask &= (child_lanes_mask - 1))
+      {
+        const auto lane = static_cast<std::size_t>(std::countr_zero(child_lanes_mask));
+        child_to_explore.mMinEnterDistance
+            = Min(child_to_explore.mMinEnterDistance, child_to_explore.mEnterDistances[lane]);
+      }
+
+      auto insert_index = num_children_to_explore++;
+      for (; insert_index > 0
+           && children_to_explore[insert_index - 1].mMinEnterDistance < child_to_explore.mMinEnterDistance;
+           --insert_index)
+        children_to_explore[insert_index] = children_to_explore[insert_index - 1];
+      children_to_explore[insert_index] = child_to_explore;
+    }
+
+    // The closest one is pushed last, so that it is popped first
+    nodes_to_explore.insert(nodes_to_explore.end(),
+        children_to_explore.cbegin(),
+        children_to_explore.cbegin() + num_children_to_explore);
+  }
+
+  return closest_intersections;
+}
+
+namespace octree_detail
+{
+  template <typename TPrimitive>
+  auto SqDistanceToPrimitive(const Vec3<ValueType_t<TPrimitive>>& inPoint, const TPrimitive& inPrimitive)
+  {
+    return SqDistance(inPoint, ClosestPoint(inPrimitive, inPoint));
+  }
+
+  // Calls inLeafFunction(inLeafOctree) for the leaves whose box is at squared distance <= inGetMaxSqDistance(),
+  // closest first. The max squared distance can shrink while exploring. Nodes are explored best-first.
+  template <typename TPrimitive, typename TGetMaxSqDistance, typename TLeafFunction>
+  void ForEachLeafBestFirst(const Octree<TPrimitive>& inTopOctree,
+      const Vec3<ValueType_t<TPrimitive>>& inPoint,
+      const TGetMaxSqDistance& inGetMaxSqDistance,
+      const TLeafFunction& inLeafFunction)
+  {
+    using NodeToExplore = std::pair<ValueType_t<TPrimitive>, const Octree<TPrimitive>*>; // Squared distance, octree
+    const auto CompareNodesToExplore
+        = [](const NodeToExplore& inLHS, const NodeToExplore& inRHS) { return inLHS.first > inRHS.first; };
+    std::priority_queue<NodeToExplore, std::vector<NodeToExplore>, decltype(CompareNodesToExplore)> nodes_to_explore(
+        CompareNodesToExplore);
+
+    nodes_to_explore.emplace(SqDistance(inTopOctree.GetAABox(), inPoint), &inTopOctree);
+    while (!nodes_to_explore.empty())
+    {
+      const auto [node_sq_distance, octree] = nodes_to_explore.top();
+      nodes_to_explore.pop();
+
+      // The rest of nodes are even further
+      if (node_sq_distance > inGetMaxSqDistance())
+        break;
+
+      if (octree->IsLeaf())
+      {
+        inLeafFunction(*octree);
+        continue;
+      }
+
+      for (const auto& child_octree : octree->GetChildren())
+      {
+        if (!child_octree)
+          continue;
+
+        const auto child_sq_distance = SqDistance(child_octree->GetAABox(), inPoint);
+        if (child_sq_distance <= inGetMaxSqDistance())
+          nodes_to_explore.emplace(child_sq_distance, child_octree.get());
+      }
+    }
+  }
+
+  template <typename TPrimitive>
+  std::size_t WriteSortedFoundPrimitives(
+      std::vector<std::pair<ValueType_t<TPrimitive>, typename Octree<TPrimitive>::PrimitiveIndex>>& ioFoundPrimitives,
+      std::vector<typename Octree<TPrimitive>::PrimitiveIndex>& outPrimitivesIndices,
+      std::vector<ValueType_t<TPrimitive>>& outDistances)
+  {
+    std::sort(ioFoundPrimitives.begin(), ioFoundPrimitives.end());
+
+    outPrimitivesIndices.resize(ioFoundPrimitives.size());
+    outDistances.resize(ioFoundPrimitives.size());
+    for (std::size_t i = 0; i < ioFoundPrimitives.size(); ++i)
+    {
+      outDistances[i] = std::sqrt(ioFoundPrimitives[i].first);
+      outPrimitivesIndices[i] = ioFoundPrimitives[i].second;
+    }
+    return ioFoundPrimitives.size();
+  }
+}
+
+template <typename TPrimitive>
+std::size_t FindKNearest(const Octree<TPrimitive>& inTopOctree,
+    const Vec3<ValueType_t<TPrimitive>>& inPoint,
+    const std::size_t inK,
+    std::vector<typename Octree<TPrimitive>::PrimitiveIndex>& outPrimitivesIndices,
+    std::vector<ValueType_t<TPrimitive>>& outDistances)
+{
+  using ValueType = ValueType_t<TPrimitive>;
+  using PrimitiveIndex = typename Octree<TPrimitive>::PrimitiveIndex;
+
+  const auto k = inK;
+  if (k == 0)
+  {
+    outPrimitivesIndices.clear();
+    outDistances.clear();
+    return 0;
+  }
+
+  // Max-heap with the k closest primitives found so far (squared distance, primitive index)
+  std::vector<std::pair<ValueType, PrimitiveIndex>> k_nearest_primitives;
+  k_nearest_primitives.reserve(k + 1);
+  const auto GetMaxSqDistance = [&]() {
+    return (k_nearest_primitives.size() < k) ? Infinity<ValueType>() : k_nearest_primitives.front().first;
+  };
+
+  const auto primitives_pool = inTopOctree.GetPrimitives();
+  octree_detail::ForEachLeafBestFirst(inTopOctree, inPoint, GetMaxSqDistance, [&](const Octree<TPrimitive>& inLeaf) {
+    for (const auto& primitive_index : inLeaf.GetPrimitivesIndices())
+    {
+      const auto primitive_sq_distance
+          = octree_detail::SqDistanceToPrimitive(inPoint, primitives_pool[primitive_index]);
+      if (primitive_sq_distance >= GetMaxSqDistance())
+        continue;
+
+      // A primitive can be in several leaves
+      if (std::any_of(k_nearest_primitives.cbegin(),
+              k_nearest_primitives.cend(),
+              [&](const auto& inNearestPrimitive) { return inNearestPrimitive.second == primitive_index; }))
+        continue;
+
+      k_nearest_primitives.emplace_back(primitive_sq_distance, primitive_index);
+      std::push_heap(k_nearest_primitives.begin(), k_nearest_primitives.end());
+      if (k_nearest_primitives.size() > k)
+      {
+        std::pop_heap(k_nearest_primitives.begin(), k_nearest_primitives.end());
+        k_nearest_primitives.pop_back();
+      }
+    }
+  });
+
+  return octree_detail::WriteSortedFoundPrimitives<TPrimitive>(k_nearest_primitives,
+      outPrimitivesIndices,
+      outDistances);
+}
+
+template <typename TPrimitive>
+std::size_t FindWithinRadius(const Octree<TPrimitive>& inTopOctree,
+    const Vec3<ValueType_t<TPrimitive>>& inPoint,
+    const ValueType_t<TPrimitive> inRadius,
+    std::vector<typename Octree<TPrimitive>::PrimitiveIndex>& outPrimitivesIndices,
+    std::vector<ValueType_t<TPrimitive>>& outDistances)
+{
+  using ValueType = ValueType_t<TPrimitive>;
+  using PrimitiveIndex = typename Octree<TPrimitive>::PrimitiveIndex;
+
+  const auto sq_radius = Sq(inRadius);
+  std::vector<std::pair<ValueType, PrimitiveIndex>> found_primitives;
+  const auto primitives_pool = inTopOctree.GetPrimitives();
+  octree_detail::ForEachLeafBestFirst(
+      inTopOctree,
+      inPoint,
+      [&]() { return sq_radius; },
+      [&](const Octree<TPrimitive>& inLeaf) {
+        for (const auto& primitive_index : inLeaf.GetPrimitivesIndices())
+        {
+          const auto primitive_sq_distance
+              = octree_detail::SqDistanceToPrimitive(inPoint, primitives_pool[primitive_index]);
+          if (primitive_sq_distance <= sq_radius)
+            found_primitives.emplace_back(primitive_sq_distance, primitive_index);
+        }
+      });
+
+  // A primitive can be in several leaves
+  std::sort(found_primitives.begin(), found_primitives.end(), [](const auto& inLHS, const auto& inRHS) {
+    return inLHS.second < inRHS.second;
+  });
+  found_primitives.erase(std::unique(found_primitives.begin(),
+                             found_primitives.end(),
+                             [](const auto& inLHS, const auto& inRHS) { return inLHS.second == inRHS.second; }),
+      found_primitives.end());
+
+  return octree_detail::WriteSortedFoundPrimitives<TPrimitive>(found_primitives, outPrimitivesIndices, outDistances);
+}
+
+namespace octree_detail
+{
+  // Calls inCallback(inPrimitiveIndex) for every primitive overlapping inQueryPrimitive, as the traversal finds them
+  template <typename TPrimitive, typename TQueryPrimitive, typename TCallback>
+  void ForEachOverlappingPrimitive(const Octree<TPrimitive>& inTopOctree,
+      const TQueryPrimitive& inQueryPrimitive,
+      const TCallback& inCallback)
+  {
+    using PrimitiveIndex = typename Octree<TPrimitive>::PrimitiveIndex;
+    using AABoxType = typename Octree<TPrimitive>::AABoxType;
+    constexpr auto CanCheckContainedAABox
+        = requires(const TQueryPrimitive& inQuery, const AABoxType& inAABox) { Contains(inQuery, inAABox); };
+
+    // A primitive can be in several leaves, it is only reported the first time it is found
+    const auto primitives_pool = inTopOctree.GetPrimitives();
+    std::vector<bool> is_primitive_reported(primitives_pool.GetNumberOfElements(), false);
+    const auto ReportPrimitive = [&](const PrimitiveIndex inPrimitiveIndex) {
+      if (is_primitive_reported[inPrimitiveIndex])
+        return;
+
+      is_primitive_reported[inPrimitiveIndex] = true;
+      inCallback(inPrimitiveIndex);
+    };
+
+    std::vector<const Octree<TPrimitive>*> octrees_to_explore { &inTopOctree };
+    const auto ReportAllSubtreePrimitives = [&](const Octree<TPrimitive>& inSubtreeOctree) {
+      const auto subtree_begin = octrees_to_explore.size();
+      octrees_to_explore.push_back(&inSubtreeOctree);
+      while (octrees_to_explore.size() > subtree_begin)
+      {
+        const auto octree = octrees_to_explore.back();
+        octrees_to_explore.pop_back();
+        for (const auto& primitive_index : octree->GetPrimitivesIndices()) ReportPrimitive(primitive_index);
+        for (const auto& child_octree : octree->GetChildren())
+        {
+          if (child_octree)
+            octrees_to_explore.push_back(child_octree.get());
+        }
+      }
+    };
+
+    while (!octrees_to_explore.empty())
+    {
+      const auto octree = octrees_to_explore.back();
+      octrees_to_explore.pop_back();
+
+      if (!IntersectCheck(inQueryPrimitive, octree->GetAABox()))
+        continue;
+
+      if constexpr (CanCheckContainedAABox)
+      {
+        // Every primitive in the subtree intersects a box inside the query
+        if (Contains(inQueryPrimitive, octree->GetAABox()))
+        {
+          ReportAllSubtreePrimitives(*octree);
+          continue;
+        }
+      }
+
+      for (const auto& primitive_index : octree->GetPrimitivesIndices())
+      {
+        if (is_primitive_reported[primitive_index])
+          continue;
+
+        if (IntersectCheck(inQueryPrimitive, primitives_pool[primitive_index]))
+          ReportPrimitive(primitive_index);
+      }
+
+      for (const auto& child_octree : octree->GetChildren())
+      {
+        if (child_octree)
+          octrees_to_explore.push_back(child_octree.get());
+      }
+    }
+  }
+}
+
+template <typename TPrimitive, typename TQueryPrimitive, typename TCallback>
+void QueryOverlap(const Octree<TPrimitive>& inTopOctree,
+    const TQueryPrimitive& inQueryPrimitive,
+    const TCallback& inCallback)
+{
+  octree_detail::ForEachOverlappingPrimitive(inTopOctree, inQueryPrimitive, inCallback);
+}
+
+template <typename TPrimitive, typename TQueryPrimitive>
+std::size_t QueryOverlap(const Octree<TPrimitive>& inTopOctree,
+    const TQueryPrimitive& inQueryPrimitive,
+    std::vector<typename Octree<TPrimitive>::PrimitiveIndex>& outPrimitivesIndices)
+{
+  outPrimitivesIndices.clear();
+  octree_detail::ForEachOverlappingPrimitive(inTopOctree,
+      inQueryPrimitive,
+      [&](const typename Octree<TPrimitive>::PrimitiveIndex inPrimitiveIndex) {
+        outPrimitivesIndices.push_back(inPrimitiveIndex);
+      });
+  std::sort(outPrimitivesIndices.begin(), outPrimitivesIndices.end());
+  return outPrimitivesIndices.size();
+}
+
+template <typename TPrimitive>
+OctreeStats ComputeStats(const Octree<TPrimitive>& inTopOctree)
+{
+  using OctreeType = Octree<TPrimitive>;
+
+  OctreeStats stats;
+  if (inTopOctree.IsEmpty())
+    return stats;
+
+  const auto primitives = inTopOctree.GetPrimitives();
+  std::vector<bool> is_primitive_in_leaves(primitives.GetNumberOfElements(), false);
+  std::size_t num_leaves_primitives_indices = 0;
+
+  std::vector<std::pair<const OctreeType*, std::size_t>> octrees_to_explore;
+  octrees_to_explore.emplace_back(&inTopOctree, 0);
+  while (!octrees_to_explore.empty())
+  {
+    const auto [octree, depth] = octrees_to_explore.back();
+    octrees_to_explore.pop_back();
+
+    ++stats.mNumNodes;
+    if (stats.mNumNodesPerDepth.size() <= depth)
+      stats.mNumNodesPerDepth.resize(depth + 1, 0);
+    ++stats.mNumNodesPerDepth[depth];
+
+    const auto& primitives_indices = octree->GetPrimitivesIndices();
+    stats.mMemoryBytes
+        += sizeof(OctreeType) + primitives_indices.capacity() * sizeof(typename OctreeType::PrimitiveIndex);
+
+    if (octree->IsLeaf())
+    {
+      ++stats.mNumLeaves;
+      stats.mMaxLeafNumPrimitives = std::max(stats.mMaxLeafNumPrimitives, primitives_indices.size());
+      num_leaves_primitives_indices += primitives_indices.size();
+      for (const auto& primitive_index : primitives_indices) is_primitive_in_leaves[primitive_index] = true;
+      continue;
+    }
+
+    for (const auto& child_octree : *octree) octrees_to_explore.emplace_back(&child_octree, depth + 1);
+  }
+
+  if (!inTopOctree.IsView())
+    stats.mMemoryBytes += inTopOctree.GetPrimitivesPool().capacity() * sizeof(TPrimitive);
+
+  // Removed primitives are still in the pool, so only count the ones the leaves refer to
+  const auto num_primitives = static_cast<std::size_t>(
+      std::count(is_primitive_in_leaves.cbegin(), is_primitive_in_leaves.cend(), true));
+  stats.mAverageLeafNumPrimitives
+      = static_cast<double>(num_leaves_primitives_indices) / static_cast<double>(stats.mNumLeaves);
+  if (num_primitives > 0)
+  {
+    stats.mPrimitivesDuplicationFactor
+        = static_cast<double>(num_leaves_primitives_indices) / static_cast<double>(num_primitives);
+  }
+  return stats;
 }
 
 }
\ No newline at end of file
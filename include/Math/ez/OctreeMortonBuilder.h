@@ -0,0 +1,83 @@
+#pragma once
+
+#include <ez/Octree.h>
+#include <ez/Span.h>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ez
+{
+
+// Bottom-up alternative to OctreeBuilder. Instead of testing every primitive of a node against each one of its
+// children boxes, primitives are sorted by the Morton code of their bounding box center, so that every node is a
+// contiguous range of the sorted primitives sharing the same code prefix.
+// The 3 bits of each code level match the BinaryIndex<3>/MakeSequentialIndex child numbering used by Octree.
+// Codes are 30-bit (10 levels) when inMaxDepth <= 10, and 63-bit (21 levels) otherwise.
+// Primitives whose bounding box does not fit in the leaf of their center are then added top-down to every other
+// node they intersect, so queries give the same results as with OctreeBuilder. The leaves this takes over
+// inLeafNodesMaxCapacity are finally split top-down as OctreeBuilder does (until inMaxDepth). For point clouds and
+// small primitives there are few of those, and the build is dominated by the sort.
+template <typename TPrimitive>
+class OctreeMortonBuilder final
+{
+public:
+  using OctreeType = Octree<TPrimitive>;
+  using AABoxType = typename OctreeType::AABoxType;
+  using PrimitiveIndex = typename OctreeType::PrimitiveIndex;
+
+  OctreeMortonBuilder() = delete;
+
+  static OctreeType Build(const Span<TPrimitive>& inPrimitives,
+      const std::size_t inLeafNodesMaxCapacity = 8,
+      const std::size_t inMaxDepth = 8);
+
+private:
+  template <typename TMortonCode>
+  struct MortonCodeTraits final
+  {
+    static constexpr std::size_t NumBitsPerAxis = (std::is_same_v<TMortonCode, uint32_t> ? 10 : 21);
+  };
+
+  template <typename TMortonCode>
+  using MortonCodeAndIndex = std::pair<TMortonCode, PrimitiveIndex>;
+
+  template <typename TMortonCode>
+  static OctreeType BuildWithMortonCodes(const Span<TPrimitive>& inPrimitives,
+      const std::size_t inLeafNodesMaxCapacity,
+      const std::size_t inMaxDepth);
+
+  template <typename TMortonCode>
+  static TMortonCode ComputeMortonCode(const AABoxType& inAABox, const TPrimitive& inPrimitive);
+
+  template <typename TMortonCode>
+  static void RadixSort(std::vector<MortonCodeAndIndex<TMortonCode>>& ioMortonCodesAndIndices);
+
+  template <typename TMortonCode>
+  static void BuildChildrenRecursive(OctreeType& ioOctree,
+      const std::vector<MortonCodeAndIndex<TMortonCode>>& inSortedMortonCodesAndIndices,
+      const std::size_t inBegin,
+      const std::size_t inEnd,
+      const std::size_t inLeafNodesMaxCapacity,
+      const std::size_t inMaxDepth,
+      const std::size_t inCurrentDepth,
+      std::vector<OctreeType*>& ioLeafOfPrimitive);
+
+  template <typename TMortonCode>
+  static void AddStraddlingPrimitiveRecursive(OctreeType& ioOctree,
+      const TPrimitive& inPrimitive,
+      const PrimitiveIndex inPrimitiveIndex,
+      const TMortonCode inMortonCode,
+      const bool inIsInMortonCodePath,
+      const std::size_t inCurrentDepth);
+
+  static void SplitOverCapacityLeavesRecursive(OctreeType& ioOctree,
+      const Span<TPrimitive>& inPrimitivesPool,
+      const std::size_t inLeafNodesMaxCapacity,
+      const std::size_t inMaxDepth,
+      const std::size_t inCurrentDepth);
+};
+}
+
+#include "ez/OctreeMortonBuilder.tcc"
\ No newline at end of file
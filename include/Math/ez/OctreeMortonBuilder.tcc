@@ -0,0 +1,291 @@
+#include <ez/AAHyperBox.h>
+#include <ez/Macros.h>
+#include <ez/OctreeMortonBuilder.h>
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <numeric>
+
+namespace ez
+{
+
+namespace octree_morton_detail
+{
+  // Spreads the lower 10 bits of the input so that there are two zero bits between each pair of them
+  inline uint32_t SpreadBits(uint32_t inValue)
+  {
+    inValue &= 0x000003FFu;
+    inValue = (inValue | (inValue << 16)) & 0x030000FFu;
+    inValue = (inValue | (inValue << 8)) & 0x0300F00Fu;
+    inValue = (inValue | (inValue << 4)) & 0x030C30C3u;
+    inValue = (inValue | (inValue << 2)) & 0x09249249u;
+    return inValue;
+  }
+
+  // Spreads the lower 21 bits of the input so that there are two zero bits between each pair of them
+  inline uint64_t SpreadBits(uint64_t inValue)
+  {
+    inValue &= 0x00000000001FFFFFull;
+    inValue = (inValue | (inValue << 32)) & 0x001F00000000FFFFull;
+    inValue = (inValue | (inValue << 16)) & 0x001F0000FF0000FFull;
+    inValue = (inValue | (inValue << 8)) & 0x100F00F00F00F00Full;
+    inValue = (inValue | (inValue << 4)) & 0x10C30C30C30C30C3ull;
+    inValue = (inValue | (inValue << 2)) & 0x1249249249249249ull;
+    return inValue;
+  }
+}
+
+template <typename TPrimitive>
+typename OctreeMortonBuilder<TPrimitive>::OctreeType OctreeMortonBuilder<TPrimitive>::Build(
+    const Span<TPrimitive>& inPrimitives,
+    const std::size_t inLeafNodesMaxCapacity,
+    const std::size_t inMaxDepth)
+{
+  if (inMaxDepth <= MortonCodeTraits<uint32_t>::NumBitsPerAxis)
+    return BuildWithMortonCodes<uint32_t>(inPrimitives, inLeafNodesMaxCapacity, inMaxDepth);
+  return BuildWithMortonCodes<uint64_t>(inPrimitives, inLeafNodesMaxCapacity, inMaxDepth);
+}
+
+template <typename TPrimitive>
+template <typename TMortonCode>
+typename OctreeMortonBuilder<TPrimitive>::OctreeType OctreeMortonBuilder<TPrimitive>::BuildWithMortonCodes(
+    const Span<TPrimitive>& inPrimitives,
+    const std::size_t inLeafNodesMaxCapacity,
+    const std::size_t inMaxDepth)
+{
+  // Top octree, same as the one OctreeBuilder creates
+  OctreeType octree;
+  octree.mAABox = BoundingAAHyperBox(inPrimitives);
+  octree.mPrimitivesPool = std::make_optional<std::vector<TPrimitive>>(inPrimitives.cbegin(), inPrimitives.cend());
+  octree.mPrimitivesIndices.resize(octree.mPrimitivesPool->size());
+  std::iota(octree.mPrimitivesIndices.begin(), octree.mPrimitivesIndices.end(), 0);
+
+  if (octree.mPrimitivesIndices.size() <= inLeafNodesMaxCapacity)
+    return octree;
+
+  // Sort primitives by the Morton code of their center
+  const auto& primitives_pool = *octree.mPrimitivesPool;
+  std::vector<MortonCodeAndIndex<TMortonCode>> sorted_morton_codes_and_indices(primitives_pool.size());
+  for (std::size_t i = 0; i < primitives_pool.size(); ++i)
+    sorted_morton_codes_and_indices[i] = { ComputeMortonCode<TMortonCode>(octree.mAABox, primitives_pool[i]), i };
+  RadixSort(sorted_morton_codes_and_indices);
+
+  // Emit the nodes from the shared code prefixes
+  const auto max_depth = std::min(inMaxDepth, MortonCodeTraits<TMortonCode>::NumBitsPerAxis);
+  std::vector<OctreeType*> leaf_of_primitive(primitives_pool.size(), &octree);
+  BuildChildrenRecursive(octree,
+      sorted_morton_codes_and_indices,
+      0,
+      sorted_morton_codes_and_indices.size(),
+      inLeafNodesMaxCapacity,
+      max_depth,
+      0,
+      leaf_of_primitive);
+
+  // Primitives not fully inside the leaf of their center must also be in the other nodes they intersect
+  for (const auto& [morton_code, primitive_index] : sorted_morton_codes_and_indices)
+  {
+    const auto& primitive = primitives_pool[primitive_index];
+    if (Contains(leaf_of_primitive[primitive_index]->mAABox, primitive))
+      continue;
+
+    AddStraddlingPrimitiveRecursive(octree, primitive, primitive_index, morton_code, true, 0);
+  }
+
+  // Straddling primitives can take leaves over capacity
+  SplitOverCapacityLeavesRecursive(octree, MakeSpan(primitives_pool), inLeafNodesMaxCapacity, inMaxDepth, 0);
+
+  return octree;
+}
+
+template <typename TPrimitive>
+template <typename TMortonCode>
+TMortonCode OctreeMortonBuilder<TPrimitive>::ComputeMortonCode(const AABoxType& inAABox, const TPrimitive& inPrimitive)
+{
+  using ValueType = typename OctreeType::ValueType;
+  constexpr auto NumCellsPerAxis = (static_cast<TMortonCode>(1) << MortonCodeTraits<TMortonCode>::NumBitsPerAxis);
+  constexpr auto MaxCellCoordinate = static_cast<ValueType>(NumCellsPerAxis - 1);
+
+  const auto primitive_center = Center(BoundingAAHyperBox(inPrimitive));
+  const auto aabox_size = inAABox.GetSize();
+
+  // The bit b of the axis i cell coordinate goes to the bit (3 * b + 2 - i) of the code. This way, every 3-bit digit
+  // of the code is the MakeSequentialIndex of the BinaryIndex<3> of the child containing the center at that level.
+  TMortonCode morton_code = 0;
+  for (std::size_t i = 0; i < 3; ++i)
+  {
+    const auto center_coordinate_local = (primitive_center[i] - inAABox.GetMin()[i]);
+    const auto center_coordinate_normalized
+        = (aabox_size[i] > static_cast<ValueType>(0) ? (center_coordinate_local / aabox_size[i]) : ValueType(0));
+    const auto cell_coordinate = static_cast<TMortonCode>(
+        Clamp(center_coordinate_normalized * static_cast<ValueType>(NumCellsPerAxis), ValueType(0), MaxCellCoordinate));
+    morton_code |= (octree_morton_detail::SpreadBits(cell_coordinate) << (2 - i));
+  }
+  return morton_code;
+}
+
+template <typename TPrimitive>
+template <typename TMortonCode>
+void OctreeMortonBuilder<TPrimitive>::RadixSort(std::vector<MortonCodeAndIndex<TMortonCode>>& ioMortonCodesAndIndices)
+{
+  // LSD radix sort, one byte per pass
+  constexpr auto NumBits = (MortonCodeTraits<TMortonCode>::NumBitsPerAxis * 3);
+  constexpr auto NumPasses = ((NumBits + 7) / 8);
+
+  std::vector<MortonCodeAndIndex<TMortonCode>> sorted_morton_codes_and_indices(ioMortonCodesAndIndices.size());
+  for (std::size_t pass = 0; pass < NumPasses; ++pass)
+  {
+    const auto shift = (pass * 8);
+    std::array<std::size_t, 256> digit_offsets {};
+    for (const auto& morton_code_and_index : ioMortonCodesAndIndices)
+      ++digit_offsets[(morton_code_and_index.first >> shift) & 0xFF];
+
+    // All codes share this digit, nothing to sort in this pass
+    if (std::find(digit_offsets.cbegin(), digit_offsets.cend(), ioMortonCodesAndIndices.size())
+        != digit_offsets.cend())
+      continue;
+
+    std::exclusive_scan(digit_offsets.cbegin(), digit_offsets.cend(), digit_offsets.begin(), std::size_t(0));
+    for (const auto& morton_code_and_index : ioMortonCodesAndIndices)
+    {
+      auto& digit_offset = digit_offsets[(morton_code_and_index.first >> shift) & 0xFF];
+      sorted_morton_codes_and_indices[digit_offset++] = morton_code_and_index;
+    }
+    ioMortonCodesAndIndices.swap(sorted_morton_codes_and_indices);
+  }
+}
+
+template <typename TPrimitive>
+template <typename TMortonCode>
+void OctreeMortonBuilder<TPrimitive>::BuildChildrenRecursive(OctreeType& ioOctree,
+    const std::vector<MortonCodeAndIndex<TMortonCode>>& inSortedMortonCodesAndIndices,
+    const std::size_t inBegin,
+    const std::size_t inEnd,
+    const std::size_t inLeafNodesMaxCapacity,
+    const std::size_t inMaxDepth,
+    const std::size_t inCurrentDepth,
+    std::vector<OctreeType*>& ioLeafOfPrimitive)
+{
+  if (inCurrentDepth + 1 > inMaxDepth)
+    return; // Too deep to have children, all its primitives stay here
+
+  const auto shift = 3 * (MortonCodeTraits<TMortonCode>::NumBitsPerAxis - inCurrentDepth - 1);
+  const auto GetChildSequentialIndex = [&](const auto& inMortonCodeAndIndex) {
+    return static_cast<std::size_t>((inMortonCodeAndIndex.first >> shift) & 0b111);
+  };
+
+  // Inside this node range, codes are sorted, and so are the digits of this level
+  const auto range_end = inSortedMortonCodesAndIndices.cbegin() + inEnd;
+  auto child_begin = inSortedMortonCodesAndIndices.cbegin() + inBegin;
+  while (child_begin != range_end)
+  {
+    const auto child_sequential_index = GetChildSequentialIndex(*child_begin);
+    const auto child_end = std::partition_point(child_begin, range_end, [&](const auto& inMortonCodeAndIndex) {
+      return GetChildSequentialIndex(inMortonCodeAndIndex) == child_sequential_index;
+    });
+
+    auto child_octree = std::make_unique<OctreeType>();
+    child_octree->mAABox = ioOctree.GetChildAABox(child_sequential_index);
+    child_octree->mPrimitivesIndices.reserve(std::distance(child_begin, child_end));
+    for (auto it = child_begin; it != child_end; ++it)
+    {
+      child_octree->mPrimitivesIndices.push_back(it->second);
+      ioLeafOfPrimitive[it->second] = child_octree.get();
+    }
+
+    if (child_octree->mPrimitivesIndices.size() > inLeafNodesMaxCapacity)
+    {
+      BuildChildrenRecursive(*child_octree,
+          inSortedMortonCodesAndIndices,
+          std::distance(inSortedMortonCodesAndIndices.cbegin(), child_begin),
+          std::distance(inSortedMortonCodesAndIndices.cbegin(), child_end),
+          inLeafNodesMaxCapacity,
+          inMaxDepth,
+          inCurrentDepth + 1,
+          ioLeafOfPrimitive);
+    }
+
+    ioOctree.mChildren[child_sequential_index] = std::move(child_octree);
+    child_begin = child_end;
+  }
+
+  // Only leaves keep their primitives indices
+  std::vector<PrimitiveIndex>().swap(ioOctree.mPrimitivesIndices);
+}
+
+template <typename TPrimitive>
+template <typename TMortonCode>
+void OctreeMortonBuilder<TPrimitive>::AddStraddlingPrimitiveRecursive(OctreeType& ioOctree,
+    const TPrimitive& inPrimitive,
+    const PrimitiveIndex inPrimitiveIndex,
+    const TMortonCode inMortonCode,
+    const bool inIsInMortonCodePath,
+    const std::size_t inCurrentDepth)
+{
+  // The leaf in the Morton code path already has this primitive, the rest are known to intersect it
+  if (ioOctree.IsLeaf())
+  {
+    if (!inIsInMortonCodePath)
+      ioOctree.mPrimitivesIndices.push_back(inPrimitiveIndex);
+    return;
+  }
+
+  const auto shift = 3 * (MortonCodeTraits<TMortonCode>::NumBitsPerAxis - inCurrentDepth - 1);
+  const auto morton_code_child_sequential_index = static_cast<std::size_t>((inMortonCode >> shift) & 0b111);
+  for (std::size_t i = 0; i < 8; ++i)
+  {
+    const auto child_is_in_morton_code_path = (inIsInMortonCodePath && i == morton_code_child_sequential_index);
+    const auto child_aabox = ioOctree.GetChildAABox(i);
+    if (!child_is_in_morton_code_path && !IntersectCheck(child_aabox, inPrimitive))
+      continue;
+
+    auto& child_octree = ioOctree.mChildren[i];
+    if (!child_octree) // No center fell here, but the primitive crosses it (OctreeBuilder would have created it)
+    {
+      child_octree = std::make_unique<OctreeType>();
+      child_octree->mAABox = child_aabox;
+    }
+
+    AddStraddlingPrimitiveRecursive(*child_octree,
+        inPrimitive,
+        inPrimitiveIndex,
+        inMortonCode,
+        child_is_in_morton_code_path,
+        inCurrentDepth + 1);
+  }
+}
+
+template <typename TPrimitive>
+void OctreeMortonBuilder<TPrimitive>::SplitOverCapacityLeavesRecursive(OctreeType& ioOctree,
+    const Span<TPrimitive>& inPrimitivesPool,
+    const std::size_t inLeafNodesMaxCapacity,
+    const std::size_t inMaxDepth,
+    const std::size_t inCurrentDepth)
+{
+  if (ioOctree.IsLeaf())
+  {
+    // Same split as OctreeBuilder, it does nothing past inMaxDepth
+    if (ioOctree.mPrimitivesIndices.size() > inLeafNodesMaxCapacity)
+    {
+      OctreeBuilder<TPrimitive>::BuildChildrenRecursive(ioOctree,
+          inPrimitivesPool,
+          inLeafNodesMaxCapacity,
+          inMaxDepth,
+          inCurrentDepth);
+    }
+    return;
+  }
+
+  for (auto& child_octree : ioOctree.mChildren)
+  {
+    if (child_octree)
+    {
+      SplitOverCapacityLeavesRecursive(*child_octree,
+          inPrimitivesPool,
+          inLeafNodesMaxCapacity,
+          inMaxDepth,
+          inCurrentDepth + 1);
+    }
+  }
+}
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace ez
+{
+// Tells parallel algorithms how many threads they can use (the calling thread included).
+struct ParallelPolicy final
+{
+  std::size_t mNumThreads = std::max(std::thread::hardware_concurrency(), 1u);
+};
+
+// Calls inFunction(inItemIndex, inThreadIndex) for every item in [0, inNumItems), spread across the policy threads.
+// Items are handed out dynamically in chunks of inGrainSize, so threads that finish early keep taking pending work.
+// inThreadIndex is in [0, inParallelPolicy.mNumThreads), and can be used to index per-thread scratch memory.
+template <typename TFunction>
+void ParallelFor(const ParallelPolicy& inParallelPolicy,
+    const std::size_t inNumItems,
+    const TFunction& inFunction,
+    const std::size_t inGrainSize = 1)
+{
+  const auto grain_size = std::max(inGrainSize, static_cast<std::size_t>(1));
+  const auto num_chunks = (inNumItems + grain_size - 1) / grain_size;
+  const auto num_threads = std::min(std::max(inParallelPolicy.mNumThreads, static_cast<std::size_t>(1)), num_chunks);
+  if (num_threads <= 1)
+  {
+    for (std::size_t i = 0; i < inNumItems; ++i) { inFunction(i, static_cast<std::size_t>(0)); }
+    return;
+  }
+
+  std::atomic<std::size_t> next_item_index { 0 };
+  const auto ProcessChunks = [&](const std::size_t inThreadIndex) {
+    while (true)
+    {
+      const auto chunk_begin = next_item_index.fetch_add(grain_size, std::memory_order_relaxed);
+      if (chunk_begin >= inNumItems)
+        break;
+
+      const auto chunk_end = std::min(chunk_begin + grain_size, inNumItems);
+      for (auto i = chunk_begin; i < chunk_end; ++i) { inFunction(i, inThreadIndex); }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads - 1);
+  for (std::size_t thread_index = 1; thread_index < num_threads; ++thread_index)
+    threads.emplace_back(ProcessChunks, thread_index);
+
+  ProcessChunks(0);
+  for (auto& thread : threads) thread.join();
+}
+}
\ No newline at end of file
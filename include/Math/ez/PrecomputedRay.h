@@ -0,0 +1,54 @@
+#pragma once
+
+#include <ez/AAHyperBox.h>
+#include <ez/IntersectMode.h>
+#include <ez/MathForward.h>
+#include <ez/Ray.h>
+#include <array>
+#include <cstdint>
+#include <optional>
+
+namespace ez
+{
+
+// Ray with what the slab tests against axis-aligned boxes need precomputed (inverse direction and direction signs),
+// for queries that test the same ray against many boxes (e.g. hierarchies traversals).
+template <typename T, std::size_t N>
+class PrecomputedRay final
+{
+public:
+  using ValueType = T;
+  static constexpr auto NumComponents = N;
+  static constexpr auto NumDimensions = N;
+
+  PrecomputedRay() = default;
+  explicit PrecomputedRay(const Ray<T, N>& inRay);
+
+  const Ray<T, N>& GetRay() const { return mRay; }
+  const Vec<T, N>& GetOrigin() const { return mRay.GetOrigin(); }
+  const Vec<T, N>& GetDirection() const { return mRay.GetDirection(); }
+  const Vec<T, N>& GetDirectionInverse() const { return mDirectionInverse; }
+  bool IsDirectionNegative(const std::size_t inAxis) const { return mDirectionIsNegative[inAxis] != 0; }
+  Vec<T, N> GetPoint(const T& inDistance) const { return mRay.GetPoint(inDistance); }
+
+private:
+  Ray<T, N> mRay;
+  Vec<T, N> mDirectionInverse = One<Vec<T, N>>();
+  std::array<uint8_t, N> mDirectionIsNegative {}; // 1 in the axes where the direction goes backwards
+};
+
+template <typename T, std::size_t N>
+constexpr Vec<T, N> Direction(const PrecomputedRay<T, N>& inPrecomputedRay);
+
+// Same results as Intersect(Ray, AAHyperBox)
+template <EIntersectMode TIntersectMode, typename T, std::size_t N>
+auto Intersect(const PrecomputedRay<T, N>& inPrecomputedRay, const AAHyperBox<T, N>& inAAHyperBox);
+
+// Returns the distance at which the ray enters the box (0 if it starts inside), if it does so within [0, inMaxDistance]
+template <typename T, std::size_t N>
+std::optional<T> GetEnterDistance(const PrecomputedRay<T, N>& inPrecomputedRay,
+    const AAHyperBox<T, N>& inAAHyperBox,
+    const T& inMaxDistance = Infinity<T>());
+}
+
+#include "ez/PrecomputedRay.tcc"
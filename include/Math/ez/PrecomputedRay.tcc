@@ -0,0 +1,91 @@
+#include <ez/PrecomputedRay.h>
+#include <utility>
+
+namespace ez
+{
+
+template <typename T, std::size_t N>
+PrecomputedRay<T, N>::PrecomputedRay(const Ray<T, N>& inRay)
+    : mRay { inRay }, mDirectionInverse { static_cast<T>(1) / inRay.GetDirection() }
+{
+  for (std::size_t i = 0; i < N; ++i) mDirectionIsNegative[i] = (inRay.GetDirection()[i] < static_cast<T>(0));
+}
+
+template <typename T, std::size_t N>
+constexpr Vec<T, N> Direction(const PrecomputedRay<T, N>& inPrecomputedRay)
+{
+  return inPrecomputedRay.GetDirection();
+}
+
+namespace precomputed_ray_detail
+{
+  // Line distances at which the ray enters and exits the slabs of the box. The direction signs tell which of the two
+  // planes of each axis is the near one, so there is no min/max per axis.
+  template <typename T, std::size_t N>
+  std::pair<T, T> GetSlabsEnterExitDistances(const PrecomputedRay<T, N>& inPrecomputedRay,
+      const AAHyperBox<T, N>& inAAHyperBox)
+  {
+    const auto& origin = inPrecomputedRay.GetOrigin();
+    const auto& direction_inverse = inPrecomputedRay.GetDirectionInverse();
+    const auto& aabox_min = inAAHyperBox.GetMin();
+    const auto& aabox_max = inAAHyperBox.GetMax();
+
+    auto enter = -Infinity<T>();
+    auto exit = Infinity<T>();
+    for (std::size_t i = 0; i < N; ++i)
+    {
+      const auto is_negative = inPrecomputedRay.IsDirectionNegative(i);
+      const auto near_plane = (is_negative ? aabox_max[i] : aabox_min[i]);
+      const auto far_plane = (is_negative ? aabox_min[i] : aabox_max[i]);
+      enter = Max(enter, (near_plane - origin[i]) * direction_inverse[i]);
+      exit = Min(exit, (far_plane - origin[i]) * direction_inverse[i]);
+    }
+    return { enter, exit };
+  }
+}
+
+template <EIntersectMode TIntersectMode, typename T, std::size_t N>
+auto Intersect(const PrecomputedRay<T, N>& inPrecomputedRay, const AAHyperBox<T, N>& inAAHyperBox)
+{
+  static_assert(TIntersectMode == EIntersectMode::ALL_INTERSECTIONS || TIntersectMode == EIntersectMode::ONLY_CLOSEST
+          || TIntersectMode == EIntersectMode::ONLY_CHECK,
+      "Unsupported EIntersectMode.");
+
+  constexpr auto Epsilon = static_cast<T>(1e-7);
+  const auto [enter, exit] = precomputed_ray_detail::GetSlabsEnterExitDistances(inPrecomputedRay, inAAHyperBox);
+  const auto intersects = (enter < exit);
+
+  if constexpr (TIntersectMode == EIntersectMode::ALL_INTERSECTIONS)
+  {
+    std::array<std::optional<T>, 2> intersections;
+    if (intersects)
+    {
+      if (enter >= Epsilon)
+        intersections[0] = enter;
+      if (exit >= Epsilon)
+        intersections[1] = exit;
+    }
+    return intersections;
+  }
+  else if constexpr (TIntersectMode == EIntersectMode::ONLY_CLOSEST)
+  {
+    if (!intersects || exit < Epsilon)
+      return std::optional<T> {};
+    return std::make_optional(enter >= Epsilon ? enter : exit);
+  }
+  else if constexpr (TIntersectMode == EIntersectMode::ONLY_CHECK)
+  {
+    return (intersects && exit >= Epsilon) || Contains(inAAHyperBox, inPrecomputedRay.GetOrigin());
+  }
+}
+
+template <typename T, std::size_t N>
+std::optional<T> GetEnterDistance(const PrecomputedRay<T, N>& inPrecomputedRay,
+    const AAHyperBox<T, N>& inAAHyperBox,
+    const T& inMaxDistance)
+{
+  const auto [enter, exit] = precomputed_ray_detail::GetSlabsEnterExitDistances(inPrecomputedRay, inAAHyperBox);
+  const auto clamped_enter = Max(enter, static_cast<T>(0));
+  return (clamped_enter <= Min(exit, inMaxDistance)) ? std::make_optional(clamped_enter) : std::nullopt;
+}
+}
@@ -0,0 +1,286 @@
+#include <ez/Macros.h>
+#include <ez/PrimitivesSoA.h>
+#include <bit>
+
+namespace ez
+{
+
+template <typename T, std::size_t TWidth>
+void AABoxSoA<T, TWidth>::SetPrimitive(const std::size_t inLane, const AABox<T>& inAABox)
+{
+  EXPECTS(inLane < TWidth);
+  for (std::size_t i = 0; i < 3; ++i)
+  {
+    mMins[i][inLane] = inAABox.GetMin()[i];
+    mMaxs[i][inLane] = inAABox.GetMax()[i];
+  }
+  mActiveMask |= (static_cast<SoALaneMask>(1) << inLane);
+}
+
+template <typename T, std::size_t TWidth>
+AABox<T> AABoxSoA<T, TWidth>::GetPrimitive(const std::size_t inLane) const
+{
+  EXPECTS(inLane < TWidth);
+  return AABox<T> { Vec3<T> { mMins[0][inLane], mMins[1][inLane], mMins[2][inLane] },
+    Vec3<T> { mMaxs[0][inLane], mMaxs[1][inLane], mMaxs[2][inLane] } };
+}
+
+template <typename T, std::size_t TWidth>
+void SphereSoA<T, TWidth>::SetPrimitive(const std::size_t inLane, const Sphere<T>& inSphere)
+{
+  EXPECTS(inLane < TWidth);
+  for (std::size_t i = 0; i < 3; ++i) mCenters[i][inLane] = Center(inSphere)[i];
+  mRadii[inLane] = inSphere.GetRadius();
+  mSqRadii[inLane] = Sq(inSphere.GetRadius());
+  mActiveMask |= (static_cast<SoALaneMask>(1) << inLane);
+}
+
+template <typename T, std::size_t TWidth>
+Sphere<T> SphereSoA<T, TWidth>::GetPrimitive(const std::size_t inLane) const
+{
+  EXPECTS(inLane < TWidth);
+  return Sphere<T> { Vec3<T> { mCenters[0][inLane], mCenters[1][inLane], mCenters[2][inLane] }, mRadii[inLane] };
+}
+
+template <typename T, std::size_t TWidth>
+void TriangleSoA<T, TWidth>::SetPrimitive(const std::size_t inLane, const Triangle3<T>& inTriangle)
+{
+  EXPECTS(inLane < TWidth);
+  const auto edge01 = inTriangle[1] - inTriangle[0];
+  const auto edge02 = inTriangle[2] - inTriangle[0];
+  for (std::size_t i = 0; i < 3; ++i)
+  {
+    mPoints0[i][inLane] = inTriangle[0][i];
+    mEdges01[i][inLane] = edge01[i];
+    mEdges02[i][inLane] = edge02[i];
+  }
+  mActiveMask |= (static_cast<SoALaneMask>(1) << inLane);
+}
+
+template <typename T, std::size_t TWidth>
+Triangle3<T> TriangleSoA<T, TWidth>::GetPrimitive(const std::size_t inLane) const
+{
+  EXPECTS(inLane < TWidth);
+  const auto point0 = Vec3<T> { mPoints0[0][inLane], mPoints0[1][inLane], mPoints0[2][inLane] };
+  const auto edge01 = Vec3<T> { mEdges01[0][inLane], mEdges01[1][inLane], mEdges01[2][inLane] };
+  const auto edge02 = Vec3<T> { mEdges02[0][inLane], mEdges02[1][inLane], mEdges02[2][inLane] };
+  return Triangle3<T> { point0, point0 + edge01, point0 + edge02 };
+}
+
+namespace primitives_soa_detail
+{
+  // Bit mask of the lanes whose flag is 1. Integer ops only, so that it vectorizes with the loops computing the flags.
+  template <std::size_t TWidth>
+  SoALaneMask GetLanesMask(const std::array<SoALaneMask, TWidth>& inLanesFlags)
+  {
+    SoALaneMask lanes_mask = 0;
+    for (std::size_t lane = 0; lane < TWidth; ++lane) lanes_mask |= (inLanesFlags[lane] << lane);
+    return lanes_mask;
+  }
+
+  // Minimum distance among the hit lanes. Only this reduction is scalar, and it is skipped when no lane is hit.
+  template <typename T, std::size_t TWidth>
+  SoAIntersection<T> GetClosestIntersection(const SoALaneMask inHitLanesMask,
+      const std::array<T, TWidth>& inLanesDistances)
+  {
+    SoAIntersection<T> closest_intersection;
+    closest_intersection.mHitLanesMask = inHitLanesMask;
+    for (auto lanes_mask = inHitLanesMask; lanes_mask != 0; lanes_mask &= (lanes_mask - 1))
+    {
+      const auto lane = static_cast<std::size_t>(std::countr_zero(lanes_mask));
+      if (inLanesDistances[lane] < closest_intersection.mDistance)
+      {
+        closest_intersection.mDistance = inLanesDistances[lane];
+        closest_intersection.mLane = lane;
+      }
+    }
+    return closest_intersection;
+  }
+}
+
+template <typename T, std::size_t TWidth>
+SoAIntersection<T> IntersectClosest(const PrecomputedRay3<T>& inPrecomputedRay,
+    const AABoxSoA<T, TWidth>& inAABoxSoA,
+    const T& inMaxDistance,
+    const SoALaneMask inLanesMask)
+{
+  constexpr auto Epsilon = static_cast<T>(1e-7);
+
+  // Slab test, with the near and far planes picked from the ray direction signs (same as Intersect(PrecomputedRay,
+  // AAHyperBox)). Then the closest distance is the enter one, or the exit one if the ray starts inside.
+  std::array<T, TWidth> enters;
+  std::array<T, TWidth> exits;
+  enters.fill(-Infinity<T>());
+  exits.fill(Infinity<T>());
+  for (std::size_t i = 0; i < 3; ++i)
+  {
+    const auto is_negative = inPrecomputedRay.IsDirectionNegative(i);
+    const auto& near_planes = (is_negative ? inAABoxSoA.GetMaxs()[i] : inAABoxSoA.GetMins()[i]);
+    const auto& far_planes = (is_negative ? inAABoxSoA.GetMins()[i] : inAABoxSoA.GetMaxs()[i]);
+    const auto origin = inPrecomputedRay.GetOrigin()[i];
+    const auto direction_inverse = inPrecomputedRay.GetDirectionInverse()[i];
+    for (std::size_t lane = 0; lane < TWidth; ++lane)
+    {
+      // Same operands order as Max/Min (std::max/std::min)
+      const auto near_distance = (near_planes[lane] - origin) * direction_inverse;
+      const auto far_distance = (far_planes[lane] - origin) * direction_inverse;
+      enters[lane] = (enters[lane] < near_distance ? near_distance : enters[lane]);
+      exits[lane] = (far_distance < exits[lane] ? far_distance : exits[lane]);
+    }
+  }
+
+  std::array<SoALaneMask, TWidth> lanes_hit;
+  std::array<T, TWidth> lanes_distances;
+  for (std::size_t lane = 0; lane < TWidth; ++lane)
+  {
+    lanes_distances[lane] = (enters[lane] >= Epsilon ? enters[lane] : exits[lane]);
+    lanes_hit[lane] = static_cast<SoALaneMask>((enters[lane] < exits[lane]) & (exits[lane] >= Epsilon)
+        & (lanes_distances[lane] <= inMaxDistance));
+  }
+  const auto hit_lanes_mask
+      = primitives_soa_detail::GetLanesMask(lanes_hit) & inLanesMask & inAABoxSoA.GetActiveMask();
+  return primitives_soa_detail::GetClosestIntersection(hit_lanes_mask, lanes_distances);
+}
+
+template <typename T, std::size_t TWidth>
+SoAIntersection<T> IntersectClosest(const Ray3<T>& inRay,
+    const AABoxSoA<T, TWidth>& inAABoxSoA,
+    const T& inMaxDistance,
+    const SoALaneMask inLanesMask)
+{
+  return IntersectClosest(PrecomputedRay3<T> { inRay }, inAABoxSoA, inMaxDistance, inLanesMask);
+}
+
+template <typename T, std::size_t TWidth>
+SoAIntersection<T> IntersectClosest(const Ray3<T>& inRay,
+    const SphereSoA<T, TWidth>& inSphereSoA,
+    const T& inMaxDistance,
+    const SoALaneMask inLanesMask)
+{
+  constexpr auto Epsilon = static_cast<T>(1e-7);
+  const auto origin_x = inRay.GetOrigin()[0];
+  const auto origin_y = inRay.GetOrigin()[1];
+  const auto origin_z = inRay.GetOrigin()[2];
+  const auto direction_x = inRay.GetDirection()[0];
+  const auto direction_y = inRay.GetDirection()[1];
+  const auto direction_z = inRay.GetDirection()[2];
+  const auto& centers = inSphereSoA.GetCenters();
+  const auto& sq_radii = inSphereSoA.GetSqRadii();
+
+  // Same quadratic as Intersect(Line, HyperSphere), with the ray origin relative to every center. The square roots get
+  // their own scalar loop: with math errno on, std::sqrt has a branch that would keep the other loops from vectorizing.
+  const auto a = direction_x * direction_x + direction_y * direction_y + direction_z * direction_z;
+  const auto a2 = a + a;
+  std::array<T, TWidth> bs;
+  std::array<T, TWidth> sqrt_numbers;
+  for (std::size_t lane = 0; lane < TWidth; ++lane)
+  {
+    const auto origin_local_x = origin_x - centers[0][lane];
+    const auto origin_local_y = origin_y - centers[1][lane];
+    const auto origin_local_z = origin_z - centers[2][lane];
+    const auto b = static_cast<T>(2)
+        * (origin_local_x * direction_x + origin_local_y * direction_y + origin_local_z * direction_z);
+    const auto c = (origin_local_x * origin_local_x + origin_local_y * origin_local_y + origin_local_z * origin_local_z)
+        - sq_radii[lane];
+    bs[lane] = b;
+    sqrt_numbers[lane] = (b * b - static_cast<T>(4) * a * c);
+  }
+
+  std::array<T, TWidth> sqrt_results;
+  for (std::size_t lane = 0; lane < TWidth; ++lane)
+    sqrt_results[lane] = Sqrt(sqrt_numbers[lane] < static_cast<T>(0) ? static_cast<T>(0) : sqrt_numbers[lane]);
+
+  std::array<SoALaneMask, TWidth> lanes_hit;
+  std::array<T, TWidth> lanes_distances;
+  for (std::size_t lane = 0; lane < TWidth; ++lane)
+  {
+    const auto near_distance = (-bs[lane] - sqrt_results[lane]) / a2;
+    const auto far_distance = (-bs[lane] + sqrt_results[lane]) / a2;
+    lanes_distances[lane] = (near_distance >= Epsilon ? near_distance : far_distance);
+
+    // far_distance >= near_distance, so this is lanes_distances[lane] >= Epsilon. Testing far_distance keeps its
+    // division unconditional (a division only computed in one branch is not if-converted, nor vectorized).
+    lanes_hit[lane] = static_cast<SoALaneMask>((sqrt_numbers[lane] >= static_cast<T>(0)) & (far_distance >= Epsilon)
+        & (lanes_distances[lane] <= inMaxDistance));
+  }
+  const auto hit_lanes_mask
+      = primitives_soa_detail::GetLanesMask(lanes_hit) & inLanesMask & inSphereSoA.GetActiveMask();
+  return primitives_soa_detail::GetClosestIntersection(hit_lanes_mask, lanes_distances);
+}
+
+template <typename T, std::size_t TWidth>
+SoAIntersection<T> IntersectClosest(const Ray3<T>& inRay,
+    const TriangleSoA<T, TWidth>& inTriangleSoA,
+    const T& inMaxDistance,
+    const SoALaneMask inLanesMask)
+{
+  constexpr auto Epsilon = static_cast<T>(1e-7);
+  const auto origin_x = inRay.GetOrigin()[0];
+  const auto origin_y = inRay.GetOrigin()[1];
+  const auto origin_z = inRay.GetOrigin()[2];
+  const auto direction_x = inRay.GetDirection()[0];
+  const auto direction_y = inRay.GetDirection()[1];
+  const auto direction_z = inRay.GetDirection()[2];
+  const auto& points0 = inTriangleSoA.GetPoints0();
+  const auto& edges01 = inTriangleSoA.GetEdges01();
+  const auto& edges02 = inTriangleSoA.GetEdges02();
+
+  // Moller-Trumbore, same as Intersect(Ray3, Triangle3) with ETriangleIntersectAlgorithm::MOLLER_TRUMBORE, written
+  // component by component so that every lane operation is a plain arithmetic op on the lane arrays
+  std::array<SoALaneMask, TWidth> lanes_hit;
+  std::array<T, TWidth> lanes_distances;
+  for (std::size_t lane = 0; lane < TWidth; ++lane)
+  {
+    const auto edge01_x = edges01[0][lane];
+    const auto edge01_y = edges01[1][lane];
+    const auto edge01_z = edges01[2][lane];
+    const auto edge02_x = edges02[0][lane];
+    const auto edge02_y = edges02[1][lane];
+    const auto edge02_z = edges02[2][lane];
+
+    // p = Cross(direction, edge02)
+    const auto p_x = direction_y * edge02_z - direction_z * edge02_y;
+    const auto p_y = direction_z * edge02_x - direction_x * edge02_z;
+    const auto p_z = direction_x * edge02_y - direction_y * edge02_x;
+    const auto determinant = edge01_x * p_x + edge01_y * p_y + edge01_z * p_z;
+    const auto determinant_inverse = static_cast<T>(1) / determinant;
+
+    const auto origin_from_point0_x = origin_x - points0[0][lane];
+    const auto origin_from_point0_y = origin_y - points0[1][lane];
+    const auto origin_from_point0_z = origin_z - points0[2][lane];
+    const auto u = (origin_from_point0_x * p_x + origin_from_point0_y * p_y + origin_from_point0_z * p_z)
+        * determinant_inverse;
+
+    // q = Cross(origin_from_point0, edge01)
+    const auto q_x = origin_from_point0_y * edge01_z - origin_from_point0_z * edge01_y;
+    const auto q_y = origin_from_point0_z * edge01_x - origin_from_point0_x * edge01_z;
+    const auto q_z = origin_from_point0_x * edge01_y - origin_from_point0_y * edge01_x;
+    const auto v = (direction_x * q_x + direction_y * q_y + direction_z * q_z) * determinant_inverse;
+    lanes_distances[lane] = (edge02_x * q_x + edge02_y * q_y + edge02_z * q_z) * determinant_inverse;
+    lanes_hit[lane] = static_cast<SoALaneMask>((determinant != static_cast<T>(0)) & (u >= static_cast<T>(0))
+        & (u <= static_cast<T>(1)) & (v >= static_cast<T>(0)) & (u + v <= static_cast<T>(1))
+        & (lanes_distances[lane] >= Epsilon) & (lanes_distances[lane] <= inMaxDistance));
+  }
+  const auto hit_lanes_mask
+      = primitives_soa_detail::GetLanesMask(lanes_hit) & inLanesMask & inTriangleSoA.GetActiveMask();
+  return primitives_soa_detail::GetClosestIntersection(hit_lanes_mask, lanes_distances);
+}
+
+template <typename T, std::size_t TWidth>
+SoAIntersection<T> IntersectClosest(const PrecomputedRay3<T>& inPrecomputedRay,
+    const SphereSoA<T, TWidth>& inSphereSoA,
+    const T& inMaxDistance,
+    const SoALaneMask inLanesMask)
+{
+  return IntersectClosest(inPrecomputedRay.GetRay(), inSphereSoA, inMaxDistance, inLanesMask);
+}
+
+template <typename T, std::size_t TWidth>
+SoAIntersection<T> IntersectClosest(const PrecomputedRay3<T>& inPrecomputedRay,
+    const TriangleSoA<T, TWidth>& inTriangleSoA,
+    const T& inMaxDistance,
+    const SoALaneMask inLanesMask)
+{
+  return IntersectClosest(inPrecomputedRay.GetRay(), inTriangleSoA, inMaxDistance, inLanesMask);
+}
+}
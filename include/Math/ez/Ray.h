@@ -63,6 +63,12 @@ auto Intersect(const Ray<T, N>& inRay, const Vec<T, N>& inPoint);
 template <EIntersectMode TIntersectMode, typename T, typename TPrimitive, std::size_t N>
 auto Intersect(const Ray<T, N>& inRay, const TPrimitive& inPrimitive);
 
+// Only the intersections at distance <= inMaxDistance are reported, so it can give up as soon as the hit is further
+template <EIntersectMode TIntersectMode,
+    ETriangleIntersectAlgorithm TAlgorithm = ETriangleIntersectAlgorithm::MOLLER_TRUMBORE,
+    typename T>
+auto Intersect(const Ray3<T>& inRay, const Triangle3<T>& inTriangle, const T& inMaxDistance = Infinity<T>());
+
 // Contains
 template <typename T, std::size_t N>
 bool Contains(const Ray<T, N>& inRay, const Vec<T, N>& inPoint);
@@ -77,6 +77,27 @@ auto Intersect(const Ray<T, N>& inRay, const TPrimitive& inPrimitive)
     return Contains(inPrimitive, inRay.GetOrigin());
 }
 
+template <EIntersectMode TIntersectMode, ETriangleIntersectAlgorithm TAlgorithm, typename T>
+auto Intersect(const Ray3<T>& inRay, const Triangle3<T>& inTriangle, const T& inMaxDistance)
+{
+  static_assert(TIntersectMode == EIntersectMode::ALL_INTERSECTIONS || TIntersectMode == EIntersectMode::ONLY_CLOSEST
+          || TIntersectMode == EIntersectMode::ONLY_CHECK,
+      "Unsupported EIntersectMode.");
+
+  constexpr auto Epsilon = static_cast<T>(1e-7);
+  auto intersection
+      = line_detail::IntersectTriangle3<TAlgorithm>(inRay.GetOrigin(), Direction(inRay), inTriangle);
+  if (intersection && (*intersection < Epsilon || *intersection > inMaxDistance))
+    intersection = std::nullopt;
+
+  if constexpr (TIntersectMode == EIntersectMode::ALL_INTERSECTIONS)
+    return std::array { intersection };
+  else if constexpr (TIntersectMode == EIntersectMode::ONLY_CLOSEST)
+    return intersection;
+  else if constexpr (TIntersectMode == EIntersectMode::ONLY_CHECK)
+    return intersection.has_value();
+}
+
 // Contains
 template <typename T, std::size_t N>
 bool Contains(const Ray<T, N>& inRay, const Vec<T, N>& inPoint)
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <ez/AAHyperBox.h>
+#include <ez/HyperSphere.h>
+#include <ez/MathForward.h>
+#include <ez/PrimitivesSoA.h>
+#include <ez/Ray.h>
+#include <ez/Span.h>
+#include <ez/Triangle.h>
+#include <array>
+#include <cstdint>
+
+namespace ez
+{
+
+// Group of TWidth 3D rays stored as structure of arrays (one array per component), so that the same operation can
+// be done for all of them at once. As in PrimitivesSoA, the per-lane loops have a fixed trip count, plain per-component
+// arithmetic and integer hit flags, so that the compiler vectorizes them.
+// Lanes not set are inactive, and are ignored by the packet queries.
+template <typename T, std::size_t TWidth>
+class RayPacket final
+{
+public:
+  static_assert(TWidth >= 1 && TWidth <= 32, "RayPacket width must be in [1, 32]");
+
+  using ValueType = T;
+  using LaneMask = uint32_t; // Bit i refers to the lane i
+  using LaneValues = std::array<T, TWidth>;
+  static constexpr auto Width = TWidth;
+
+  RayPacket() = default;
+  explicit RayPacket(const Span<Ray3<T>>& inRays);
+
+  void SetRay(const std::size_t inLane, const Ray3<T>& inRay);
+  Ray3<T> GetRay(const std::size_t inLane) const;
+  void Deactivate(const std::size_t inLane) { mActiveMask &= ~(static_cast<LaneMask>(1) << inLane); }
+  bool IsActive(const std::size_t inLane) const { return (mActiveMask & (static_cast<LaneMask>(1) << inLane)) != 0; }
+
+  LaneMask GetActiveMask() const { return mActiveMask; }
+  const std::array<LaneValues, 3>& GetOrigins() const { return mOrigins; }
+  const std::array<LaneValues, 3>& GetDirections() const { return mDirections; }
+  const std::array<LaneValues, 3>& GetDirectionsInverse() const { return mDirectionsInverse; }
+
+private:
+  std::array<LaneValues, 3> mOrigins {};
+  std::array<LaneValues, 3> mDirections {};
+  std::array<LaneValues, 3> mDirectionsInverse {};
+  LaneMask mActiveMask = 0;
+};
+
+// Slab test (same as Intersect(Line, AAHyperBox)) of all the lanes at once.
+// Returns the lanes among inLanesMask that enter the box within [0, inMaxDistances[lane]].
+template <typename T, std::size_t TWidth>
+typename RayPacket<T, TWidth>::LaneMask IntersectCheckLanes(const RayPacket<T, TWidth>& inRayPacket,
+    const AAHyperBox<T, 3>& inAAHyperBox,
+    const typename RayPacket<T, TWidth>::LaneValues& inMaxDistances,
+    const typename RayPacket<T, TWidth>::LaneMask inLanesMask);
+
+// Same as above, also giving the distance at which every returned lane enters the box (0 if it starts inside)
+template <typename T, std::size_t TWidth>
+typename RayPacket<T, TWidth>::LaneMask IntersectCheckLanes(const RayPacket<T, TWidth>& inRayPacket,
+    const AAHyperBox<T, 3>& inAAHyperBox,
+    const typename RayPacket<T, TWidth>::LaneValues& inMaxDistances,
+    const typename RayPacket<T, TWidth>::LaneMask inLanesMask,
+    typename RayPacket<T, TWidth>::LaneValues& outEnterDistances);
+
+// Same hits and distances as IntersectClosest(Ray, primitive) (PrecomputedRay for boxes) for every lane among
+// inLanesMask, keeping the ones within inMaxDistances[lane]. Returns the lanes hit, with their distances in
+// outDistances.
+template <typename T, std::size_t TWidth>
+typename RayPacket<T, TWidth>::LaneMask IntersectClosestLanes(const RayPacket<T, TWidth>& inRayPacket,
+    const AAHyperBox<T, 3>& inAAHyperBox,
+    const typename RayPacket<T, TWidth>::LaneValues& inMaxDistances,
+    const typename RayPacket<T, TWidth>::LaneMask inLanesMask,
+    typename RayPacket<T, TWidth>::LaneValues& outDistances);
+
+template <typename T, std::size_t TWidth>
+typename RayPacket<T, TWidth>::LaneMask IntersectClosestLanes(const RayPacket<T, TWidth>& inRayPacket,
+    const HyperSphere<T, 3>& inHyperSphere,
+    const typename RayPacket<T, TWidth>::LaneValues& inMaxDistances,
+    const typename RayPacket<T, TWidth>::LaneMask inLanesMask,
+    typename RayPacket<T, TWidth>::LaneValues& outDistances);
+
+template <typename T, std::size_t TWidth>
+typename RayPacket<T, TWidth>::LaneMask IntersectClosestLanes(const RayPacket<T, TWidth>& inRayPacket,
+    const Triangle3<T>& inTriangle,
+    const typename RayPacket<T, TWidth>::LaneValues& inMaxDistances,
+    const typename RayPacket<T, TWidth>::LaneMask inLanesMask,
+    typename RayPacket<T, TWidth>::LaneValues& outDistances);
+}
+
+#include "ez/RayPacket.tcc"
\ No newline at end of file
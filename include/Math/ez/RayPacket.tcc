@@ -0,0 +1,250 @@
+#include <ez/Macros.h>
+#include <ez/RayPacket.h>
+
+namespace ez
+{
+
+template <typename T, std::size_t TWidth>
+RayPacket<T, TWidth>::RayPacket(const Span<Ray3<T>>& inRays)
+{
+  EXPECTS(inRays.GetNumberOfElements() <= TWidth);
+  for (std::size_t lane = 0; lane < inRays.GetNumberOfElements(); ++lane) SetRay(lane, inRays.at(lane));
+}
+
+template <typename T, std::size_t TWidth>
+void RayPacket<T, TWidth>::SetRay(const std::size_t inLane, const Ray3<T>& inRay)
+{
+  EXPECTS(inLane < TWidth);
+  for (std::size_t i = 0; i < 3; ++i)
+  {
+    mOrigins[i][inLane] = inRay.GetOrigin()[i];
+    mDirections[i][inLane] = inRay.GetDirection()[i];
+    mDirectionsInverse[i][inLane] = static_cast<T>(1) / inRay.GetDirection()[i];
+  }
+  mActiveMask |= (static_cast<LaneMask>(1) << inLane);
+}
+
+template <typename T, std::size_t TWidth>
+Ray3<T> RayPacket<T, TWidth>::GetRay(const std::size_t inLane) const
+{
+  EXPECTS(inLane < TWidth);
+  return Ray3<T> { Vec3<T> { mOrigins[0][inLane], mOrigins[1][inLane], mOrigins[2][inLane] },
+    Vec3<T> { mDirections[0][inLane], mDirections[1][inLane], mDirections[2][inLane] } };
+}
+
+template <typename T, std::size_t TWidth>
+typename RayPacket<T, TWidth>::LaneMask IntersectCheckLanes(const RayPacket<T, TWidth>& inRayPacket,
+    const AAHyperBox<T, 3>& inAAHyperBox,
+    const typename RayPacket<T, TWidth>::LaneValues& inMaxDistances,
+    const typename RayPacket<T, TWidth>::LaneMask inLanesMask)
+{
+  typename RayPacket<T, TWidth>::LaneValues enter_distances;
+  return IntersectCheckLanes(inRayPacket, inAAHyperBox, inMaxDistances, inLanesMask, enter_distances);
+}
+
+template <typename T, std::size_t TWidth>
+typename RayPacket<T, TWidth>::LaneMask IntersectCheckLanes(const RayPacket<T, TWidth>& inRayPacket,
+    const AAHyperBox<T, 3>& inAAHyperBox,
+    const typename RayPacket<T, TWidth>::LaneValues& inMaxDistances,
+    const typename RayPacket<T, TWidth>::LaneMask inLanesMask,
+    typename RayPacket<T, TWidth>::LaneValues& outEnterDistances)
+{
+  const auto& origins = inRayPacket.GetOrigins();
+  const auto& directions_inverse = inRayPacket.GetDirectionsInverse();
+
+  // The lanes arrays are local and only copied to the output at the end, otherwise the loops would need aliasing checks
+  // and GCC does not vectorize them
+  typename RayPacket<T, TWidth>::LaneValues enters;
+  auto exits = inMaxDistances;
+  enters.fill(static_cast<T>(0));
+  for (std::size_t i = 0; i < 3; ++i)
+  {
+    const auto aabox_min = inAAHyperBox.GetMin()[i];
+    const auto aabox_max = inAAHyperBox.GetMax()[i];
+    for (std::size_t lane = 0; lane < TWidth; ++lane)
+    {
+      // Same operands order as Max/Min (std::max/std::min)
+      const auto tbot = directions_inverse[i][lane] * (aabox_min - origins[i][lane]);
+      const auto ttop = directions_inverse[i][lane] * (aabox_max - origins[i][lane]);
+      const auto tmin = (ttop < tbot ? ttop : tbot);
+      const auto tmax = (tbot < ttop ? ttop : tbot);
+      enters[lane] = (enters[lane] < tmin ? tmin : enters[lane]);
+      exits[lane] = (tmax < exits[lane] ? tmax : exits[lane]);
+    }
+  }
+
+  std::array<SoALaneMask, TWidth> lanes_hit;
+  for (std::size_t lane = 0; lane < TWidth; ++lane)
+    lanes_hit[lane] = static_cast<SoALaneMask>(enters[lane] <= exits[lane]);
+  outEnterDistances = enters;
+  return (primitives_soa_detail::GetLanesMask(lanes_hit) & inLanesMask);
+}
+
+template <typename T, std::size_t TWidth>
+typename RayPacket<T, TWidth>::LaneMask IntersectClosestLanes(const RayPacket<T, TWidth>& inRayPacket,
+    const AAHyperBox<T, 3>& inAAHyperBox,
+    const typename RayPacket<T, TWidth>::LaneValues& inMaxDistances,
+    const typename RayPacket<T, TWidth>::LaneMask inLanesMask,
+    typename RayPacket<T, TWidth>::LaneValues& outDistances)
+{
+  constexpr auto Epsilon = static_cast<T>(1e-7);
+  const auto& origins = inRayPacket.GetOrigins();
+  const auto& directions = inRayPacket.GetDirections();
+  const auto& directions_inverse = inRayPacket.GetDirectionsInverse();
+
+  // Slab test with the near and far planes picked from each lane direction signs, as Intersect(PrecomputedRay,
+  // AAHyperBox) does. Then the closest distance is the enter one, or the exit one if the ray starts inside.
+  typename RayPacket<T, TWidth>::LaneValues enters;
+  typename RayPacket<T, TWidth>::LaneValues exits;
+  enters.fill(-Infinity<T>());
+  exits.fill(Infinity<T>());
+  for (std::size_t i = 0; i < 3; ++i)
+  {
+    const auto aabox_min = inAAHyperBox.GetMin()[i];
+    const auto aabox_max = inAAHyperBox.GetMax()[i];
+    for (std::size_t lane = 0; lane < TWidth; ++lane)
+    {
+      const auto is_negative = (directions[i][lane] < static_cast<T>(0));
+      const auto near_plane = (is_negative ? aabox_max : aabox_min);
+      const auto far_plane = (is_negative ? aabox_min : aabox_max);
+      const auto near_distance = (near_plane - origins[i][lane]) * directions_inverse[i][lane];
+      const auto far_distance = (far_plane - origins[i][lane]) * directions_inverse[i][lane];
+      enters[lane] = (enters[lane] < near_distance ? near_distance : enters[lane]);
+      exits[lane] = (far_distance < exits[lane] ? far_distance : exits[lane]);
+    }
+  }
+
+  std::array<SoALaneMask, TWidth> lanes_hit;
+  typename RayPacket<T, TWidth>::LaneValues lanes_distances;
+  for (std::size_t lane = 0; lane < TWidth; ++lane)
+  {
+    lanes_distances[lane] = (enters[lane] >= Epsilon ? enters[lane] : exits[lane]);
+    lanes_hit[lane] = static_cast<SoALaneMask>((enters[lane] < exits[lane]) & (exits[lane] >= Epsilon)
+        & (lanes_distances[lane] <= inMaxDistances[lane]));
+  }
+  outDistances = lanes_distances;
+  return (primitives_soa_detail::GetLanesMask(lanes_hit) & inLanesMask);
+}
+
+template <typename T, std::size_t TWidth>
+typename RayPacket<T, TWidth>::LaneMask IntersectClosestLanes(const RayPacket<T, TWidth>& inRayPacket,
+    const HyperSphere<T, 3>& inHyperSphere,
+    const typename RayPacket<T, TWidth>::LaneValues& inMaxDistances,
+    const typename RayPacket<T, TWidth>::LaneMask inLanesMask,
+    typename RayPacket<T, TWidth>::LaneValues& outDistances)
+{
+  constexpr auto Epsilon = static_cast<T>(1e-7);
+  const auto& origins = inRayPacket.GetOrigins();
+  const auto& directions = inRayPacket.GetDirections();
+  const auto center_x = Center(inHyperSphere)[0];
+  const auto center_y = Center(inHyperSphere)[1];
+  const auto center_z = Center(inHyperSphere)[2];
+  const auto sq_radius = Sq(inHyperSphere.GetRadius());
+
+  // Same quadratic as Intersect(Line, HyperSphere). As in the SphereSoA kernel, the square roots get their own scalar
+  // loop, and the hit test uses far_distance (>= near_distance, as the distance) so that its division is unconditional.
+  typename RayPacket<T, TWidth>::LaneValues a2s;
+  typename RayPacket<T, TWidth>::LaneValues bs;
+  typename RayPacket<T, TWidth>::LaneValues sqrt_numbers;
+  for (std::size_t lane = 0; lane < TWidth; ++lane)
+  {
+    const auto direction_x = directions[0][lane];
+    const auto direction_y = directions[1][lane];
+    const auto direction_z = directions[2][lane];
+    const auto origin_local_x = origins[0][lane] - center_x;
+    const auto origin_local_y = origins[1][lane] - center_y;
+    const auto origin_local_z = origins[2][lane] - center_z;
+    const auto a = direction_x * direction_x + direction_y * direction_y + direction_z * direction_z;
+    const auto b = static_cast<T>(2)
+        * (origin_local_x * direction_x + origin_local_y * direction_y + origin_local_z * direction_z);
+    const auto c = (origin_local_x * origin_local_x + origin_local_y * origin_local_y + origin_local_z * origin_local_z)
+        - sq_radius;
+    a2s[lane] = a + a;
+    bs[lane] = b;
+    sqrt_numbers[lane] = (b * b - static_cast<T>(4) * a * c);
+  }
+
+  // Most spheres in a leaf are missed by all the lanes, skip the square roots for them
+  std::array<SoALaneMask, TWidth> lanes_crossing;
+  for (std::size_t lane = 0; lane < TWidth; ++lane)
+    lanes_crossing[lane] = static_cast<SoALaneMask>(sqrt_numbers[lane] >= static_cast<T>(0));
+  const auto crossing_lanes_mask = (primitives_soa_detail::GetLanesMask(lanes_crossing) & inLanesMask);
+  if (crossing_lanes_mask == 0)
+    return 0;
+
+  typename RayPacket<T, TWidth>::LaneValues sqrt_results;
+  for (std::size_t lane = 0; lane < TWidth; ++lane)
+    sqrt_results[lane] = Sqrt(sqrt_numbers[lane] < static_cast<T>(0) ? static_cast<T>(0) : sqrt_numbers[lane]);
+
+  std::array<SoALaneMask, TWidth> lanes_hit;
+  typename RayPacket<T, TWidth>::LaneValues lanes_distances;
+  for (std::size_t lane = 0; lane < TWidth; ++lane)
+  {
+    const auto near_distance = (-bs[lane] - sqrt_results[lane]) / a2s[lane];
+    const auto far_distance = (-bs[lane] + sqrt_results[lane]) / a2s[lane];
+    lanes_distances[lane] = (near_distance >= Epsilon ? near_distance : far_distance);
+    lanes_hit[lane]
+        = static_cast<SoALaneMask>((far_distance >= Epsilon) & (lanes_distances[lane] <= inMaxDistances[lane]));
+  }
+  outDistances = lanes_distances;
+  return (primitives_soa_detail::GetLanesMask(lanes_hit) & crossing_lanes_mask);
+}
+
+template <typename T, std::size_t TWidth>
+typename RayPacket<T, TWidth>::LaneMask IntersectClosestLanes(const RayPacket<T, TWidth>& inRayPacket,
+    const Triangle3<T>& inTriangle,
+    const typename RayPacket<T, TWidth>::LaneValues& inMaxDistances,
+    const typename RayPacket<T, TWidth>::LaneMask inLanesMask,
+    typename RayPacket<T, TWidth>::LaneValues& outDistances)
+{
+  constexpr auto Epsilon = static_cast<T>(1e-7);
+  const auto& origins = inRayPacket.GetOrigins();
+  const auto& directions = inRayPacket.GetDirections();
+  const auto edge01 = inTriangle[1] - inTriangle[0];
+  const auto edge02 = inTriangle[2] - inTriangle[0];
+  const auto point0_x = inTriangle[0][0];
+  const auto point0_y = inTriangle[0][1];
+  const auto point0_z = inTriangle[0][2];
+  const auto edge01_x = edge01[0];
+  const auto edge01_y = edge01[1];
+  const auto edge01_z = edge01[2];
+  const auto edge02_x = edge02[0];
+  const auto edge02_y = edge02[1];
+  const auto edge02_z = edge02[2];
+
+  // Moller-Trumbore, same as the TriangleSoA kernel with the rays in the lanes instead of the triangles
+  std::array<SoALaneMask, TWidth> lanes_hit;
+  typename RayPacket<T, TWidth>::LaneValues lanes_distances;
+  for (std::size_t lane = 0; lane < TWidth; ++lane)
+  {
+    const auto direction_x = directions[0][lane];
+    const auto direction_y = directions[1][lane];
+    const auto direction_z = directions[2][lane];
+
+    // p = Cross(direction, edge02)
+    const auto p_x = direction_y * edge02_z - direction_z * edge02_y;
+    const auto p_y = direction_z * edge02_x - direction_x * edge02_z;
+    const auto p_z = direction_x * edge02_y - direction_y * edge02_x;
+    const auto determinant = edge01_x * p_x + edge01_y * p_y + edge01_z * p_z;
+    const auto determinant_inverse = static_cast<T>(1) / determinant;
+
+    const auto origin_from_point0_x = origins[0][lane] - point0_x;
+    const auto origin_from_point0_y = origins[1][lane] - point0_y;
+    const auto origin_from_point0_z = origins[2][lane] - point0_z;
+    const auto u = (origin_from_point0_x * p_x + origin_from_point0_y * p_y + origin_from_point0_z * p_z)
+        * determinant_inverse;
+
+    // q = Cross(origin_from_point0, edge01)
+    const auto q_x = origin_from_point0_y * edge01_z - origin_from_point0_z * edge01_y;
+    const auto q_y = origin_from_point0_z * edge01_x - origin_from_point0_x * edge01_z;
+    const auto q_z = origin_from_point0_x * edge01_y - origin_from_point0_y * edge01_x;
+    const auto v = (direction_x * q_x + direction_y * q_y + direction_z * q_z) * determinant_inverse;
+    lanes_distances[lane] = (edge02_x * q_x + edge02_y * q_y + edge02_z * q_z) * determinant_inverse;
+    lanes_hit[lane] = static_cast<SoALaneMask>((determinant != static_cast<T>(0)) & (u >= static_cast<T>(0))
+        & (u <= static_cast<T>(1)) & (v >= static_cast<T>(0)) & (u + v <= static_cast<T>(1))
+        & (lanes_distances[lane] >= Epsilon) & (lanes_distances[lane] <= inMaxDistances[lane]));
+  }
+  outDistances = lanes_distances;
+  return (primitives_soa_detail::GetLanesMask(lanes_hit) & inLanesMask);
+}
+}
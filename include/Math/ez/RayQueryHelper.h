@@ -0,0 +1,219 @@
+#pragma once
+
+#include <ez/AAHyperBox.h>
+#include <ez/HierarchyCommon.h>
+#include <ez/IntersectMode.h>
+#include <ez/MathIntersection.h>
+#include <ez/MathTypeTraits.h>
+#include <ez/PrecomputedRay.h>
+#include <ez/Ray.h>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace ez
+{
+namespace ray_query_detail
+{
+  // Primitives whose ray intersection can take a max distance (to give up as soon as the hit is known to be further)
+  // receive inMaxDistance. Then, primitives with a precomputed ray intersection (e.g. boxes) use it.
+  template <EIntersectMode TIntersectMode, typename TPrimitive, typename T>
+  auto IntersectRayPrimitive(const PrecomputedRay3<T>& inRay, const TPrimitive& inPrimitive, const T& inMaxDistance)
+  {
+    if constexpr (requires { ::ez::Intersect<TIntersectMode>(inRay.GetRay(), inPrimitive, inMaxDistance); })
+      return ::ez::Intersect<TIntersectMode>(inRay.GetRay(), inPrimitive, inMaxDistance);
+    else if constexpr (requires { ::ez::Intersect<TIntersectMode>(inRay, inPrimitive); })
+      return ::ez::Intersect<TIntersectMode>(inRay, inPrimitive);
+    else
+      return ::ez::Intersect<TIntersectMode>(inRay.GetRay(), inPrimitive);
+  }
+
+  // Ray query state shared by the hierarchies with the HierarchyIntersection hit type (Bvh, DynamicAABBTree,
+  // FlatOctree, LooseOctree): the precomputed ray, the intersections found so far and how the primitives results are
+  // kept.
+  template <typename TPrimitive>
+  struct RayQueryHelper final
+  {
+    using ValueType = ValueType_t<TPrimitive>;
+    using AABoxType = AABox<ValueType>;
+    using PrimitiveIndex = HierarchyPrimitiveIndex;
+    using IntersectionType = HierarchyIntersection<ValueType>;
+
+    const PrecomputedRay3<ValueType> mRay;
+    const ValueType mMaxDistance;
+    std::vector<IntersectionType> mIntersections;         // ALL_INTERSECTIONS
+    std::optional<IntersectionType> mClosestIntersection; // ONLY_CLOSEST
+
+    RayQueryHelper(const Ray3<ValueType>& inRay, const ValueType& inMaxDistance)
+        : mRay { inRay },
+          mMaxDistance { inMaxDistance }
+    {
+    }
+
+    // Nodes further than this can be culled: nothing behind the closest intersection found so far can be closer
+    template <EIntersectMode TIntersectMode>
+    ValueType GetCullDistance() const
+    {
+      if constexpr (TIntersectMode == EIntersectMode::ONLY_CLOSEST)
+        return (mClosestIntersection ? mClosestIntersection->mDistance : mMaxDistance);
+      else
+        return mMaxDistance;
+    }
+
+    // Returns the distance at which the ray enters the box, if it does so within [0, inMaxDistance]
+    std::optional<ValueType> GetEnterDistance(const AABoxType& inAABox, const ValueType inMaxDistance) const
+    {
+      return ::ez::GetEnterDistance(mRay, inAABox, inMaxDistance);
+    }
+
+    std::optional<ValueType> GetEnterDistance(const AABoxType& inAABox) const
+    {
+      return GetEnterDistance(inAABox, mMaxDistance);
+    }
+
+    // Tests the primitive and keeps its intersections. Returns whether the query is over (a hit in ONLY_CHECK mode).
+    template <EIntersectMode TIntersectMode>
+    bool IntersectPrimitive(const PrimitiveIndex inPrimitiveIndex, const TPrimitive& inPrimitive)
+    {
+      if constexpr (TIntersectMode == EIntersectMode::ONLY_CHECK)
+      {
+        return IntersectCheckPrimitive(inPrimitive);
+      }
+      else
+      {
+        TreatIntersectionResult<TIntersectMode>(inPrimitiveIndex,
+            IntersectRayPrimitive<TIntersectMode>(mRay, inPrimitive, GetCullDistance<TIntersectMode>()));
+        return false;
+      }
+    }
+
+    bool IntersectCheckPrimitive(const TPrimitive& inPrimitive) const
+    {
+      if (mMaxDistance == Infinity<ValueType>())
+        return ::ez::IntersectCheck(mRay.GetRay(), inPrimitive);
+
+      const auto primitive_closest_intersection = ::ez::IntersectClosest(mRay.GetRay(), inPrimitive);
+      return primitive_closest_intersection && *primitive_closest_intersection <= mMaxDistance;
+    }
+
+    template <EIntersectMode TIntersectMode, typename TIntersectionDistances>
+    void TreatIntersectionResult(const PrimitiveIndex inPrimitiveIndex,
+        const TIntersectionDistances& inIntersectionDistances)
+    {
+      if constexpr (IsArray_v<TIntersectionDistances>)
+      {
+        for (const auto& intersection_distance : inIntersectionDistances)
+          TreatIntersectionResult<TIntersectMode>(inPrimitiveIndex, intersection_distance);
+      }
+      else
+      {
+        const auto& intersection_distance = inIntersectionDistances;
+        if (!intersection_distance || *intersection_distance > mMaxDistance)
+          return; // Do not consider intersections further than the maximum distance
+
+        if constexpr (TIntersectMode == EIntersectMode::ALL_INTERSECTIONS)
+        {
+          mIntersections.emplace_back(*intersection_distance, inPrimitiveIndex);
+        }
+        else if constexpr (TIntersectMode == EIntersectMode::ONLY_CLOSEST)
+        {
+          if (!mClosestIntersection || *intersection_distance < mClosestIntersection->mDistance)
+            mClosestIntersection = IntersectionType { *intersection_distance, inPrimitiveIndex };
+        }
+      }
+    }
+
+    // The query result once the traversal has ended without an ONLY_CHECK hit
+    template <EIntersectMode TIntersectMode>
+    auto GetResult()
+    {
+      static_assert(TIntersectMode == EIntersectMode::ALL_INTERSECTIONS
+              || TIntersectMode == EIntersectMode::ONLY_CLOSEST || TIntersectMode == EIntersectMode::ONLY_CHECK,
+          "Unsupported EIntersectMode");
+
+      if constexpr (TIntersectMode == EIntersectMode::ALL_INTERSECTIONS)
+        return std::move(mIntersections);
+      else if constexpr (TIntersectMode == EIntersectMode::ONLY_CLOSEST)
+        return mClosestIntersection;
+      else if constexpr (TIntersectMode == EIntersectMode::ONLY_CHECK)
+        return false;
+    }
+
+    // Front-to-back traversal of a binary hierarchy (Bvh, DynamicAABBTree) from inRootIndex, whose nodes (with mAABox
+    // and IsLeaf()) are inNodes[inNodeIndex]. inGetChildrenIndices(inNodeIndex, inNode) returns the two children
+    // indices of an internal node, and inIntersectLeaf(inNodeIndex, inNode) tests the primitives of a leaf (with
+    // IntersectPrimitive or TreatIntersectionResult) and returns whether the query is over.
+    template <EIntersectMode TIntersectMode,
+        typename TNodes,
+        typename TNodeIndex,
+        typename TGetChildrenIndices,
+        typename TIntersectLeaf>
+    auto IntersectBinaryHierarchy(const TNodes& inNodes,
+        const TNodeIndex inRootIndex,
+        const TGetChildrenIndices& inGetChildrenIndices,
+        const TIntersectLeaf& inIntersectLeaf)
+    {
+      struct NodeToExplore final
+      {
+        TNodeIndex mNodeIndex = 0;
+        ValueType mEnterDistance = static_cast<ValueType>(0);
+      };
+
+      std::vector<NodeToExplore> nodes_to_explore;
+      if (const auto root_enter_distance = GetEnterDistance(inNodes[inRootIndex].mAABox))
+        nodes_to_explore.push_back({ inRootIndex, *root_enter_distance });
+
+      while (!nodes_to_explore.empty())
+      {
+        const auto node_to_explore = nodes_to_explore.back();
+        nodes_to_explore.pop_back();
+        if (node_to_explore.mEnterDistance > GetCullDistance<TIntersectMode>())
+          continue;
+
+        const auto& node = inNodes[node_to_explore.mNodeIndex];
+        if (node.IsLeaf())
+        {
+          if constexpr (TIntersectMode == EIntersectMode::ONLY_CHECK)
+          {
+            if (inIntersectLeaf(node_to_explore.mNodeIndex, node))
+              return true;
+          }
+          else
+          {
+            inIntersectLeaf(node_to_explore.mNodeIndex, node);
+          }
+          continue;
+        }
+
+        // Recursive case, push the intersected children so that the closest one gets explored first
+        const auto max_distance = GetCullDistance<TIntersectMode>();
+        const auto children_indices = inGetChildrenIndices(node_to_explore.mNodeIndex, node);
+        const auto first_child_index = static_cast<TNodeIndex>(children_indices[0]);
+        const auto second_child_index = static_cast<TNodeIndex>(children_indices[1]);
+        const auto first_child_enter_distance = GetEnterDistance(inNodes[first_child_index].mAABox, max_distance);
+        const auto second_child_enter_distance = GetEnterDistance(inNodes[second_child_index].mAABox, max_distance);
+        if (first_child_enter_distance && second_child_enter_distance)
+        {
+          const auto is_first_child_closer = (*first_child_enter_distance <= *second_child_enter_distance);
+          const auto closer_child = NodeToExplore { is_first_child_closer ? first_child_index : second_child_index,
+            is_first_child_closer ? *first_child_enter_distance : *second_child_enter_distance };
+          const auto further_child = NodeToExplore { is_first_child_closer ? second_child_index : first_child_index,
+            is_first_child_closer ? *second_child_enter_distance : *first_child_enter_distance };
+          nodes_to_explore.push_back(further_child);
+          nodes_to_explore.push_back(closer_child);
+        }
+        else if (first_child_enter_distance)
+        {
+          nodes_to_explore.push_back({ first_child_index, *first_child_enter_distance });
+        }
+        else if (second_child_enter_distance)
+        {
+          nodes_to_explore.push_back({ second_child_index, *second_child_enter_distance });
+        }
+      }
+
+      return GetResult<TIntersectMode>();
+    }
+  };
+}
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <ez/AAHyperBox.h>
+#include <ez/MathTypeTraits.h>
+#include <ez/ParallelPolicy.h>
+#include <ez/Span.h>
+#include <ez/Vec.h>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace ez
+{
+
+// Uniform grid of cells of size inCellSize, for big sets of small moving primitives (points, spheres...).
+// Only the cells that have primitives exist, in an open-addressed hash table keyed by their integer coordinates, so the
+// grid is unbounded. Every primitive is in the cell of its bounding box center, chained to the other primitives of that
+// cell through flat arrays, so that adding, moving and removing a primitive is O(1) and does not allocate (other than
+// to grow the arrays). Queries work best with cells about as big as the query radius and the primitives.
+template <typename TPrimitive, std::size_t N>
+class SpatialHashGrid final
+{
+public:
+  using ValueType = ValueType_t<TPrimitive>;
+  using PointType = Vec<ValueType, N>;
+  using CellCoordinates = Vec<int32_t, N>;
+  using PrimitiveIndex = std::size_t;
+
+  explicit SpatialHashGrid(const ValueType inCellSize, const std::size_t inExpectedNumPrimitives = 0);
+
+  // Returns the index of the added primitive (slots of removed primitives are reused)
+  PrimitiveIndex AddPrimitive(const TPrimitive& inPrimitive);
+  bool RemovePrimitive(const PrimitiveIndex inPrimitiveIndex);
+  // Moves the primitive keeping its index, only relinking it when it changes cell
+  bool UpdatePrimitive(const PrimitiveIndex inPrimitiveIndex, const TPrimitive& inNewPrimitive);
+  void Clear();
+
+  bool HasPrimitive(const PrimitiveIndex inPrimitiveIndex) const;
+  const TPrimitive& GetPrimitive(const PrimitiveIndex inPrimitiveIndex) const;
+  std::size_t GetNumberOfPrimitives() const { return mNumPrimitives; }
+  ValueType GetCellSize() const { return mCellSize; }
+  CellCoordinates GetCellCoordinates(const PointType& inPoint) const;
+
+  // Calls inCallback(inPrimitiveIndex) for every primitive in the given cell
+  template <typename TCallback>
+  void ForEachPrimitiveInCell(const CellCoordinates& inCellCoordinates, const TCallback& inCallback) const;
+
+  // Calls inCallback(inPrimitiveIndex) for every primitive in the 3^N cells around the given one (itself included)
+  template <typename TCallback>
+  void ForEachPrimitiveInNeighbourCells(const CellCoordinates& inCellCoordinates, const TCallback& inCallback) const;
+
+  // Calls inCallback(inPrimitiveIndex) for every primitive at distance <= inRadius from inPoint (distance to its
+  // closest point), in no particular order
+  template <typename TCallback>
+  void ForEachPrimitiveWithinRadius(const PointType& inPoint,
+      const ValueType inRadius,
+      const TCallback& inCallback) const;
+
+private:
+  static constexpr auto InvalidIndex = Max<std::size_t>();
+  static constexpr std::size_t NumHalfExtentBuckets = 64;
+
+  struct Cell final
+  {
+    CellCoordinates mCoordinates;
+    std::size_t mFirstPrimitiveIndex = InvalidIndex; // InvalidIndex when the cell has no primitives
+    bool mIsUsed = false;                            // Cells stay in the table when emptied, until the next rehash
+  };
+
+  struct PrimitiveLinks final
+  {
+    std::size_t mCellIndex = InvalidIndex; // InvalidIndex for removed primitives
+    std::size_t mPreviousPrimitiveIndex = InvalidIndex;
+    std::size_t mNextPrimitiveIndex = InvalidIndex;
+  };
+
+  // Primitives counted by the power of 2 of their half extent relative to the cell size, so that radius queries only
+  // widen their search by the half extents of the primitives that are still in the grid
+  struct HalfExtentBucket final
+  {
+    std::size_t mNumPrimitives = 0;
+    ValueType mMaxHalfExtent = static_cast<ValueType>(0); // Only reset when the bucket gets empty
+  };
+
+  ValueType mCellSize = static_cast<ValueType>(1);
+  std::array<HalfExtentBucket, NumHalfExtentBuckets> mHalfExtentBuckets; // Bucket 0 is for the zero half extents
+  std::size_t mMaxHalfExtentBucketIndex = 0;                             // Highest non-empty bucket (0 if none)
+  std::vector<Cell> mCells; // Open-addressed (linear probing), power of 2 size
+  std::size_t mNumUsedCells = 0;
+  std::vector<TPrimitive> mPrimitivesPool;
+  std::vector<PrimitiveLinks> mPrimitivesLinks; // Same size as mPrimitivesPool
+  std::vector<PrimitiveIndex> mFreePrimitivesIndices;
+  std::size_t mNumPrimitives = 0;
+
+  std::size_t FindCellIndex(const CellCoordinates& inCellCoordinates) const; // Used cell, or the empty slot to use
+  std::size_t GetOrAddCellIndex(const CellCoordinates& inCellCoordinates);
+  void Rehash(const std::size_t inMinNumCells);
+  void LinkPrimitive(const PrimitiveIndex inPrimitiveIndex, const std::size_t inCellIndex);
+  void UnlinkPrimitive(const PrimitiveIndex inPrimitiveIndex);
+  std::size_t GetHalfExtentBucketIndex(const ValueType inHalfExtent) const;
+  void AddHalfExtent(const ValueType inHalfExtent);
+  void RemoveHalfExtent(const ValueType inHalfExtent);
+  static ValueType GetHalfExtent(const AAHyperBox<ValueType, N>& inAABox);
+  static std::size_t HashCellCoordinates(const CellCoordinates& inCellCoordinates);
+};
+
+// Batched radius query. The primitives at distance <= inRadius from inPoints[i] are written to
+// outPrimitivesIndices[outOffsets[i], outOffsets[i + 1]), in no particular order. Points are spread across the policy
+// threads.
+template <typename TPrimitive, std::size_t N>
+void FindWithinRadius(const SpatialHashGrid<TPrimitive, N>& inSpatialHashGrid,
+    const Span<Vec<ValueType_t<TPrimitive>, N>>& inPoints,
+    const ValueType_t<TPrimitive> inRadius,
+    std::vector<typename SpatialHashGrid<TPrimitive, N>::PrimitiveIndex>& outPrimitivesIndices,
+    std::vector<std::size_t>& outOffsets,
+    const ParallelPolicy& inParallelPolicy = ParallelPolicy { 1 });
+}
+
+#include "ez/SpatialHashGrid.tcc"
\ No newline at end of file
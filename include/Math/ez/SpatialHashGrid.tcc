@@ -0,0 +1,394 @@
+#include <ez/Macros.h>
+#include <ez/MathCommon.h>
+#include <ez/MathMultiComponent.h>
+#include <ez/SpatialHashGrid.h>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace ez
+{
+
+template <typename TPrimitive, std::size_t N>
+SpatialHashGrid<TPrimitive, N>::SpatialHashGrid(const ValueType inCellSize, const std::size_t inExpectedNumPrimitives)
+    : mCellSize { inCellSize }
+{
+  EXPECTS(inCellSize > static_cast<ValueType>(0));
+  mPrimitivesPool.reserve(inExpectedNumPrimitives);
+  mPrimitivesLinks.reserve(inExpectedNumPrimitives);
+  Rehash(inExpectedNumPrimitives);
+}
+
+template <typename TPrimitive, std::size_t N>
+typename SpatialHashGrid<TPrimitive, N>::PrimitiveIndex SpatialHashGrid<TPrimitive, N>::AddPrimitive(
+    const TPrimitive& inPrimitive)
+{
+  const auto reuse_free_primitive_index = !mFreePrimitivesIndices.empty();
+  const auto primitive_index = (reuse_free_primitive_index ? mFreePrimitivesIndices.back() : mPrimitivesPool.size());
+  if (reuse_free_primitive_index)
+  {
+    mFreePrimitivesIndices.pop_back();
+    mPrimitivesPool[primitive_index] = inPrimitive;
+  }
+  else
+  {
+    mPrimitivesPool.push_back(inPrimitive);
+    mPrimitivesLinks.emplace_back();
+  }
+
+  const auto primitive_aabox = BoundingAAHyperBox(inPrimitive);
+  AddHalfExtent(GetHalfExtent(primitive_aabox));
+  LinkPrimitive(primitive_index, GetOrAddCellIndex(GetCellCoordinates(primitive_aabox.GetCenter())));
+  ++mNumPrimitives;
+  return primitive_index;
+}
+
+template <typename TPrimitive, std::size_t N>
+bool SpatialHashGrid<TPrimitive, N>::RemovePrimitive(const PrimitiveIndex inPrimitiveIndex)
+{
+  if (!HasPrimitive(inPrimitiveIndex))
+    return false;
+
+  RemoveHalfExtent(GetHalfExtent(BoundingAAHyperBox(mPrimitivesPool[inPrimitiveIndex])));
+  UnlinkPrimitive(inPrimitiveIndex);
+  mFreePrimitivesIndices.push_back(inPrimitiveIndex);
+  --mNumPrimitives;
+  return true;
+}
+
+template <typename TPrimitive, std::size_t N>
+bool SpatialHashGrid<TPrimitive, N>::UpdatePrimitive(const PrimitiveIndex inPrimitiveIndex,
+    const TPrimitive& inNewPrimitive)
+{
+  if (!HasPrimitive(inPrimitiveIndex))
+    return false;
+
+  RemoveHalfExtent(GetHalfExtent(BoundingAAHyperBox(mPrimitivesPool[inPrimitiveIndex])));
+  mPrimitivesPool[inPrimitiveIndex] = inNewPrimitive;
+  const auto primitive_aabox = BoundingAAHyperBox(inNewPrimitive);
+  AddHalfExtent(GetHalfExtent(primitive_aabox));
+
+  const auto new_cell_coordinates = GetCellCoordinates(primitive_aabox.GetCenter());
+  if (mCells[mPrimitivesLinks[inPrimitiveIndex].mCellIndex].mCoordinates != new_cell_coordinates)
+  {
+    UnlinkPrimitive(inPrimitiveIndex);
+    LinkPrimitive(inPrimitiveIndex, GetOrAddCellIndex(new_cell_coordinates));
+  }
+  return true;
+}
+
+template <typename TPrimitive, std::size_t N>
+void SpatialHashGrid<TPrimitive, N>::Clear()
+{
+  std::fill(mCells.begin(), mCells.end(), Cell {});
+  mNumUsedCells = 0;
+  mPrimitivesPool.clear();
+  mPrimitivesLinks.clear();
+  mFreePrimitivesIndices.clear();
+  mNumPrimitives = 0;
+  mHalfExtentBuckets.fill(HalfExtentBucket {});
+  mMaxHalfExtentBucketIndex = 0;
+}
+
+template <typename TPrimitive, std::size_t N>
+bool SpatialHashGrid<TPrimitive, N>::HasPrimitive(const PrimitiveIndex inPrimitiveIndex) const
+{
+  return inPrimitiveIndex < mPrimitivesLinks.size() && mPrimitivesLinks[inPrimitiveIndex].mCellIndex != InvalidIndex;
+}
+
+template <typename TPrimitive, std::size_t N>
+const TPrimitive& SpatialHashGrid<TPrimitive, N>::GetPrimitive(const PrimitiveIndex inPrimitiveIndex) const
+{
+  EXPECTS(HasPrimitive(inPrimitiveIndex));
+  return mPrimitivesPool[inPrimitiveIndex];
+}
+
+template <typename TPrimitive, std::size_t N>
+typename SpatialHashGrid<TPrimitive, N>::CellCoordinates SpatialHashGrid<TPrimitive, N>::GetCellCoordinates(
+    const PointType& inPoint) const
+{
+  // Clamped to the int32_t range (NaN to its min), as converting out of range values is undefined. Done in double,
+  // which represents all the int32_t values exactly.
+  constexpr auto MinCellCoordinate = static_cast<double>(std::numeric_limits<int32_t>::min());
+  constexpr auto MaxCellCoordinate = static_cast<double>(std::numeric_limits<int32_t>::max());
+  const auto floored_cell_coordinates = Floor(inPoint / mCellSize);
+  CellCoordinates cell_coordinates;
+  for (std::size_t i = 0; i < N; ++i)
+  {
+    const auto cell_coordinate = static_cast<double>(floored_cell_coordinates[i]);
+    cell_coordinates[i] = static_cast<int32_t>(
+        std::isnan(cell_coordinate) ? MinCellCoordinate
+                                    : std::clamp(cell_coordinate, MinCellCoordinate, MaxCellCoordinate));
+  }
+  return cell_coordinates;
+}
+
+template <typename TPrimitive, std::size_t N>
+template <typename TCallback>
+void SpatialHashGrid<TPrimitive, N>::ForEachPrimitiveInCell(const CellCoordinates& inCellCoordinates,
+    const TCallback& inCallback) const
+{
+  const auto& cell = mCells[FindCellIndex(inCellCoordinates)];
+  if (!cell.mIsUsed)
+    return;
+
+  for (auto primitive_index = cell.mFirstPrimitiveIndex; primitive_index != InvalidIndex;)
+  {
+    const auto next_primitive_index = mPrimitivesLinks[primitive_index].mNextPrimitiveIndex;
+    inCallback(static_cast<PrimitiveIndex>(primitive_index));
+    primitive_index = next_primitive_index;
+  }
+}
+
+template <typename TPrimitive, std::size_t N>
+template <typename TCallback>
+void SpatialHashGrid<TPrimitive, N>::ForEachPrimitiveInNeighbourCells(const CellCoordinates& inCellCoordinates,
+    const TCallback& inCallback) const
+{
+  // Walk the 3^N offsets in [-1, 1]^N like an odometer
+  auto offset = All<CellCoordinates>(-1);
+  while (true)
+  {
+    ForEachPrimitiveInCell(inCellCoordinates + offset, inCallback);
+
+    std::size_t i = 0;
+    for (; i < N && offset[i] == 1; ++i) offset[i] = -1;
+    if (i == N)
+      break;
+    ++offset[i];
+  }
+}
+
+template <typename TPrimitive, std::size_t N>
+template <typename TCallback>
+void SpatialHashGrid<TPrimitive, N>::ForEachPrimitiveWithinRadius(const PointType& inPoint,
+    const ValueType inRadius,
+    const TCallback& inCallback) const
+{
+  if (mNumPrimitives == 0)
+    return;
+
+  // Primitives are in the cell of their center, so look for centers up to their max half extent further
+  const auto sq_radius = Sq(inRadius);
+  const auto max_primitive_half_extent = mHalfExtentBuckets[mMaxHalfExtentBucketIndex].mMaxHalfExtent;
+  const auto search_extent = All<PointType>(inRadius + max_primitive_half_extent);
+  const auto min_cell_coordinates = GetCellCoordinates(inPoint - search_extent);
+  const auto max_cell_coordinates = GetCellCoordinates(inPoint + search_extent);
+  const auto report_if_within_radius = [&](const PrimitiveIndex inPrimitiveIndex) {
+    const auto& primitive = mPrimitivesPool[inPrimitiveIndex];
+    if (SqDistance(inPoint, ClosestPoint(primitive, inPoint)) <= sq_radius)
+      inCallback(inPrimitiveIndex);
+  };
+
+  // For big radii, going through the used cells is cheaper than looking up every cell in the range
+  auto num_cells_in_range = static_cast<ValueType>(1);
+  for (std::size_t i = 0; i < N; ++i)
+    num_cells_in_range *= static_cast<ValueType>(
+        static_cast<int64_t>(max_cell_coordinates[i]) - static_cast<int64_t>(min_cell_coordinates[i]) + 1);
+  if (num_cells_in_range > static_cast<ValueType>(mNumUsedCells))
+  {
+    for (const auto& cell : mCells)
+    {
+      if (!cell.mIsUsed || !(cell.mCoordinates >= min_cell_coordinates && cell.mCoordinates <= max_cell_coordinates))
+        continue;
+
+      for (auto primitive_index = cell.mFirstPrimitiveIndex; primitive_index != InvalidIndex;
+           primitive_index = mPrimitivesLinks[primitive_index].mNextPrimitiveIndex)
+        report_if_within_radius(primitive_index);
+    }
+    return;
+  }
+
+  auto cell_coordinates = min_cell_coordinates;
+  while (true)
+  {
+    ForEachPrimitiveInCell(cell_coordinates, report_if_within_radius);
+
+    std::size_t i = 0;
+    for (; i < N && cell_coordinates[i] == max_cell_coordinates[i]; ++i) cell_coordinates[i] = min_cell_coordinates[i];
+    if (i == N)
+      break;
+    ++cell_coordinates[i];
+  }
+}
+
+template <typename TPrimitive, std::size_t N>
+std::size_t SpatialHashGrid<TPrimitive, N>::FindCellIndex(const CellCoordinates& inCellCoordinates) const
+{
+  // There is always some unused cell (load factor <= 1/2), so probing ends
+  const auto cells_mask = (mCells.size() - 1);
+  auto cell_index = (HashCellCoordinates(inCellCoordinates) & cells_mask);
+  while (mCells[cell_index].mIsUsed && !(mCells[cell_index].mCoordinates == inCellCoordinates))
+    cell_index = ((cell_index + 1) & cells_mask);
+  return cell_index;
+}
+
+template <typename TPrimitive, std::size_t N>
+std::size_t SpatialHashGrid<TPrimitive, N>::GetOrAddCellIndex(const CellCoordinates& inCellCoordinates)
+{
+  auto cell_index = FindCellIndex(inCellCoordinates);
+  if (mCells[cell_index].mIsUsed)
+    return cell_index;
+
+  if (2 * (mNumUsedCells + 1) > mCells.size())
+  {
+    Rehash(mNumUsedCells + 1);
+    cell_index = FindCellIndex(inCellCoordinates);
+  }
+
+  auto& cell = mCells[cell_index];
+  cell.mCoordinates = inCellCoordinates;
+  cell.mIsUsed = true;
+  ++mNumUsedCells;
+  return cell_index;
+}
+
+template <typename TPrimitive, std::size_t N>
+void SpatialHashGrid<TPrimitive, N>::Rehash(const std::size_t inMinNumCells)
+{
+  // Emptied cells are dropped here, so the table only keeps the cells that have primitives
+  std::vector<Cell> old_cells;
+  old_cells.swap(mCells);
+  std::size_t num_non_empty_cells = 0;
+  for (const auto& old_cell : old_cells)
+    num_non_empty_cells += (old_cell.mIsUsed && old_cell.mFirstPrimitiveIndex != InvalidIndex) ? 1 : 0;
+
+  const auto num_cells_to_fit = std::max(num_non_empty_cells + 1, inMinNumCells);
+  mCells.resize(std::bit_ceil(std::max(static_cast<std::size_t>(16), 4 * num_cells_to_fit)));
+  mNumUsedCells = 0;
+  for (const auto& old_cell : old_cells)
+  {
+    if (!old_cell.mIsUsed || old_cell.mFirstPrimitiveIndex == InvalidIndex)
+      continue;
+
+    const auto cell_index = FindCellIndex(old_cell.mCoordinates);
+    mCells[cell_index] = old_cell;
+    ++mNumUsedCells;
+    for (auto primitive_index = old_cell.mFirstPrimitiveIndex; primitive_index != InvalidIndex;
+         primitive_index = mPrimitivesLinks[primitive_index].mNextPrimitiveIndex)
+      mPrimitivesLinks[primitive_index].mCellIndex = cell_index;
+  }
+}
+
+template <typename TPrimitive, std::size_t N>
+void SpatialHashGrid<TPrimitive, N>::LinkPrimitive(const PrimitiveIndex inPrimitiveIndex, const std::size_t inCellIndex)
+{
+  auto& cell = mCells[inCellIndex];
+  auto& primitive_links = mPrimitivesLinks[inPrimitiveIndex];
+  primitive_links.mCellIndex = inCellIndex;
+  primitive_links.mPreviousPrimitiveIndex = InvalidIndex;
+  primitive_links.mNextPrimitiveIndex = cell.mFirstPrimitiveIndex;
+  if (cell.mFirstPrimitiveIndex != InvalidIndex)
+    mPrimitivesLinks[cell.mFirstPrimitiveIndex].mPreviousPrimitiveIndex = inPrimitiveIndex;
+  cell.mFirstPrimitiveIndex = inPrimitiveIndex;
+}
+
+template <typename TPrimitive, std::size_t N>
+void SpatialHashGrid<TPrimitive, N>::UnlinkPrimitive(const PrimitiveIndex inPrimitiveIndex)
+{
+  auto& primitive_links = mPrimitivesLinks[inPrimitiveIndex];
+  if (primitive_links.mPreviousPrimitiveIndex != InvalidIndex)
+    mPrimitivesLinks[primitive_links.mPreviousPrimitiveIndex].mNextPrimitiveIndex = primitive_links.mNextPrimitiveIndex;
+  else
+    mCells[primitive_links.mCellIndex].mFirstPrimitiveIndex = primitive_links.mNextPrimitiveIndex;
+
+  if (primitive_links.mNextPrimitiveIndex != InvalidIndex)
+    mPrimitivesLinks[primitive_links.mNextPrimitiveIndex].mPreviousPrimitiveIndex = primitive_links.mPreviousPrimitiveIndex;
+
+  primitive_links = PrimitiveLinks {};
+}
+
+template <typename TPrimitive, std::size_t N>
+std::size_t SpatialHashGrid<TPrimitive, N>::GetHalfExtentBucketIndex(const ValueType inHalfExtent) const
+{
+  // Bucket i > 0 has the half extents in [2^(i - 32), 2^(i - 31)) cells, the first and last ones also the ones below
+  // and above
+  if (!(inHalfExtent > static_cast<ValueType>(0)))
+    return 0;
+
+  const auto exponent = std::ilogb(inHalfExtent / mCellSize);
+  return static_cast<std::size_t>(std::clamp(exponent, -31, static_cast<int>(NumHalfExtentBuckets) - 33) + 32);
+}
+
+template <typename TPrimitive, std::size_t N>
+void SpatialHashGrid<TPrimitive, N>::AddHalfExtent(const ValueType inHalfExtent)
+{
+  const auto bucket_index = GetHalfExtentBucketIndex(inHalfExtent);
+  auto& bucket = mHalfExtentBuckets[bucket_index];
+  ++bucket.mNumPrimitives;
+  bucket.mMaxHalfExtent = std::max(bucket.mMaxHalfExtent, inHalfExtent);
+  mMaxHalfExtentBucketIndex = std::max(mMaxHalfExtentBucketIndex, bucket_index);
+}
+
+template <typename TPrimitive, std::size_t N>
+void SpatialHashGrid<TPrimitive, N>::RemoveHalfExtent(const ValueType inHalfExtent)
+{
+  auto& bucket = mHalfExtentBuckets[GetHalfExtentBucketIndex(inHalfExtent)];
+  EXPECTS(bucket.mNumPrimitives > 0);
+  if (--bucket.mNumPrimitives > 0)
+    return;
+
+  bucket.mMaxHalfExtent = static_cast<ValueType>(0);
+  while (mMaxHalfExtentBucketIndex > 0 && mHalfExtentBuckets[mMaxHalfExtentBucketIndex].mNumPrimitives == 0)
+    --mMaxHalfExtentBucketIndex;
+}
+
+template <typename TPrimitive, std::size_t N>
+typename SpatialHashGrid<TPrimitive, N>::ValueType SpatialHashGrid<TPrimitive, N>::GetHalfExtent(
+    const AAHyperBox<ValueType, N>& inAABox)
+{
+  return Max(inAABox.GetSize()) / static_cast<ValueType>(2);
+}
+
+template <typename TPrimitive, std::size_t N>
+std::size_t SpatialHashGrid<TPrimitive, N>::HashCellCoordinates(const CellCoordinates& inCellCoordinates)
+{
+  uint64_t hash = 0;
+  for (std::size_t i = 0; i < N; ++i)
+    hash = (hash ^ static_cast<uint32_t>(inCellCoordinates[i])) * static_cast<uint64_t>(0x9E3779B97F4A7C15);
+  return static_cast<std::size_t>(hash ^ (hash >> 32));
+}
+
+template <typename TPrimitive, std::size_t N>
+void FindWithinRadius(const SpatialHashGrid<TPrimitive, N>& inSpatialHashGrid,
+    const Span<Vec<ValueType_t<TPrimitive>, N>>& inPoints,
+    const ValueType_t<TPrimitive> inRadius,
+    std::vector<typename SpatialHashGrid<TPrimitive, N>::PrimitiveIndex>& outPrimitivesIndices,
+    std::vector<std::size_t>& outOffsets,
+    const ParallelPolicy& inParallelPolicy)
+{
+  using PrimitiveIndex = typename SpatialHashGrid<TPrimitive, N>::PrimitiveIndex;
+
+  // Every thread appends (point index, primitive index) pairs to its own buffer, which are then grouped by point
+  const auto num_points = inPoints.GetNumberOfElements();
+  std::vector<std::vector<std::pair<std::size_t, PrimitiveIndex>>> per_thread_found_primitives(
+      std::max(inParallelPolicy.mNumThreads, static_cast<std::size_t>(1)));
+  ParallelFor(
+      inParallelPolicy,
+      num_points,
+      [&](const std::size_t inPointIndex, const std::size_t inThreadIndex) {
+        auto& found_primitives = per_thread_found_primitives[inThreadIndex];
+        inSpatialHashGrid.ForEachPrimitiveWithinRadius(inPoints.at(inPointIndex),
+            inRadius,
+            [&](const PrimitiveIndex inPrimitiveIndex) { found_primitives.emplace_back(inPointIndex, inPrimitiveIndex); });
+      },
+      64);
+
+  outOffsets.assign(num_points + 1, 0);
+  for (const auto& found_primitives : per_thread_found_primitives)
+  {
+    for (const auto& [point_index, primitive_index] : found_primitives) ++outOffsets[point_index + 1];
+  }
+  for (std::size_t i = 0; i < num_points; ++i) outOffsets[i + 1] += outOffsets[i];
+
+  outPrimitivesIndices.resize(outOffsets.back());
+  auto write_offsets = outOffsets;
+  for (const auto& found_primitives : per_thread_found_primitives)
+  {
+    for (const auto& [point_index, primitive_index] : found_primitives)
+      outPrimitivesIndices[write_offsets[point_index]++] = primitive_index;
+  }
+}
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <ez/AAHyperBox.h>
+#include <ez/ParallelPolicy.h>
+#include <array>
+#include <cstdint>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace ez
+{
+
+// Sort-and-sweep broadphase: keeps track of the pairs of overlapping boxes among a set of moving boxes (bodies).
+// Every axis keeps a list of the bodies min/max endpoints, sorted by insertion sort on Update. When bodies move a bit
+// between two updates the lists are almost sorted, so Update is close to O(n), and only the bodies whose endpoints
+// swap can start or stop overlapping. Boxes are closed: touching boxes overlap.
+// Big batches of new bodies (or the first Update) instead trigger a full sort and a sweep along the most spread axis.
+template <typename T, std::size_t N>
+class SweepAndPrune final
+{
+public:
+  using AAHyperBoxType = AAHyperBox<T, N>;
+  using BodyIndex = uint32_t;
+  using Pair = std::pair<BodyIndex, BodyIndex>; // Always with first < second
+
+  SweepAndPrune() = default;
+
+  // Bodies (and their removal) are taken into account at the next Update. Indices of removed bodies are reused.
+  BodyIndex AddBody(const AAHyperBoxType& inAAHyperBox);
+  bool RemoveBody(const BodyIndex inBodyIndex);
+  bool UpdateBody(const BodyIndex inBodyIndex, const AAHyperBoxType& inAAHyperBox);
+
+  // Updates the overlapping pairs with the current bodies, and the lists of pairs added and removed since the previous
+  // Update. The axes are sorted in parallel, and the full sweep (when needed) is spread across the policy threads.
+  void Update(const ParallelPolicy& inParallelPolicy = ParallelPolicy { 1 });
+
+  const std::vector<Pair>& GetAddedPairs() const { return mAddedPairs; }
+  const std::vector<Pair>& GetRemovedPairs() const { return mRemovedPairs; }
+  std::vector<Pair> GetOverlappingPairs() const; // Sorted
+
+  bool HasBody(const BodyIndex inBodyIndex) const;
+  const AAHyperBoxType& GetBody(const BodyIndex inBodyIndex) const;
+  std::size_t GetNumberOfBodies() const { return mNumBodies; }
+
+private:
+  struct Endpoint final
+  {
+    T mValue;
+    BodyIndex mBodyIndex;
+    bool mIsMin;
+  };
+
+  std::vector<AAHyperBoxType> mBodies;
+  std::vector<bool> mBodiesAlive;
+  std::vector<BodyIndex> mFreeBodiesIndices;
+  std::vector<BodyIndex> mBodiesToRemove; // Their endpoints are still in the lists until the next Update
+  std::size_t mNumBodies = 0;
+  std::size_t mNumBodiesToInsert = 0; // Their endpoints are at the end of the lists until the next Update
+  std::array<std::vector<Endpoint>, N> mEndpoints;
+  std::unordered_set<uint64_t> mOverlappingPairs;
+  std::vector<Pair> mAddedPairs;
+  std::vector<Pair> mRemovedPairs;
+
+  void RemovePendingBodies();
+  void UpdateIncremental(const ParallelPolicy& inParallelPolicy);
+  void UpdateFull(const ParallelPolicy& inParallelPolicy);
+  static bool Overlap(const AAHyperBoxType& inAAHyperBox0, const AAHyperBoxType& inAAHyperBox1);
+  static uint64_t MakePairKey(const BodyIndex inBodyIndex0, const BodyIndex inBodyIndex1);
+  static Pair MakePair(const uint64_t inPairKey);
+};
+}
+
+#include "ez/SweepAndPrune.tcc"
\ No newline at end of file
@@ -0,0 +1,328 @@
+#include <ez/Macros.h>
+#include <ez/MathCommon.h>
+#include <ez/MathInitializers.h>
+#include <ez/SweepAndPrune.h>
+#include <algorithm>
+#include <bit>
+#include <iterator>
+
+namespace ez
+{
+
+template <typename T, std::size_t N>
+typename SweepAndPrune<T, N>::BodyIndex SweepAndPrune<T, N>::AddBody(const AAHyperBoxType& inAAHyperBox)
+{
+  const auto reuse_free_body_index = !mFreeBodiesIndices.empty();
+  const auto body_index
+      = (reuse_free_body_index ? mFreeBodiesIndices.back() : static_cast<BodyIndex>(mBodies.size()));
+  if (reuse_free_body_index)
+  {
+    mFreeBodiesIndices.pop_back();
+    mBodies[body_index] = inAAHyperBox;
+    mBodiesAlive[body_index] = true;
+  }
+  else
+  {
+    mBodies.push_back(inAAHyperBox);
+    mBodiesAlive.push_back(true);
+  }
+
+  // Appended at the end, as if the body was not overlapping anything yet. Update sorts them into place.
+  for (std::size_t axis = 0; axis < N; ++axis)
+  {
+    mEndpoints[axis].push_back(Endpoint { inAAHyperBox.GetMin()[axis], body_index, true });
+    mEndpoints[axis].push_back(Endpoint { inAAHyperBox.GetMax()[axis], body_index, false });
+  }
+  ++mNumBodiesToInsert;
+  ++mNumBodies;
+  return body_index;
+}
+
+template <typename T, std::size_t N>
+bool SweepAndPrune<T, N>::RemoveBody(const BodyIndex inBodyIndex)
+{
+  if (!HasBody(inBodyIndex))
+    return false;
+
+  mBodiesAlive[inBodyIndex] = false;
+  mBodiesToRemove.push_back(inBodyIndex);
+  --mNumBodies;
+  return true;
+}
+
+template <typename T, std::size_t N>
+bool SweepAndPrune<T, N>::UpdateBody(const BodyIndex inBodyIndex, const AAHyperBoxType& inAAHyperBox)
+{
+  if (!HasBody(inBodyIndex))
+    return false;
+
+  mBodies[inBodyIndex] = inAAHyperBox;
+  return true;
+}
+
+template <typename T, std::size_t N>
+void SweepAndPrune<T, N>::Update(const ParallelPolicy& inParallelPolicy)
+{
+  mAddedPairs.clear();
+  mRemovedPairs.clear();
+  RemovePendingBodies();
+
+  // Inserting k bodies costs O(k * n) swaps, so past about log(n) new bodies sorting from scratch is cheaper
+  if (mNumBodiesToInsert > static_cast<std::size_t>(std::bit_width(mNumBodies)))
+    UpdateFull(inParallelPolicy);
+  else
+    UpdateIncremental(inParallelPolicy);
+  mNumBodiesToInsert = 0;
+}
+
+template <typename T, std::size_t N>
+std::vector<typename SweepAndPrune<T, N>::Pair> SweepAndPrune<T, N>::GetOverlappingPairs() const
+{
+  std::vector<Pair> overlapping_pairs;
+  overlapping_pairs.reserve(mOverlappingPairs.size());
+  for (const auto pair_key : mOverlappingPairs) overlapping_pairs.push_back(MakePair(pair_key));
+  std::sort(overlapping_pairs.begin(), overlapping_pairs.end());
+  return overlapping_pairs;
+}
+
+template <typename T, std::size_t N>
+bool SweepAndPrune<T, N>::HasBody(const BodyIndex inBodyIndex) const
+{
+  return inBodyIndex < mBodiesAlive.size() && mBodiesAlive[inBodyIndex];
+}
+
+template <typename T, std::size_t N>
+const typename SweepAndPrune<T, N>::AAHyperBoxType& SweepAndPrune<T, N>::GetBody(const BodyIndex inBodyIndex) const
+{
+  EXPECTS(HasBody(inBodyIndex));
+  return mBodies[inBodyIndex];
+}
+
+template <typename T, std::size_t N>
+void SweepAndPrune<T, N>::RemovePendingBodies()
+{
+  if (mBodiesToRemove.empty())
+    return;
+
+  for (auto& endpoints : mEndpoints)
+  {
+    std::erase_if(endpoints, [&](const Endpoint& inEndpoint) { return !mBodiesAlive[inEndpoint.mBodyIndex]; });
+  }
+
+  for (auto it = mOverlappingPairs.begin(); it != mOverlappingPairs.end();)
+  {
+    const auto pair = MakePair(*it);
+    if (mBodiesAlive[pair.first] && mBodiesAlive[pair.second])
+    {
+      ++it;
+      continue;
+    }
+
+    mRemovedPairs.push_back(pair);
+    it = mOverlappingPairs.erase(it);
+  }
+
+  // Only now that their endpoints are gone can the indices be reused
+  mFreeBodiesIndices.insert(mFreeBodiesIndices.end(), mBodiesToRemove.begin(), mBodiesToRemove.end());
+  mBodiesToRemove.clear();
+}
+
+template <typename T, std::size_t N>
+void SweepAndPrune<T, N>::UpdateIncremental(const ParallelPolicy& inParallelPolicy)
+{
+  // A pair can only start or stop overlapping if, on some axis, the min of one body and the max of the other swap.
+  // Axes are independent, so they are sorted in parallel, collecting the candidate pairs of their swaps.
+  std::array<std::vector<uint64_t>, N> per_axis_candidate_pairs_keys;
+  ParallelFor(
+      inParallelPolicy,
+      N,
+      [&](const std::size_t inAxis, const std::size_t) {
+        auto& endpoints = mEndpoints[inAxis];
+        auto& candidate_pairs_keys = per_axis_candidate_pairs_keys[inAxis];
+        for (auto& endpoint : endpoints)
+        {
+          const auto& body = mBodies[endpoint.mBodyIndex];
+          endpoint.mValue = (endpoint.mIsMin ? body.GetMin()[inAxis] : body.GetMax()[inAxis]);
+        }
+
+        for (std::size_t i = 1; i < endpoints.size(); ++i)
+        {
+          const auto endpoint = endpoints[i];
+          auto j = i;
+          for (; j > 0; --j)
+          {
+            const auto& previous_endpoint = endpoints[j - 1];
+            const auto is_before = (endpoint.mValue < previous_endpoint.mValue)
+                || (endpoint.mValue == previous_endpoint.mValue && endpoint.mIsMin && !previous_endpoint.mIsMin);
+            if (!is_before)
+              break;
+
+            // A min going before a max starts an overlap on this axis, which only matters if the boxes overlap on
+            // all the axes. A max going before a min stops it, and the pair may have to be removed.
+            const auto is_candidate_pair = (endpoint.mIsMin && !previous_endpoint.mIsMin)
+                ? Overlap(mBodies[endpoint.mBodyIndex], mBodies[previous_endpoint.mBodyIndex])
+                : (!endpoint.mIsMin && previous_endpoint.mIsMin);
+            if (is_candidate_pair && endpoint.mBodyIndex != previous_endpoint.mBodyIndex)
+              candidate_pairs_keys.push_back(MakePairKey(endpoint.mBodyIndex, previous_endpoint.mBodyIndex));
+            endpoints[j] = previous_endpoint;
+          }
+          endpoints[j] = endpoint;
+        }
+      },
+      1);
+
+  // The candidates are decided with the final boxes, so the order of the swaps does not matter
+  for (const auto& candidate_pairs_keys : per_axis_candidate_pairs_keys)
+  {
+    for (const auto pair_key : candidate_pairs_keys)
+    {
+      const auto pair = MakePair(pair_key);
+      if (Overlap(mBodies[pair.first], mBodies[pair.second]))
+      {
+        if (mOverlappingPairs.insert(pair_key).second)
+          mAddedPairs.push_back(pair);
+      }
+      else if (mOverlappingPairs.erase(pair_key) > 0)
+      {
+        mRemovedPairs.push_back(pair);
+      }
+    }
+  }
+}
+
+template <typename T, std::size_t N>
+void SweepAndPrune<T, N>::UpdateFull(const ParallelPolicy& inParallelPolicy)
+{
+  ParallelFor(
+      inParallelPolicy,
+      N,
+      [&](const std::size_t inAxis, const std::size_t) {
+        auto& endpoints = mEndpoints[inAxis];
+        for (auto& endpoint : endpoints)
+        {
+          const auto& body = mBodies[endpoint.mBodyIndex];
+          endpoint.mValue = (endpoint.mIsMin ? body.GetMin()[inAxis] : body.GetMax()[inAxis]);
+        }
+        std::sort(endpoints.begin(), endpoints.end(), [](const Endpoint& inLHS, const Endpoint& inRHS) {
+          return (inLHS.mValue < inRHS.mValue) || (inLHS.mValue == inRHS.mValue && inLHS.mIsMin && !inRHS.mIsMin);
+        });
+      },
+      1);
+
+  // Sweep along the axis where the body centers are the most spread, which has the fewest false overlaps
+  std::size_t sweep_axis = 0;
+  {
+    auto centers_sum = All<Vec<T, N>>(static_cast<T>(0));
+    auto centers_sq_sum = centers_sum;
+    for (BodyIndex body_index = 0; body_index < mBodies.size(); ++body_index)
+    {
+      if (!mBodiesAlive[body_index])
+        continue;
+
+      const auto center = mBodies[body_index].GetCenter();
+      centers_sum += center;
+      centers_sq_sum += center * center;
+    }
+
+    const auto num_bodies = static_cast<T>(std::max(mNumBodies, static_cast<std::size_t>(1)));
+    const auto centers_variance = centers_sq_sum / num_bodies - Sq(centers_sum / num_bodies);
+    for (std::size_t axis = 1; axis < N; ++axis)
+    {
+      if (centers_variance[axis] > centers_variance[sweep_axis])
+        sweep_axis = axis;
+    }
+  }
+
+  // Every body is tested against the ones whose min is between its min and max on the sweep axis. Bodies are
+  // independent, so they are spread across the policy threads. Boxes are copied in sweep order to test them
+  // sequentially in memory.
+  std::vector<BodyIndex> sorted_bodies_indices;
+  std::vector<AAHyperBoxType> sorted_bodies;
+  sorted_bodies_indices.reserve(mNumBodies);
+  sorted_bodies.reserve(mNumBodies);
+  for (const auto& endpoint : mEndpoints[sweep_axis])
+  {
+    if (!endpoint.mIsMin)
+      continue;
+
+    sorted_bodies_indices.push_back(endpoint.mBodyIndex);
+    sorted_bodies.push_back(mBodies[endpoint.mBodyIndex]);
+  }
+
+  std::vector<std::vector<uint64_t>> per_thread_pairs_keys(
+      std::max(inParallelPolicy.mNumThreads, static_cast<std::size_t>(1)));
+  ParallelFor(
+      inParallelPolicy,
+      sorted_bodies.size(),
+      [&](const std::size_t inSortedBodyIndex, const std::size_t inThreadIndex) {
+        const auto& body = sorted_bodies[inSortedBodyIndex];
+        const auto body_max = body.GetMax()[sweep_axis];
+        for (auto i = inSortedBodyIndex + 1; i < sorted_bodies.size(); ++i)
+        {
+          if (sorted_bodies[i].GetMin()[sweep_axis] > body_max)
+            break;
+
+          if (Overlap(body, sorted_bodies[i]))
+          {
+            per_thread_pairs_keys[inThreadIndex].push_back(
+                MakePairKey(sorted_bodies_indices[inSortedBodyIndex], sorted_bodies_indices[i]));
+          }
+        }
+      },
+      256);
+
+  std::vector<uint64_t> new_pairs_keys;
+  for (const auto& pairs_keys : per_thread_pairs_keys)
+    new_pairs_keys.insert(new_pairs_keys.end(), pairs_keys.begin(), pairs_keys.end());
+  std::sort(new_pairs_keys.begin(), new_pairs_keys.end());
+
+  std::vector<uint64_t> old_pairs_keys(mOverlappingPairs.begin(), mOverlappingPairs.end());
+  std::sort(old_pairs_keys.begin(), old_pairs_keys.end());
+
+  std::vector<uint64_t> changed_pairs_keys;
+  std::set_difference(new_pairs_keys.begin(),
+      new_pairs_keys.end(),
+      old_pairs_keys.begin(),
+      old_pairs_keys.end(),
+      std::back_inserter(changed_pairs_keys));
+  for (const auto pair_key : changed_pairs_keys) mAddedPairs.push_back(MakePair(pair_key));
+
+  changed_pairs_keys.clear();
+  std::set_difference(old_pairs_keys.begin(),
+      old_pairs_keys.end(),
+      new_pairs_keys.begin(),
+      new_pairs_keys.end(),
+      std::back_inserter(changed_pairs_keys));
+  for (const auto pair_key : changed_pairs_keys) mRemovedPairs.push_back(MakePair(pair_key));
+
+  mOverlappingPairs.clear();
+  mOverlappingPairs.reserve(new_pairs_keys.size());
+  mOverlappingPairs.insert(new_pairs_keys.begin(), new_pairs_keys.end());
+}
+
+template <typename T, std::size_t N>
+bool SweepAndPrune<T, N>::Overlap(const AAHyperBoxType& inAAHyperBox0, const AAHyperBoxType& inAAHyperBox1)
+{
+  for (std::size_t axis = 0; axis < N; ++axis)
+  {
+    if (inAAHyperBox0.GetMin()[axis] > inAAHyperBox1.GetMax()[axis]
+        || inAAHyperBox1.GetMin()[axis] > inAAHyperBox0.GetMax()[axis])
+      return false;
+  }
+  return true;
+}
+
+template <typename T, std::size_t N>
+uint64_t SweepAndPrune<T, N>::MakePairKey(const BodyIndex inBodyIndex0, const BodyIndex inBodyIndex1)
+{
+  const auto first_body_index = std::min(inBodyIndex0, inBodyIndex1);
+  const auto second_body_index = std::max(inBodyIndex0, inBodyIndex1);
+  return (static_cast<uint64_t>(first_body_index) << 32) | static_cast<uint64_t>(second_body_index);
+}
+
+template <typename T, std::size_t N>
+typename SweepAndPrune<T, N>::Pair SweepAndPrune<T, N>::MakePair(const uint64_t inPairKey)
+{
+  return Pair { static_cast<BodyIndex>(inPairKey >> 32), static_cast<BodyIndex>(inPairKey & 0xFFFFFFFFu) };
+}
+}
\ No newline at end of file
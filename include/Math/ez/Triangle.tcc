@@ -119,37 +119,19 @@ auto Intersect(const Triangle<T, N>& inTriangle, const Vec<T, N>& inPoint)
 template <EIntersectMode TIntersectMode, typename T, std::size_t N>
 auto Intersect(const Triangle<T, N>& inTriangle, const Line<T, N>& inLine)
 {
-  static_assert(TIntersectMode == EIntersectMode::ONLY_CHECK, "Unsupported EIntersectMode.");
+  static_assert(TIntersectMode == EIntersectMode::ALL_INTERSECTIONS || TIntersectMode == EIntersectMode::ONLY_CLOSEST
+          || TIntersectMode == EIntersectMode::ONLY_CHECK,
+      "Unsupported EIntersectMode.");
   return Intersect<TIntersectMode>(inLine, inTriangle);
 }
 
 template <EIntersectMode TIntersectMode, typename T, std::size_t N>
 auto Intersect(const Triangle<T, N>& inTriangle, const Ray<T, N>& inRay)
 {
-  static_assert(TIntersectMode == EIntersectMode::ONLY_CHECK, "Unsupported EIntersectMode.");
-  return Intersect<TIntersectMode>(inRay, inTriangle);
-  /*
   static_assert(TIntersectMode == EIntersectMode::ALL_INTERSECTIONS || TIntersectMode == EIntersectMode::ONLY_CLOSEST
           || TIntersectMode == EIntersectMode::ONLY_CHECK,
       "Unsupported EIntersectMode.");
-
-  const auto ray_plane_intersection_distance = IntersectClosest(inRay, GetPlane(inTriangle));
-  if (!ray_plane_intersection_distance)
-  {
-    if constexpr (TIntersectMode == EIntersectMode::ONLY_CHECK)
-      return false;
-    else
-      return std::optional<T>();
-  }
-
-  const auto ray_plane_intersection_point = inRay.GetPoint(*ray_plane_intersection_distance);
-  const auto barycentric_coordinates = BarycentricCoordinates(inTriangle, ray_plane_intersection_point);
-  const auto intersection_point_is_in_triangle = IsBetween(barycentric_coordinates, Zero<Vec3<T>>(), One<Vec3<T>>());
-  if constexpr (TIntersectMode == EIntersectMode::ONLY_CHECK)
-    return intersection_point_is_in_triangle;
-  else
-    return intersection_point_is_in_triangle ? ray_plane_intersection_distance : std::optional<T>();
-  */
+  return Intersect<TIntersectMode>(inRay, inTriangle);
 }
 
 template <EIntersectMode TIntersectMode, typename T, std::size_t N>
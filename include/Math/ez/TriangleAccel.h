@@ -0,0 +1,71 @@
+#pragma once
+
+#include <ez/AAHyperBox.h>
+#include <ez/IntersectMode.h>
+#include <ez/Line.h>
+#include <ez/MathForward.h>
+#include <ez/Ray.h>
+#include <ez/Triangle.h>
+#include <array>
+#include <optional>
+
+namespace ez
+{
+
+// 3D triangle with the edges and the (unnormalized) normal precomputed once, for static meshes that are intersected
+// many times. The line/ray tests only compute one cross product per test, instead of deriving the edges and two cross
+// products every time as with Triangle3. Usable as the primitive of hierarchies like Octree. The record is twice as
+// large as a Triangle3 (72 vs 36 bytes for floats), which offsets part of the gain in memory bound traversals.
+template <typename T>
+class TriangleAccel final
+{
+public:
+  using ValueType = T;
+  static constexpr auto NumComponents = 3;
+  static constexpr auto NumDimensions = 3;
+
+  TriangleAccel() = default;
+  explicit TriangleAccel(const Triangle3<T>& inTriangle);
+
+  typename std::array<Vec3<T>, 3>::const_iterator begin() const { return mTriangle.begin(); }
+  typename std::array<Vec3<T>, 3>::const_iterator end() const { return mTriangle.end(); }
+  typename std::array<Vec3<T>, 3>::const_iterator cbegin() const { return mTriangle.cbegin(); }
+  typename std::array<Vec3<T>, 3>::const_iterator cend() const { return mTriangle.cend(); }
+  std::size_t size() const { return mTriangle.size(); }
+
+  const Triangle3<T>& GetTriangle() const { return mTriangle; }
+  const Vec3<T>& GetEdge01() const { return mEdge01; }
+  const Vec3<T>& GetEdge02() const { return mEdge02; }
+  const Vec3<T>& GetScaledNormal() const { return mScaledNormal; } // Cross(edge01, edge02), length is twice the area
+
+  const Vec3<T>& operator[](const std::size_t inPointIndex) const { return mTriangle[inPointIndex]; }
+
+private:
+  Triangle3<T> mTriangle;
+  Vec3<T> mEdge01 = Zero<Vec3<T>>();
+  Vec3<T> mEdge02 = Zero<Vec3<T>>();
+  Vec3<T> mScaledNormal = Zero<Vec3<T>>();
+};
+
+template <typename T>
+Vec3<T> Normal(const TriangleAccel<T>& inTriangleAccel);
+
+// Intersect. Same results as the Möller-Trumbore Triangle3 versions, up to rounding.
+template <EIntersectMode TIntersectMode, typename T>
+auto Intersect(const Line3<T>& inLine, const TriangleAccel<T>& inTriangleAccel);
+
+template <EIntersectMode TIntersectMode, typename T>
+auto Intersect(const Ray3<T>& inRay, const TriangleAccel<T>& inTriangleAccel, const T& inMaxDistance = Infinity<T>());
+
+template <EIntersectMode TIntersectMode, typename T>
+auto Intersect(const TriangleAccel<T>& inTriangleAccel, const AAHyperBox<T, 3>& inAABox);
+
+template <EIntersectMode TIntersectMode, typename T>
+auto Intersect(const AAHyperBox<T, 3>& inAABox, const TriangleAccel<T>& inTriangleAccel);
+
+// Contains
+template <typename T>
+bool Contains(const AAHyperBox<T, 3>& inAABox, const TriangleAccel<T>& inTriangleAccel);
+}
+
+#include "ez/TriangleAccel.tcc"
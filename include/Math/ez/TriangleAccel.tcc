@@ -0,0 +1,102 @@
+#include <ez/TriangleAccel.h>
+
+namespace ez
+{
+
+template <typename T>
+TriangleAccel<T>::TriangleAccel(const Triangle3<T>& inTriangle)
+    : mTriangle { inTriangle },
+      mEdge01 { inTriangle[1] - inTriangle[0] },
+      mEdge02 { inTriangle[2] - inTriangle[0] },
+      mScaledNormal { Cross(mEdge01, mEdge02) }
+{
+}
+
+template <typename T>
+Vec3<T> Normal(const TriangleAccel<T>& inTriangleAccel)
+{
+  return NormalizedSafe(inTriangleAccel.GetScaledNormal());
+}
+
+namespace triangle_accel_detail
+{
+  // Möller-Trumbore rewritten with the scalar triple products around the precomputed normal:
+  // origin + t * direction = point0 + u * edge01 + v * edge02, solved with Cramer's rule.
+  template <typename T>
+  std::optional<T>
+  IntersectLine(const Vec3<T>& inOrigin, const Vec3<T>& inDirection, const TriangleAccel<T>& inTriangleAccel)
+  {
+    const auto determinant = -Dot(inDirection, inTriangleAccel.GetScaledNormal());
+    if (determinant == static_cast<T>(0)) // Parallel to the triangle plane
+      return std::nullopt;
+
+    const auto determinant_inverse = (static_cast<T>(1) / determinant);
+    const auto origin_from_point0 = inOrigin - inTriangleAccel[0];
+    const auto q = Cross(origin_from_point0, inDirection);
+    const auto u = Dot(inTriangleAccel.GetEdge02(), q) * determinant_inverse;
+    if (u < static_cast<T>(0) || u > static_cast<T>(1))
+      return std::nullopt;
+
+    const auto v = -Dot(inTriangleAccel.GetEdge01(), q) * determinant_inverse;
+    if (v < static_cast<T>(0) || u + v > static_cast<T>(1))
+      return std::nullopt;
+
+    return std::make_optional(Dot(origin_from_point0, inTriangleAccel.GetScaledNormal()) * determinant_inverse);
+  }
+}
+
+template <EIntersectMode TIntersectMode, typename T>
+auto Intersect(const Line3<T>& inLine, const TriangleAccel<T>& inTriangleAccel)
+{
+  static_assert(TIntersectMode == EIntersectMode::ALL_INTERSECTIONS || TIntersectMode == EIntersectMode::ONLY_CLOSEST
+          || TIntersectMode == EIntersectMode::ONLY_CHECK,
+      "Unsupported EIntersectMode.");
+
+  const auto intersection
+      = triangle_accel_detail::IntersectLine(inLine.GetOrigin(), Direction(inLine), inTriangleAccel);
+  if constexpr (TIntersectMode == EIntersectMode::ALL_INTERSECTIONS)
+    return std::array { intersection };
+  else if constexpr (TIntersectMode == EIntersectMode::ONLY_CLOSEST)
+    return intersection;
+  else if constexpr (TIntersectMode == EIntersectMode::ONLY_CHECK)
+    return intersection.has_value();
+}
+
+template <EIntersectMode TIntersectMode, typename T>
+auto Intersect(const Ray3<T>& inRay, const TriangleAccel<T>& inTriangleAccel, const T& inMaxDistance)
+{
+  static_assert(TIntersectMode == EIntersectMode::ALL_INTERSECTIONS || TIntersectMode == EIntersectMode::ONLY_CLOSEST
+          || TIntersectMode == EIntersectMode::ONLY_CHECK,
+      "Unsupported EIntersectMode.");
+
+  constexpr auto Epsilon = static_cast<T>(1e-7);
+  auto intersection = triangle_accel_detail::IntersectLine(inRay.GetOrigin(), Direction(inRay), inTriangleAccel);
+  if (intersection && (*intersection < Epsilon || *intersection > inMaxDistance))
+    intersection = std::nullopt;
+
+  if constexpr (TIntersectMode == EIntersectMode::ALL_INTERSECTIONS)
+    return std::array { intersection };
+  else if constexpr (TIntersectMode == EIntersectMode::ONLY_CLOSEST)
+    return intersection;
+  else if constexpr (TIntersectMode == EIntersectMode::ONLY_CHECK)
+    return intersection.has_value();
+}
+
+template <EIntersectMode TIntersectMode, typename T>
+auto Intersect(const TriangleAccel<T>& inTriangleAccel, const AAHyperBox<T, 3>& inAABox)
+{
+  return Intersect<TIntersectMode>(inAABox, inTriangleAccel.GetTriangle());
+}
+
+template <EIntersectMode TIntersectMode, typename T>
+auto Intersect(const AAHyperBox<T, 3>& inAABox, const TriangleAccel<T>& inTriangleAccel)
+{
+  return Intersect<TIntersectMode>(inAABox, inTriangleAccel.GetTriangle());
+}
+
+template <typename T>
+bool Contains(const AAHyperBox<T, 3>& inAABox, const TriangleAccel<T>& inTriangleAccel)
+{
+  return Contains(inAABox, inTriangleAccel.GetTriangle());
+}
+}
@@ -6,6 +6,7 @@
 #include <ez/MathTypeTraits.h>
 #include <ez/VariadicRepeat.h>
 #include <ez/VecPart.h>
+#include <ez/VecSIMD.h>
 #include <array>
 #include <cstdint>
 #include <initializer_list>
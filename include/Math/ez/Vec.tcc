@@ -1,7 +1,9 @@
 #include <ez/MathCommon.h>
 #include <ez/MathInitializers.h>
 #include <ez/Vec.h>
+#include <ez/VecSIMD.h>
 #include <cmath>
+#include <type_traits>
 
 namespace ez
 {
@@ -181,6 +183,12 @@ constexpr const T& Vec<T, N>::operator[](std::size_t i) const
 template <typename T, std::size_t N>
 constexpr Vec<T, N> Vec<T, N>::operator+(const Vec<T, N>& inRHS) const
 {
+  if constexpr (vec_simd_detail::IsSIMDVec_v<Vec>)
+  {
+    if (!std::is_constant_evaluated())
+      return vec_simd_detail::Add(*this, inRHS);
+  }
+
   Vec<T, N> result {};
   for (std::size_t i = 0; i < N; ++i) { result[i] = mComponents[i] + inRHS[i]; }
   return result;
@@ -189,6 +197,12 @@ constexpr Vec<T, N> Vec<T, N>::operator+(const Vec<T, N>& inRHS) const
 template <typename T, std::size_t N>
 constexpr Vec<T, N> Vec<T, N>::operator-(const Vec& inRHS) const
 {
+  if constexpr (vec_simd_detail::IsSIMDVec_v<Vec>)
+  {
+    if (!std::is_constant_evaluated())
+      return vec_simd_detail::Subtract(*this, inRHS);
+  }
+
   Vec<T, N> result {};
   for (std::size_t i = 0; i < N; ++i) { result[i] = mComponents[i] - inRHS[i]; }
   return result;
@@ -197,6 +211,12 @@ constexpr Vec<T, N> Vec<T, N>::operator-(const Vec& inRHS) const
 template <typename T, std::size_t N>
 constexpr Vec<T, N> Vec<T, N>::operator*(const Vec& inRHS) const
 {
+  if constexpr (vec_simd_detail::IsSIMDVec_v<Vec>)
+  {
+    if (!std::is_constant_evaluated())
+      return vec_simd_detail::Multiply(*this, inRHS);
+  }
+
   Vec<T, N> result {};
   for (std::size_t i = 0; i < N; ++i) { result[i] = mComponents[i] * inRHS[i]; }
   return result;
@@ -205,6 +225,12 @@ constexpr Vec<T, N> Vec<T, N>::operator*(const Vec& inRHS) const
 template <typename T, std::size_t N>
 constexpr Vec<T, N> Vec<T, N>::operator/(const Vec& inRHS) const
 {
+  if constexpr (vec_simd_detail::IsSIMDVec_v<Vec>)
+  {
+    if (!std::is_constant_evaluated())
+      return vec_simd_detail::Divide(*this, inRHS);
+  }
+
   Vec<T, N> result {};
   for (std::size_t i = 0; i < N; ++i) { result[i] = mComponents[i] / inRHS[i]; }
   return result;
@@ -213,6 +239,12 @@ constexpr Vec<T, N> Vec<T, N>::operator/(const Vec& inRHS) const
 template <typename T, std::size_t N>
 constexpr Vec<T, N> Vec<T, N>::operator+(const T& inRHS) const
 {
+  if constexpr (vec_simd_detail::IsSIMDVec_v<Vec>)
+  {
+    if (!std::is_constant_evaluated())
+      return vec_simd_detail::Add(*this, inRHS);
+  }
+
   Vec<T, N> result {};
   for (std::size_t i = 0; i < N; ++i) { result[i] = mComponents[i] + inRHS; }
   return result;
@@ -221,6 +253,12 @@ constexpr Vec<T, N> Vec<T, N>::operator+(const T& inRHS) const
 template <typename T, std::size_t N>
 constexpr Vec<T, N> Vec<T, N>::operator-(const T& inRHS) const
 {
+  if constexpr (vec_simd_detail::IsSIMDVec_v<Vec>)
+  {
+    if (!std::is_constant_evaluated())
+      return vec_simd_detail::Subtract(*this, inRHS);
+  }
+
   Vec<T, N> result {};
   for (std::size_t i = 0; i < N; ++i) { result[i] = mComponents[i] - inRHS; }
   return result;
@@ -229,6 +267,12 @@ constexpr Vec<T, N> Vec<T, N>::operator-(const T& inRHS) const
 template <typename T, std::size_t N>
 constexpr Vec<T, N> Vec<T, N>::operator*(const T& inRHS) const
 {
+  if constexpr (vec_simd_detail::IsSIMDVec_v<Vec>)
+  {
+    if (!std::is_constant_evaluated())
+      return vec_simd_detail::Multiply(*this, inRHS);
+  }
+
   Vec<T, N> result {};
   for (std::size_t i = 0; i < N; ++i) { result[i] = mComponents[i] * inRHS; }
   return result;
@@ -237,6 +281,12 @@ constexpr Vec<T, N> Vec<T, N>::operator*(const T& inRHS) const
 template <typename T, std::size_t N>
 constexpr Vec<T, N> Vec<T, N>::operator/(const T& inRHS) const
 {
+  if constexpr (vec_simd_detail::IsSIMDVec_v<Vec>)
+  {
+    if (!std::is_constant_evaluated())
+      return vec_simd_detail::Divide(*this, inRHS);
+  }
+
   Vec<T, N> result {};
   for (std::size_t i = 0; i < N; ++i) { result[i] = mComponents[i] / inRHS; }
   return result;
@@ -245,6 +295,12 @@ constexpr Vec<T, N> Vec<T, N>::operator/(const T& inRHS) const
 template <typename T, std::size_t N>
 constexpr Vec<T, N> Vec<T, N>::operator-() const
 {
+  if constexpr (vec_simd_detail::IsSIMDVec_v<Vec>)
+  {
+    if (!std::is_constant_evaluated())
+      return vec_simd_detail::Negated(*this);
+  }
+
   Vec<T, N> result {};
   for (std::size_t i = 0; i < N; ++i) { result[i] = -mComponents[i]; }
   return result;
@@ -374,6 +430,12 @@ constexpr Vec2<T> Perpendicular(const Vec2<T>& inVector)
 template <typename T>
 constexpr Vec3<T> Cross(const Vec3<T>& inLHS, const Vec3<T>& inRHS)
 {
+  if constexpr (vec_simd_detail::IsSIMDVec_v<Vec3<T>>)
+  {
+    if (!std::is_constant_evaluated())
+      return vec_simd_detail::Cross(inLHS, inRHS);
+  }
+
   return Vec3<T> { inLHS[1] * inRHS[2] - inLHS[2] * inRHS[1],
     inLHS[2] * inRHS[0] - inLHS[0] * inRHS[2],
     inLHS[0] * inRHS[1] - inLHS[1] * inRHS[0] };
@@ -0,0 +1,395 @@
+#pragma once
+
+#include <ez/MathForward.h>
+#include <array>
+#include <cstddef>
+
+// Opt-in (EZ_MATH_SIMD=1, or the EZMATH_SIMD CMake option) SSE/AVX/NEON kernels for the arithmetic of Vec<float, 3/4>
+// and Vec<double, 2/4>. Vec keeps its std::array storage (same size and layout, loads are unaligned). The kernels give
+// the same results as the scalar loops only if the compiler does not contract those into FMAs (-ffp-contract=off; GCC
+// contracts by default as soon as FMA is available, e.g. with -march=native): the lane-wise operations are the same
+// IEEE operations, Min/Max keep the std::min/std::max operands order, and Dot adds the products in the same order.
+// With contraction, the results agree within rounding. The NEON kernels have not been compiled on an ARM target.
+#if defined(EZ_MATH_SIMD) && EZ_MATH_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#define EZ_VEC_SIMD_SSE 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define EZ_VEC_SIMD_NEON 1
+#endif
+#endif
+
+#ifndef EZ_VEC_SIMD_SSE
+#define EZ_VEC_SIMD_SSE 0
+#endif
+#ifndef EZ_VEC_SIMD_NEON
+#define EZ_VEC_SIMD_NEON 0
+#endif
+
+namespace ez
+{
+namespace vec_simd_detail
+{
+#if EZ_VEC_SIMD_SSE
+  struct Float4Pack
+  {
+    using ValueType = float;
+    using Register = __m128;
+    static constexpr std::size_t Width = 4;
+
+    static Register Load(const float* inData) { return _mm_loadu_ps(inData); }
+    static void Store(float* outData, const Register inRegister) { _mm_storeu_ps(outData, inRegister); }
+    static Register Splat(const float inValue) { return _mm_set1_ps(inValue); }
+    static Register Add(const Register inLHS, const Register inRHS) { return _mm_add_ps(inLHS, inRHS); }
+    static Register Subtract(const Register inLHS, const Register inRHS) { return _mm_sub_ps(inLHS, inRHS); }
+    static Register Multiply(const Register inLHS, const Register inRHS) { return _mm_mul_ps(inLHS, inRHS); }
+    static Register Divide(const Register inLHS, const Register inRHS) { return _mm_div_ps(inLHS, inRHS); }
+    static Register Min(const Register inLHS, const Register inRHS) { return _mm_min_ps(inRHS, inLHS); }
+    static Register Max(const Register inLHS, const Register inRHS) { return _mm_max_ps(inRHS, inLHS); }
+    static Register Abs(const Register inValue) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), inValue); }
+    static Register Negated(const Register inValue) { return _mm_xor_ps(_mm_set1_ps(-0.0f), inValue); }
+
+    // 3 components in the first lanes, 1 in the last one (so that divisions do not raise spurious FP flags)
+    static Register Load3(const float* inData) { return _mm_setr_ps(inData[0], inData[1], inData[2], 1.0f); }
+    static void Store3(float* outData, const Register inRegister)
+    {
+      _mm_storel_pi(reinterpret_cast<__m64*>(outData), inRegister);
+      _mm_store_ss(outData + 2, _mm_movehl_ps(inRegister, inRegister));
+    }
+    static Register YZX(const Register inValue) { return _mm_shuffle_ps(inValue, inValue, _MM_SHUFFLE(3, 0, 2, 1)); }
+  };
+
+  struct Double2Pack
+  {
+    using ValueType = double;
+    using Register = __m128d;
+    static constexpr std::size_t Width = 2;
+
+    static Register Load(const double* inData) { return _mm_loadu_pd(inData); }
+    static void Store(double* outData, const Register inRegister) { _mm_storeu_pd(outData, inRegister); }
+    static Register Splat(const double inValue) { return _mm_set1_pd(inValue); }
+    static Register Add(const Register inLHS, const Register inRHS) { return _mm_add_pd(inLHS, inRHS); }
+    static Register Subtract(const Register inLHS, const Register inRHS) { return _mm_sub_pd(inLHS, inRHS); }
+    static Register Multiply(const Register inLHS, const Register inRHS) { return _mm_mul_pd(inLHS, inRHS); }
+    static Register Divide(const Register inLHS, const Register inRHS) { return _mm_div_pd(inLHS, inRHS); }
+    static Register Min(const Register inLHS, const Register inRHS) { return _mm_min_pd(inRHS, inLHS); }
+    static Register Max(const Register inLHS, const Register inRHS) { return _mm_max_pd(inRHS, inLHS); }
+    static Register Abs(const Register inValue) { return _mm_andnot_pd(_mm_set1_pd(-0.0), inValue); }
+    static Register Negated(const Register inValue) { return _mm_xor_pd(_mm_set1_pd(-0.0), inValue); }
+  };
+
+#if defined(__AVX__)
+  struct Double4Pack
+  {
+    using ValueType = double;
+    using Register = __m256d;
+    static constexpr std::size_t Width = 4;
+
+    static Register Load(const double* inData) { return _mm256_loadu_pd(inData); }
+    static void Store(double* outData, const Register inRegister) { _mm256_storeu_pd(outData, inRegister); }
+    static Register Splat(const double inValue) { return _mm256_set1_pd(inValue); }
+    static Register Add(const Register inLHS, const Register inRHS) { return _mm256_add_pd(inLHS, inRHS); }
+    static Register Subtract(const Register inLHS, const Register inRHS) { return _mm256_sub_pd(inLHS, inRHS); }
+    static Register Multiply(const Register inLHS, const Register inRHS) { return _mm256_mul_pd(inLHS, inRHS); }
+    static Register Divide(const Register inLHS, const Register inRHS) { return _mm256_div_pd(inLHS, inRHS); }
+    static Register Min(const Register inLHS, const Register inRHS) { return _mm256_min_pd(inRHS, inLHS); }
+    static Register Max(const Register inLHS, const Register inRHS) { return _mm256_max_pd(inRHS, inLHS); }
+    static Register Abs(const Register inValue) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), inValue); }
+    static Register Negated(const Register inValue) { return _mm256_xor_pd(_mm256_set1_pd(-0.0), inValue); }
+  };
+#define EZ_VEC_SIMD_HAS_DOUBLE4_PACK 1
+#endif
+#endif
+
+#if EZ_VEC_SIMD_NEON
+  struct Float4Pack
+  {
+    using ValueType = float;
+    using Register = float32x4_t;
+    static constexpr std::size_t Width = 4;
+
+    static Register Load(const float* inData) { return vld1q_f32(inData); }
+    static void Store(float* outData, const Register inRegister) { vst1q_f32(outData, inRegister); }
+    static Register Splat(const float inValue) { return vdupq_n_f32(inValue); }
+    static Register Add(const Register inLHS, const Register inRHS) { return vaddq_f32(inLHS, inRHS); }
+    static Register Subtract(const Register inLHS, const Register inRHS) { return vsubq_f32(inLHS, inRHS); }
+    static Register Multiply(const Register inLHS, const Register inRHS) { return vmulq_f32(inLHS, inRHS); }
+    static Register Divide(const Register inLHS, const Register inRHS) { return vdivq_f32(inLHS, inRHS); }
+    static Register Min(const Register inLHS, const Register inRHS)
+    {
+      return vbslq_f32(vcltq_f32(inRHS, inLHS), inRHS, inLHS);
+    }
+    static Register Max(const Register inLHS, const Register inRHS)
+    {
+      return vbslq_f32(vcltq_f32(inLHS, inRHS), inRHS, inLHS);
+    }
+    static Register Abs(const Register inValue) { return vabsq_f32(inValue); }
+    static Register Negated(const Register inValue) { return vnegq_f32(inValue); }
+
+    // 3 components in the first lanes, 1 in the last one (so that divisions do not raise spurious FP flags)
+    static Register Load3(const float* inData)
+    {
+      return vsetq_lane_f32(inData[2], vcombine_f32(vld1_f32(inData), vdup_n_f32(1.0f)), 2);
+    }
+    static void Store3(float* outData, const Register inRegister)
+    {
+      vst1_f32(outData, vget_low_f32(inRegister));
+      vst1q_lane_f32(outData + 2, inRegister, 2);
+    }
+    static Register YZX(const Register inValue)
+    {
+      const auto yzwx = vextq_f32(inValue, inValue, 1);
+      return vcombine_f32(vget_low_f32(yzwx), vrev64_f32(vget_high_f32(yzwx)));
+    }
+  };
+
+  struct Double2Pack
+  {
+    using ValueType = double;
+    using Register = float64x2_t;
+    static constexpr std::size_t Width = 2;
+
+    static Register Load(const double* inData) { return vld1q_f64(inData); }
+    static void Store(double* outData, const Register inRegister) { vst1q_f64(outData, inRegister); }
+    static Register Splat(const double inValue) { return vdupq_n_f64(inValue); }
+    static Register Add(const Register inLHS, const Register inRHS) { return vaddq_f64(inLHS, inRHS); }
+    static Register Subtract(const Register inLHS, const Register inRHS) { return vsubq_f64(inLHS, inRHS); }
+    static Register Multiply(const Register inLHS, const Register inRHS) { return vmulq_f64(inLHS, inRHS); }
+    static Register Divide(const Register inLHS, const Register inRHS) { return vdivq_f64(inLHS, inRHS); }
+    static Register Min(const Register inLHS, const Register inRHS)
+    {
+      return vbslq_f64(vcltq_f64(inRHS, inLHS), inRHS, inLHS);
+    }
+    static Register Max(const Register inLHS, const Register inRHS)
+    {
+      return vbslq_f64(vcltq_f64(inLHS, inRHS), inRHS, inLHS);
+    }
+    static Register Abs(const Register inValue) { return vabsq_f64(inValue); }
+    static Register Negated(const Register inValue) { return vnegq_f64(inValue); }
+  };
+#endif
+
+#if EZ_VEC_SIMD_SSE || EZ_VEC_SIMD_NEON
+#ifndef EZ_VEC_SIMD_HAS_DOUBLE4_PACK
+  // Two double2 registers where there are no 256-bit registers
+  struct Double4Pack
+  {
+    using ValueType = double;
+    struct Register
+    {
+      Double2Pack::Register mLow;
+      Double2Pack::Register mHigh;
+    };
+    static constexpr std::size_t Width = 4;
+
+    template <typename TOperation>
+    static Register Applied(const Register inLHS, const Register inRHS, const TOperation& inOperation)
+    {
+      return Register { inOperation(inLHS.mLow, inRHS.mLow), inOperation(inLHS.mHigh, inRHS.mHigh) };
+    }
+
+    static Register Load(const double* inData)
+    {
+      return Register { Double2Pack::Load(inData), Double2Pack::Load(inData + 2) };
+    }
+    static void Store(double* outData, const Register inRegister)
+    {
+      Double2Pack::Store(outData, inRegister.mLow);
+      Double2Pack::Store(outData + 2, inRegister.mHigh);
+    }
+    static Register Splat(const double inValue)
+    {
+      return Register { Double2Pack::Splat(inValue), Double2Pack::Splat(inValue) };
+    }
+    static Register Add(const Register inLHS, const Register inRHS) { return Applied(inLHS, inRHS, Double2Pack::Add); }
+    static Register Subtract(const Register inLHS, const Register inRHS)
+    {
+      return Applied(inLHS, inRHS, Double2Pack::Subtract);
+    }
+    static Register Multiply(const Register inLHS, const Register inRHS)
+    {
+      return Applied(inLHS, inRHS, Double2Pack::Multiply);
+    }
+    static Register Divide(const Register inLHS, const Register inRHS)
+    {
+      return Applied(inLHS, inRHS, Double2Pack::Divide);
+    }
+    static Register Min(const Register inLHS, const Register inRHS) { return Applied(inLHS, inRHS, Double2Pack::Min); }
+    static Register Max(const Register inLHS, const Register inRHS) { return Applied(inLHS, inRHS, Double2Pack::Max); }
+    static Register Abs(const Register inValue)
+    {
+      return Register { Double2Pack::Abs(inValue.mLow), Double2Pack::Abs(inValue.mHigh) };
+    }
+    static Register Negated(const Register inValue)
+    {
+      return Register { Double2Pack::Negated(inValue.mLow), Double2Pack::Negated(inValue.mHigh) };
+    }
+  };
+#endif
+#endif
+
+  // Pack used by each Vec<T, N>, with the loads/stores of its N components
+  template <typename T, std::size_t N>
+  struct VecPack
+  {
+    static constexpr bool Enabled = false;
+  };
+
+#if EZ_VEC_SIMD_SSE || EZ_VEC_SIMD_NEON
+  template <>
+  struct VecPack<float, 3> : Float4Pack
+  {
+    static constexpr bool Enabled = true;
+    static Register LoadVec(const float* inData) { return Load3(inData); }
+    static void StoreVec(float* outData, const Register inRegister) { Store3(outData, inRegister); }
+  };
+
+  template <>
+  struct VecPack<float, 4> : Float4Pack
+  {
+    static constexpr bool Enabled = true;
+    static Register LoadVec(const float* inData) { return Load(inData); }
+    static void StoreVec(float* outData, const Register inRegister) { Store(outData, inRegister); }
+  };
+
+  template <>
+  struct VecPack<double, 2> : Double2Pack
+  {
+    static constexpr bool Enabled = true;
+    static Register LoadVec(const double* inData) { return Load(inData); }
+    static void StoreVec(double* outData, const Register inRegister) { Store(outData, inRegister); }
+  };
+
+  template <>
+  struct VecPack<double, 4> : Double4Pack
+  {
+    static constexpr bool Enabled = true;
+    static Register LoadVec(const double* inData) { return Load(inData); }
+    static void StoreVec(double* outData, const Register inRegister) { Store(outData, inRegister); }
+  };
+#endif
+
+  template <typename T>
+  inline constexpr bool IsSIMDVec_v = false;
+
+  template <typename T, std::size_t N>
+  inline constexpr bool IsSIMDVec_v<Vec<T, N>> = VecPack<T, N>::Enabled;
+
+  template <typename T, std::size_t N>
+  auto LoadOperand(const Vec<T, N>& inVec)
+  {
+    return VecPack<T, N>::LoadVec(inVec.Data());
+  }
+
+  template <typename T, std::size_t N>
+  auto LoadOperand(const Vec<T, N>&, const T& inValue)
+  {
+    return VecPack<T, N>::Splat(inValue);
+  }
+
+  template <typename T, std::size_t N, typename TRegister>
+  Vec<T, N> MakeVec(const TRegister inRegister)
+  {
+    Vec<T, N> vec;
+    VecPack<T, N>::StoreVec(vec.Data(), inRegister);
+    return vec;
+  }
+
+  template <typename T, std::size_t N>
+  Vec<T, N> Add(const Vec<T, N>& inLHS, const Vec<T, N>& inRHS)
+  {
+    return MakeVec<T, N>(VecPack<T, N>::Add(LoadOperand(inLHS), LoadOperand(inRHS)));
+  }
+
+  template <typename T, std::size_t N>
+  Vec<T, N> Add(const Vec<T, N>& inLHS, const T& inRHS)
+  {
+    return MakeVec<T, N>(VecPack<T, N>::Add(LoadOperand(inLHS), LoadOperand(inLHS, inRHS)));
+  }
+
+  template <typename T, std::size_t N>
+  Vec<T, N> Subtract(const Vec<T, N>& inLHS, const Vec<T, N>& inRHS)
+  {
+    return MakeVec<T, N>(VecPack<T, N>::Subtract(LoadOperand(inLHS), LoadOperand(inRHS)));
+  }
+
+  template <typename T, std::size_t N>
+  Vec<T, N> Subtract(const Vec<T, N>& inLHS, const T& inRHS)
+  {
+    return MakeVec<T, N>(VecPack<T, N>::Subtract(LoadOperand(inLHS), LoadOperand(inLHS, inRHS)));
+  }
+
+  template <typename T, std::size_t N>
+  Vec<T, N> Multiply(const Vec<T, N>& inLHS, const Vec<T, N>& inRHS)
+  {
+    return MakeVec<T, N>(VecPack<T, N>::Multiply(LoadOperand(inLHS), LoadOperand(inRHS)));
+  }
+
+  template <typename T, std::size_t N>
+  Vec<T, N> Multiply(const Vec<T, N>& inLHS, const T& inRHS)
+  {
+    return MakeVec<T, N>(VecPack<T, N>::Multiply(LoadOperand(inLHS), LoadOperand(inLHS, inRHS)));
+  }
+
+  template <typename T, std::size_t N>
+  Vec<T, N> Divide(const Vec<T, N>& inLHS, const Vec<T, N>& inRHS)
+  {
+    return MakeVec<T, N>(VecPack<T, N>::Divide(LoadOperand(inLHS), LoadOperand(inRHS)));
+  }
+
+  template <typename T, std::size_t N>
+  Vec<T, N> Divide(const Vec<T, N>& inLHS, const T& inRHS)
+  {
+    return MakeVec<T, N>(VecPack<T, N>::Divide(LoadOperand(inLHS), LoadOperand(inLHS, inRHS)));
+  }
+
+  template <typename T, std::size_t N>
+  Vec<T, N> Min(const Vec<T, N>& inLHS, const Vec<T, N>& inRHS)
+  {
+    return MakeVec<T, N>(VecPack<T, N>::Min(LoadOperand(inLHS), LoadOperand(inRHS)));
+  }
+
+  template <typename T, std::size_t N>
+  Vec<T, N> Max(const Vec<T, N>& inLHS, const Vec<T, N>& inRHS)
+  {
+    return MakeVec<T, N>(VecPack<T, N>::Max(LoadOperand(inLHS), LoadOperand(inRHS)));
+  }
+
+  template <typename T, std::size_t N>
+  Vec<T, N> Abs(const Vec<T, N>& inValue)
+  {
+    return MakeVec<T, N>(VecPack<T, N>::Abs(LoadOperand(inValue)));
+  }
+
+  template <typename T, std::size_t N>
+  Vec<T, N> Negated(const Vec<T, N>& inValue)
+  {
+    return MakeVec<T, N>(VecPack<T, N>::Negated(LoadOperand(inValue)));
+  }
+
+  // Products in the registers, then added in the components order like the scalar loop
+  template <typename T, std::size_t N>
+  T Dot(const Vec<T, N>& inLHS, const Vec<T, N>& inRHS)
+  {
+    using Pack = VecPack<T, N>;
+    std::array<T, Pack::Width> products;
+    Pack::Store(products.data(), Pack::Multiply(LoadOperand(inLHS), LoadOperand(inRHS)));
+
+    auto dot = static_cast<T>(0);
+    for (std::size_t i = 0; i < N; ++i) { dot += products[i]; }
+    return dot;
+  }
+
+  template <typename T>
+  Vec3<T> Cross(const Vec3<T>& inLHS, const Vec3<T>& inRHS)
+  {
+    using Pack = VecPack<T, 3>;
+    const auto lhs = LoadOperand(inLHS);
+    const auto rhs = LoadOperand(inRHS);
+    const auto crossed_zxy
+        = Pack::Subtract(Pack::Multiply(lhs, Pack::YZX(rhs)), Pack::Multiply(Pack::YZX(lhs), rhs));
+    return MakeVec<T, 3>(Pack::YZX(crossed_zxy));
+  }
+}
+}